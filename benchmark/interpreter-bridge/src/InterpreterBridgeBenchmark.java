@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+public class InterpreterBridgeBenchmark {
+    public void timeCallInts(int count) {
+        int sum = 0;
+        for (int i = 0; i < count; ++i) {
+            sum += $noinline$ints(i, 1, 2, 3, 4, 5, 6, 7, 8, 9);
+        }
+        intResult = sum;
+    }
+
+    public void timeCallLongs(int count) {
+        long sum = 0;
+        for (int i = 0; i < count; ++i) {
+            sum += $noinline$longs(i, 1L, 2L, 3L, 4L, 5L, 6L, 7L, 8L, 9L);
+        }
+        longResult = sum;
+    }
+
+    public void timeCallDoubles(int count) {
+        double sum = 0;
+        for (int i = 0; i < count; ++i) {
+            sum += $noinline$doubles(i, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0);
+        }
+        doubleResult = sum;
+    }
+
+    public void timeCallMixed(int count) {
+        long sum = 0;
+        for (int i = 0; i < count; ++i) {
+            sum += $noinline$mixed(i, 1L, 2.0f, 3.0, this, 5, 6L, 7.0f, 8.0, object);
+        }
+        longResult = sum;
+    }
+
+    public void timeCallReferences(int count) {
+        Object o = object;
+        int sum = 0;
+        for (int i = 0; i < count; ++i) {
+            sum += $noinline$references(this, o, o, o, o, o, o, o, o, o);
+        }
+        intResult = sum;
+    }
+
+    // Baseline for the cost of the transition itself.
+    public void timeCallNoArguments(int count) {
+        int sum = 0;
+        for (int i = 0; i < count; ++i) {
+            sum += $noinline$noArguments();
+        }
+        intResult = sum;
+    }
+
+    private static int $noinline$ints(
+            int a0, int a1, int a2, int a3, int a4, int a5, int a6, int a7, int a8, int a9) {
+        return a0 + a9;
+    }
+
+    private static long $noinline$longs(
+            long a0, long a1, long a2, long a3, long a4,
+            long a5, long a6, long a7, long a8, long a9) {
+        return a0 + a9;
+    }
+
+    private static double $noinline$doubles(
+            double a0, double a1, double a2, double a3, double a4,
+            double a5, double a6, double a7, double a8, double a9) {
+        return a0 + a9;
+    }
+
+    private static long $noinline$mixed(
+            int a0, long a1, float a2, double a3, Object a4,
+            int a5, long a6, float a7, double a8, Object a9) {
+        return a0 + a6;
+    }
+
+    private int $noinline$references(
+            Object a0, Object a1, Object a2, Object a3, Object a4,
+            Object a5, Object a6, Object a7, Object a8, Object a9) {
+        return (a0 == a9) ? 1 : 0;
+    }
+
+    private static int $noinline$noArguments() {
+        return 1;
+    }
+
+    public Object object = new Object();
+
+    public static int intResult;
+    public static long longResult;
+    public static double doubleResult;
+}
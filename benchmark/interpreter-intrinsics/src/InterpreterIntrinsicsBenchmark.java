@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import java.lang.ref.WeakReference;
+import java.util.concurrent.atomic.AtomicInteger;
+import java.util.concurrent.atomic.AtomicLong;
+
+public class InterpreterIntrinsicsBenchmark {
+    public void timeArrayCopyChar(int count) {
+        char[] src = chars;
+        char[] dst = charsCopy;
+        for (int i = 0; i < count; ++i) {
+            System.arraycopy(src, 0, dst, 0, src.length);
+        }
+    }
+
+    public void timeArrayCopyCharLoop(int count) {
+        char[] src = chars;
+        char[] dst = charsCopy;
+        for (int i = 0; i < count; ++i) {
+            $noinline$copy(src, dst);
+        }
+    }
+
+    public void timeArrayCopyObject(int count) {
+        Object[] src = objects;
+        Object[] dst = objectsCopy;
+        for (int i = 0; i < count; ++i) {
+            System.arraycopy(src, 0, dst, 0, src.length);
+        }
+    }
+
+    public void timeArrayCopyObjectLoop(int count) {
+        Object[] src = objects;
+        Object[] dst = objectsCopy;
+        for (int i = 0; i < count; ++i) {
+            $noinline$copy(src, dst);
+        }
+    }
+
+    public void timeStringEquals(int count) {
+        String s1 = string36;
+        String s2 = string36Copy;
+        int sum = 0;
+        for (int i = 0; i < count; ++i) {
+            if (s1.equals(s2)) {
+                ++sum;
+            }
+        }
+        result = sum;
+    }
+
+    public void timeStringEqualsLoop(int count) {
+        String s1 = string36;
+        String s2 = string36Copy;
+        int sum = 0;
+        for (int i = 0; i < count; ++i) {
+            if ($noinline$equals(s1, s2)) {
+                ++sum;
+            }
+        }
+        result = sum;
+    }
+
+    public void timeStringIndexOf(int count) {
+        String s = string36;
+        int sum = 0;
+        for (int i = 0; i < count; ++i) {
+            sum += s.indexOf('Z');
+        }
+        result = sum;
+    }
+
+    public void timeStringIndexOfLoop(int count) {
+        String s = string36;
+        int sum = 0;
+        for (int i = 0; i < count; ++i) {
+            sum += $noinline$indexOf(s, 'Z');
+        }
+        result = sum;
+    }
+
+    public void timeAtomicIntegerCompareAndSet(int count) {
+        AtomicInteger atomic = atomicInteger;
+        for (int i = 0; i < count; ++i) {
+            atomic.compareAndSet(i, i + 1);
+        }
+    }
+
+    public void timeAtomicLongCompareAndSet(int count) {
+        AtomicLong atomic = atomicLong;
+        for (int i = 0; i < count; ++i) {
+            atomic.compareAndSet(i, i + 1);
+        }
+    }
+
+    public void timeSynchronizedCompareAndSet(int count) {
+        for (int i = 0; i < count; ++i) {
+            $noinline$compareAndSet(i, i + 1);
+        }
+    }
+
+    public void timeReferenceGet(int count) {
+        WeakReference<Object> ref = reference;
+        int sum = 0;
+        for (int i = 0; i < count; ++i) {
+            if (ref.get() != null) {
+                ++sum;
+            }
+        }
+        result = sum;
+    }
+
+    public void timeFieldGet(int count) {
+        int sum = 0;
+        for (int i = 0; i < count; ++i) {
+            if ($noinline$get() != null) {
+                ++sum;
+            }
+        }
+        result = sum;
+    }
+
+    private static void $noinline$copy(char[] src, char[] dst) {
+        for (int i = 0; i < src.length; ++i) {
+            dst[i] = src[i];
+        }
+    }
+
+    private static void $noinline$copy(Object[] src, Object[] dst) {
+        for (int i = 0; i < src.length; ++i) {
+            dst[i] = src[i];
+        }
+    }
+
+    private static boolean $noinline$equals(String s1, String s2) {
+        if (s1.length() != s2.length()) {
+            return false;
+        }
+        for (int i = 0; i < s1.length(); ++i) {
+            if (s1.charAt(i) != s2.charAt(i)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    private static int $noinline$indexOf(String s, char c) {
+        for (int i = 0; i < s.length(); ++i) {
+            if (s.charAt(i) == c) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    private synchronized boolean $noinline$compareAndSet(int expected, int value) {
+        if (intValue != expected) {
+            return false;
+        }
+        intValue = value;
+        return true;
+    }
+
+    private Object $noinline$get() {
+        return referent;
+    }
+
+    public static final String string36 = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";  // length = 36
+    public static final String string36Copy = new String(string36.toCharArray());
+
+    public static char[] chars = new char[64];
+    public static char[] charsCopy = new char[64];
+    public static Object[] objects = new Object[64];
+    public static Object[] objectsCopy = new Object[64];
+
+    public AtomicInteger atomicInteger = new AtomicInteger();
+    public AtomicLong atomicLong = new AtomicLong();
+    public int intValue;
+
+    public Object referent = new Object();
+    public WeakReference<Object> reference = new WeakReference<>(referent);
+
+    public static int result;
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+public class InterpreterInvokeBenchmark {
+    public void timeInvokeMoveResult(int count) {
+        int sum = 0;
+        for (int i = 0; i < count; ++i) {
+            sum += $noinline$int(i);
+        }
+        intResult = sum;
+    }
+
+    public void timeInvokeMoveResultWide(int count) {
+        long sum = 0;
+        for (int i = 0; i < count; ++i) {
+            sum += $noinline$long(i);
+        }
+        longResult = sum;
+    }
+
+    public void timeInvokeMoveResultObject(int count) {
+        Object o = null;
+        for (int i = 0; i < count; ++i) {
+            o = $noinline$object();
+        }
+        objectResult = o;
+    }
+
+    public void timeInvokeVirtualMoveResult(int count) {
+        int sum = 0;
+        for (int i = 0; i < count; ++i) {
+            sum += $noinline$virtualInt(i);
+        }
+        intResult = sum;
+    }
+
+    // Baseline for an invoke that is not followed by a move-result.
+    public void timeInvokeNoResult(int count) {
+        for (int i = 0; i < count; ++i) {
+            $noinline$void(i);
+        }
+    }
+
+    private static int $noinline$int(int i) {
+        return i;
+    }
+
+    private static long $noinline$long(int i) {
+        return i;
+    }
+
+    private Object $noinline$object() {
+        return object;
+    }
+
+    public int $noinline$virtualInt(int i) {
+        return i;
+    }
+
+    private static void $noinline$void(int i) {
+    }
+
+    public Object object = new Object();
+
+    public static int intResult;
+    public static long longResult;
+    public static Object objectResult;
+}
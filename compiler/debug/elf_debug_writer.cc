@@ -109,6 +109,9 @@ void WriteDebugInfo(ElfBuilder<ElfTypes>* builder,
   }
 }
 
+// Size of the independently compressed blocks of the mini-debug-info of oat files.
+static constexpr size_t kMiniDebugInfoBlockSize = 256 * KB;
+
 template <typename ElfTypes>
 static std::vector<uint8_t> MakeMiniDebugInfoInternal(
     InstructionSet isa,
@@ -117,7 +120,8 @@ static std::vector<uint8_t> MakeMiniDebugInfoInternal(
     size_t text_section_size,
     typename ElfTypes::Addr dex_section_address,
     size_t dex_section_size,
-    const DebugInfo& debug_info) {
+    const DebugInfo& debug_info,
+    size_t num_threads) {
   std::vector<uint8_t> buffer;
   buffer.reserve(KB);
   VectorOutputStream out("Mini-debug-info ELF file", &buffer);
@@ -140,7 +144,13 @@ static std::vector<uint8_t> MakeMiniDebugInfoInternal(
   CHECK(builder->Good());
   std::vector<uint8_t> compressed_buffer;
   compressed_buffer.reserve(buffer.size() / 4);
-  XzCompress(ArrayRef<const uint8_t>(buffer), &compressed_buffer);
+  // Compress in independent blocks, which is faster for large oat files since the blocks
+  // are compressed in parallel, and lets tools decompress only the blocks they need.
+  XzCompress(ArrayRef<const uint8_t>(buffer),
+             &compressed_buffer,
+             /* level= */ 1,
+             kMiniDebugInfoBlockSize,
+             num_threads);
   return compressed_buffer;
 }
 
@@ -151,7 +161,8 @@ std::vector<uint8_t> MakeMiniDebugInfo(
     size_t text_section_size,
     uint64_t dex_section_address,
     size_t dex_section_size,
-    const DebugInfo& debug_info) {
+    const DebugInfo& debug_info,
+    size_t num_threads) {
   if (Is64BitInstructionSet(isa)) {
     return MakeMiniDebugInfoInternal<ElfTypes64>(isa,
                                                  features,
@@ -159,7 +170,8 @@ std::vector<uint8_t> MakeMiniDebugInfo(
                                                  text_section_size,
                                                  dex_section_address,
                                                  dex_section_size,
-                                                 debug_info);
+                                                 debug_info,
+                                                 num_threads);
   } else {
     return MakeMiniDebugInfoInternal<ElfTypes32>(isa,
                                                  features,
@@ -167,7 +179,8 @@ std::vector<uint8_t> MakeMiniDebugInfo(
                                                  text_section_size,
                                                  dex_section_address,
                                                  dex_section_size,
-                                                 debug_info);
+                                                 debug_info,
+                                                 num_threads);
   }
 }
 
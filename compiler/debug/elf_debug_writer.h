@@ -40,6 +40,7 @@ void WriteDebugInfo(
     ElfBuilder<ElfTypes>* builder,
     const DebugInfo& debug_info);
 
+// Compresses the mini-debug-info on up to `num_threads` threads, including the calling thread.
 std::vector<uint8_t> MakeMiniDebugInfo(
     InstructionSet isa,
     const InstructionSetFeatures* features,
@@ -47,7 +48,8 @@ std::vector<uint8_t> MakeMiniDebugInfo(
     size_t text_section_size,
     uint64_t dex_section_address,
     size_t dex_section_size,
-    const DebugInfo& debug_info);
+    const DebugInfo& debug_info,
+    size_t num_threads);
 
 std::vector<uint8_t> MakeElfFileForJIT(
     InstructionSet isa,
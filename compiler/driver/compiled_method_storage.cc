@@ -179,6 +179,12 @@ const LengthPrefixedArray<uint8_t>* CompiledMethodStorage::DeduplicateCode(
   return AllocateOrDeduplicateArray(code, &dedupe_code_);
 }
 
+void CompiledMethodStorage::ReleaseSwapPages() {
+  if (swap_space_ != nullptr) {
+    swap_space_->ReleaseResidentPages();
+  }
+}
+
 void CompiledMethodStorage::ReleaseCode(const LengthPrefixedArray<uint8_t>* code) {
   ReleaseArrayIfNotDeduplicated(code);
 }
@@ -51,6 +51,10 @@ class CompiledMethodStorage {
     return SwapAllocator<void>(swap_space_.get());
   }
 
+  // Drops the pages holding compiled methods from memory if they are backed by a swap file.
+  // Used once a batch of methods has been compiled or written out to limit the peak RSS.
+  void ReleaseSwapPages();
+
   const LengthPrefixedArray<uint8_t>* DeduplicateCode(const ArrayRef<const uint8_t>& code);
   void ReleaseCode(const LengthPrefixedArray<uint8_t>* code);
 
@@ -101,13 +105,16 @@ class CompiledMethodStorage {
   template <typename T>
   class LengthPrefixedArrayAlloc;
 
+  // Enough shards to keep lock contention low when compiling with many threads.
+  static constexpr size_t kDedupeShards = 16u;
+
   template <typename T>
   using ArrayDedupeSet = DedupeSet<ArrayRef<const T>,
                                    LengthPrefixedArray<T>,
                                    LengthPrefixedArrayAlloc<T>,
                                    size_t,
                                    DedupeHashFunc<const T>,
-                                   4>;
+                                   kDedupeShards>;
 
   // Swap pool and allocator used for native allocations. May be file-backed. Needs to be first
   // as other fields rely on this.
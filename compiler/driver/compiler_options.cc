@@ -80,6 +80,8 @@ CompilerOptions::CompilerOptions()
       resolve_startup_const_strings_(false),
       check_profiled_methods_(ProfileMethodsCheck::kNone),
       max_image_block_size_(std::numeric_limits<uint32_t>::max()),
+      method_compile_time_budget_ms_(0u),
+      method_memory_budget_(0u),
       register_allocation_strategy_(RegisterAllocator::kRegisterAllocatorDefault),
       passes_to_run_(nullptr) {
 }
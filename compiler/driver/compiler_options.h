@@ -364,6 +364,16 @@ class CompilerOptions final {
     max_image_block_size_ = size;
   }
 
+  // Budget of time and arena memory for the optimized compilation of a single method, zero
+  // if unlimited. A method exceeding it is compiled again without optimizations.
+  uint32_t GetMethodCompileTimeBudgetMs() const {
+    return method_compile_time_budget_ms_;
+  }
+
+  uint32_t GetMethodMemoryBudget() const {
+    return method_memory_budget_;
+  }
+
   // Is `boot_image_filename` the name of a core image (small boot
   // image used for ART testing only)?
   static bool IsCoreImageFilename(const std::string& boot_image_filename);
@@ -456,6 +466,10 @@ class CompilerOptions final {
   // Maximum solid block size in the generated image.
   uint32_t max_image_block_size_;
 
+  // Per-method compilation budgets, zero if unlimited.
+  uint32_t method_compile_time_budget_ms_;
+  uint32_t method_memory_budget_;
+
   RegisterAllocator::Strategy register_allocation_strategy_;
 
   // If not null, specifies optimization passes which will be run instead of defaults.
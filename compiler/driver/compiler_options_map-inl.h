@@ -85,6 +85,8 @@ inline bool ReadCompilerOptions(Base& map, CompilerOptions* options, std::string
     options->check_profiled_methods_ = *map.Get(Base::CheckProfiledMethods);
   }
   map.AssignIfExists(Base::MaxImageBlockSize, &options->max_image_block_size_);
+  map.AssignIfExists(Base::MethodCompileTimeBudgetMs, &options->method_compile_time_budget_ms_);
+  map.AssignIfExists(Base::MethodMemoryBudget, &options->method_memory_budget_);
 
   if (map.Exists(Base::DumpTimings)) {
     options->dump_timings_ = true;
@@ -206,7 +208,14 @@ inline void AddCompilerOptionsArgumentParserOptions(Builder& b) {
 
       .Define("--max-image-block-size=_")
           .template WithType<unsigned int>()
-          .IntoKey(Map::MaxImageBlockSize);
+          .IntoKey(Map::MaxImageBlockSize)
+
+      .Define("--method-compile-time-budget-ms=_")
+          .template WithType<unsigned int>()
+          .IntoKey(Map::MethodCompileTimeBudgetMs)
+      .Define("--method-memory-budget=_")
+          .template WithType<unsigned int>()
+          .IntoKey(Map::MethodMemoryBudget);
 }
 
 #pragma GCC diagnostic pop
@@ -491,6 +491,7 @@ class HGraphVisualizerPrinter : public HGraphDelegateVisitor {
   void VisitInvokePolymorphic(HInvokePolymorphic* invoke) override {
     VisitInvoke(invoke);
     StartAttributeStream("invoke_type") << "InvokePolymorphic";
+    StartAttributeStream("intrinsic") << invoke->GetIntrinsic();
   }
 
   void VisitInstanceFieldGet(HInstanceFieldGet* iget) override {
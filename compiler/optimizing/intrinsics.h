@@ -18,6 +18,7 @@
 #define ART_COMPILER_OPTIMIZING_INTRINSICS_H_
 
 #include "code_generator.h"
+#include "data_type-inl.h"
 #include "nodes.h"
 #include "optimization.h"
 #include "parallel_move_resolver.h"
@@ -297,8 +298,6 @@ UNREACHABLE_INTRINSIC(Arch, VarHandleCompareAndExchange)        \
 UNREACHABLE_INTRINSIC(Arch, VarHandleCompareAndExchangeAcquire) \
 UNREACHABLE_INTRINSIC(Arch, VarHandleCompareAndExchangeRelease) \
 UNREACHABLE_INTRINSIC(Arch, VarHandleCompareAndSet)             \
-UNREACHABLE_INTRINSIC(Arch, VarHandleGet)                       \
-UNREACHABLE_INTRINSIC(Arch, VarHandleGetAcquire)                \
 UNREACHABLE_INTRINSIC(Arch, VarHandleGetAndAdd)                 \
 UNREACHABLE_INTRINSIC(Arch, VarHandleGetAndAddAcquire)          \
 UNREACHABLE_INTRINSIC(Arch, VarHandleGetAndAddRelease)          \
@@ -314,12 +313,6 @@ UNREACHABLE_INTRINSIC(Arch, VarHandleGetAndBitwiseXorRelease)   \
 UNREACHABLE_INTRINSIC(Arch, VarHandleGetAndSet)                 \
 UNREACHABLE_INTRINSIC(Arch, VarHandleGetAndSetAcquire)          \
 UNREACHABLE_INTRINSIC(Arch, VarHandleGetAndSetRelease)          \
-UNREACHABLE_INTRINSIC(Arch, VarHandleGetOpaque)                 \
-UNREACHABLE_INTRINSIC(Arch, VarHandleGetVolatile)               \
-UNREACHABLE_INTRINSIC(Arch, VarHandleSet)                       \
-UNREACHABLE_INTRINSIC(Arch, VarHandleSetOpaque)                 \
-UNREACHABLE_INTRINSIC(Arch, VarHandleSetRelease)                \
-UNREACHABLE_INTRINSIC(Arch, VarHandleSetVolatile)               \
 UNREACHABLE_INTRINSIC(Arch, VarHandleWeakCompareAndSet)         \
 UNREACHABLE_INTRINSIC(Arch, VarHandleWeakCompareAndSetAcquire)  \
 UNREACHABLE_INTRINSIC(Arch, VarHandleWeakCompareAndSetPlain)    \
@@ -343,6 +336,88 @@ bool IsCallFreeIntrinsic(HInvoke* invoke, Codegenerator* codegen) {
   return false;
 }
 
+// Returns whether `invoke` is a VarHandle get access (get, getAcquire, getOpaque or
+// getVolatile) as opposed to a VarHandle set access.
+static inline bool IsVarHandleGet(HInvoke* invoke) {
+  switch (invoke->GetIntrinsic()) {
+    case Intrinsics::kVarHandleGet:
+    case Intrinsics::kVarHandleGetAcquire:
+    case Intrinsics::kVarHandleGetOpaque:
+    case Intrinsics::kVarHandleGetVolatile:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns the shorty character of the argument `index` of a polymorphic invoke, or of its
+// return type for index 0, as declared by the call site. We cannot use the type of the input
+// instead, as constant arguments of sub-int types are represented by int constants.
+static inline char GetShortyCharacter(HInvoke* invoke, uint32_t index) {
+  DCHECK(invoke->IsInvokePolymorphic());
+  HInvokePolymorphic* invoke_polymorphic = invoke->AsInvokePolymorphic();
+  const char* shorty = invoke_polymorphic->GetDexFile().GetShorty(
+      invoke_polymorphic->GetProtoIndex());
+  DCHECK_LT(index, strlen(shorty));
+  return shorty[index];
+}
+
+static inline DataType::Type GetDataTypeFromShorty(HInvoke* invoke, uint32_t index) {
+  return DataType::FromShorty(GetShortyCharacter(invoke, index));
+}
+
+// Returns the number of coordinates of a VarHandle get or set access: 0 for static fields,
+// 1 for instance fields and 2 for array elements and byte array or buffer views.
+static inline size_t GetExpectedVarHandleCoordinatesCount(HInvoke* invoke) {
+  // The first argument is the VarHandle and a set access has one value argument.
+  size_t number_of_arguments = invoke->GetNumberOfArguments();
+  DCHECK_GE(number_of_arguments, IsVarHandleGet(invoke) ? 1u : 2u);
+  return number_of_arguments - (IsVarHandleGet(invoke) ? 1u : 2u);
+}
+
+// Returns the shorty index of the variable of a VarHandle get or set access,
+// i.e. the return type of a get or the type of the value of a set.
+static inline uint32_t GetVarHandleValueShortyIndex(HInvoke* invoke) {
+  return IsVarHandleGet(invoke) ? 0u : invoke->GetNumberOfArguments() - 1u;
+}
+
+static inline DataType::Type GetVarHandleExpectedValueType(HInvoke* invoke) {
+  return GetDataTypeFromShorty(invoke, GetVarHandleValueShortyIndex(invoke));
+}
+
+// Returns the primitive type that the `varType` of the VarHandle must have
+// for the access to proceed without conversions.
+static inline Primitive::Type GetVarHandleExpectedPrimitiveType(HInvoke* invoke) {
+  return Primitive::GetType(GetShortyCharacter(invoke, GetVarHandleValueShortyIndex(invoke)));
+}
+
+// Returns whether the intrinsic code generators can emit a fast path for a VarHandle get or
+// set access. The fast path handles static and instance fields accessed with the exact type
+// of the variable; everything else (array elements, views, conversions) as well as the cases
+// where the checks of the fast path fail at runtime go through the runtime call.
+static inline bool HasVarHandleFieldAccessFastPath(HInvoke* invoke) {
+  if (kEmitCompilerReadBarrier && !kUseBakerReadBarrier) {
+    return false;  // Only Baker read barriers are supported.
+  }
+  if (invoke->GetNumberOfArguments() < (IsVarHandleGet(invoke) ? 1u : 2u)) {
+    return false;  // Missing value argument, let the runtime throw.
+  }
+  size_t expected_coordinates_count = GetExpectedVarHandleCoordinatesCount(invoke);
+  if (expected_coordinates_count > 1u) {
+    // Array elements and views are not supported. An array element access would need a bounds
+    // check and, for reference stores, an array store check; a byte array or buffer view would
+    // also need alignment checks and byte swapping.
+    return false;
+  }
+  if (expected_coordinates_count == 1u &&
+      GetDataTypeFromShorty(invoke, /* index= */ 1u) != DataType::Type::kReference) {
+    return false;  // The instance field holder must be a reference.
+  }
+  // A get whose result is discarded by the call site has a void return type,
+  // which needs a conversion handled by the runtime.
+  return GetVarHandleExpectedValueType(invoke) != DataType::Type::kVoid;
+}
+
 }  // namespace art
 
 #endif  // ART_COMPILER_OPTIMIZING_INTRINSICS_H_
@@ -17,6 +17,7 @@
 #include "intrinsics_arm64.h"
 
 #include "arch/arm64/instruction_set_features_arm64.h"
+#include "art_field.h"
 #include "art_method.h"
 #include "code_generator_arm64.h"
 #include "common_arm64.h"
@@ -28,6 +29,7 @@
 #include "mirror/object_array-inl.h"
 #include "mirror/reference.h"
 #include "mirror/string-inl.h"
+#include "mirror/var_handle.h"
 #include "scoped_thread_state_change-inl.h"
 #include "thread-current-inl.h"
 #include "utils/arm64/assembler_arm64.h"
@@ -45,6 +47,7 @@ namespace art {
 
 namespace arm64 {
 
+using helpers::CPURegisterFrom;
 using helpers::DRegisterFrom;
 using helpers::FPRegisterFrom;
 using helpers::HeapOperand;
@@ -127,9 +130,12 @@ class IntrinsicSlowPathARM64 : public SlowPathCodeARM64 {
       if (invoke_->IsInvokeStaticOrDirect()) {
         codegen->GenerateStaticOrDirectCall(
             invoke_->AsInvokeStaticOrDirect(), LocationFrom(kArtMethodRegister), this);
-      } else {
+      } else if (invoke_->IsInvokeVirtual()) {
         codegen->GenerateVirtualCall(
             invoke_->AsInvokeVirtual(), LocationFrom(kArtMethodRegister), this);
+      } else {
+        DCHECK(invoke_->IsInvokePolymorphic());
+        codegen->GenerateInvokePolymorphicCall(invoke_->AsInvokePolymorphic(), this);
       }
     }
 
@@ -3169,6 +3175,313 @@ void IntrinsicCodeGeneratorARM64::VisitCRC32UpdateByteBuffer(HInvoke* invoke) {
   GenerateCodeForCalculationCRC32ValueOfBytes(masm, crc, ptr, length, out);
 }
 
+// Generate subtype check without read barriers: branch to `slow_path` unless the class
+// of the non-null `object` is `klass` or one of its subclasses. Comparing references
+// without read barriers can only yield false negatives, which are handled by `slow_path`.
+static void GenerateSubTypeObjectCheckNoReadBarrier(CodeGeneratorARM64* codegen,
+                                                    SlowPathCodeARM64* slow_path,
+                                                    Register object,
+                                                    Register klass,
+                                                    Register temp) {
+  MacroAssembler* masm = codegen->GetVIXLAssembler();
+  const uint32_t class_offset = mirror::Object::ClassOffset().Uint32Value();
+  const uint32_t super_class_offset = mirror::Class::SuperClassOffset().Uint32Value();
+  vixl::aarch64::Label loop, success;
+
+  // /* HeapReference<Class> */ temp = object->klass_
+  __ Ldr(temp, HeapOperand(object, class_offset));
+  codegen->GetAssembler()->MaybeUnpoisonHeapReference(temp);
+  __ Bind(&loop);
+  __ Cmp(temp, klass);
+  __ B(eq, &success);
+  // /* HeapReference<Class> */ temp = temp->super_class_
+  __ Ldr(temp, HeapOperand(temp, super_class_offset));
+  codegen->GetAssembler()->MaybeUnpoisonHeapReference(temp);
+  __ Cbnz(temp, &loop);
+  __ B(slow_path->GetEntryLabel());
+  __ Bind(&success);
+}
+
+static void CreateVarHandleFieldAccessLocations(HInvoke* invoke) {
+  if (!HasVarHandleFieldAccessFastPath(invoke)) {
+    return;
+  }
+
+  ArenaAllocator* allocator = invoke->GetBlock()->GetGraph()->GetAllocator();
+  LocationSummary* locations =
+      new (allocator) LocationSummary(invoke, LocationSummary::kCallOnSlowPath, kIntrinsified);
+  // The VarHandle, the holder object of an instance field and the value of a set.
+  for (size_t i = 0, e = invoke->GetNumberOfArguments(); i != e; ++i) {
+    locations->SetInAt(i, DataType::IsFloatingPointType(invoke->InputAt(i)->GetType())
+                              ? Location::RequiresFpuRegister()
+                              : Location::RequiresRegister());
+  }
+  // Temporaries for the ArtField* and then the field offset, and for the type checks and
+  // then the declaring class of a static field.
+  locations->AddTemp(Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresRegister());
+
+  DataType::Type value_type = GetVarHandleExpectedValueType(invoke);
+  if (IsVarHandleGet(invoke)) {
+    if (DataType::IsFloatingPointType(value_type)) {
+      locations->SetOut(Location::RequiresFpuRegister());
+    } else {
+      // The output is written by the Baker read barrier marking code
+      // while the inputs are still needed, so it must not overlap them.
+      locations->SetOut(Location::RequiresRegister(), Location::kOutputOverlap);
+    }
+  } else if (value_type == DataType::Type::kReference && kPoisonHeapReferences) {
+    // Temporary for heap reference poisoning. We cannot use a scratch register
+    // as StoreRelease() needs one for the address computation.
+    locations->AddTemp(Location::RequiresRegister());
+  }
+}
+
+// Emit the checks guarding the fast path of a VarHandle field access and compute the
+// address of the field: the holder object (or declaring class) and the field offset
+// in the first temporary. Returns the register holding the holder object.
+static Register GenerateVarHandleFieldAccessChecksAndTarget(HInvoke* invoke,
+                                                            CodeGeneratorARM64* codegen,
+                                                            SlowPathCodeARM64* slow_path) {
+  MacroAssembler* masm = codegen->GetVIXLAssembler();
+  LocationSummary* locations = invoke->GetLocations();
+  Register varhandle = InputRegisterAt(invoke, 0);
+  Register temp = WRegisterFrom(locations->GetTemp(0));
+  Register temp2 = WRegisterFrom(locations->GetTemp(1));
+  size_t expected_coordinates_count = GetExpectedVarHandleCoordinatesCount(invoke);
+  Primitive::Type primitive_type = GetVarHandleExpectedPrimitiveType(invoke);
+
+  const MemberOffset access_modes_bit_mask_offset =
+      mirror::VarHandle::AccessModesBitMaskOffset();
+  const MemberOffset var_type_offset = mirror::VarHandle::VarTypeOffset();
+  const MemberOffset coordinate_type0_offset = mirror::VarHandle::CoordinateType0Offset();
+  const MemberOffset coordinate_type1_offset = mirror::VarHandle::CoordinateType1Offset();
+  const MemberOffset primitive_type_offset = mirror::Class::PrimitiveTypeOffset();
+
+  // Check that the access mode is supported by the VarHandle.
+  mirror::VarHandle::AccessMode access_mode =
+      mirror::VarHandle::GetAccessModeByIntrinsic(invoke->GetIntrinsic());
+  __ Ldr(temp2, HeapOperand(varhandle, access_modes_bit_mask_offset));
+  __ Tbz(temp2, static_cast<uint32_t>(access_mode), slow_path->GetEntryLabel());
+
+  // Check that the variable type is the one used by the call site. The primitive type
+  // does not depend on the to-space or from-space copy of the class, so we do not need
+  // a read barrier for `varType`.
+  // /* HeapReference<Class> */ temp = varhandle->var_type_
+  __ Ldr(temp, HeapOperand(varhandle, var_type_offset));
+  codegen->GetAssembler()->MaybeUnpoisonHeapReference(temp);
+  __ Ldrh(temp2, HeapOperand(temp, primitive_type_offset));
+  __ Cmp(temp2, static_cast<uint16_t>(primitive_type));
+  __ B(ne, slow_path->GetEntryLabel());
+
+  if (!IsVarHandleGet(invoke) && primitive_type == Primitive::kPrimNot) {
+    // Check that the new value is null or an instance of `varType`.
+    Register value = InputRegisterAt(invoke, invoke->GetNumberOfArguments() - 1u);
+    vixl::aarch64::Label value_is_null;
+    __ Cbz(value, &value_is_null);
+    GenerateSubTypeObjectCheckNoReadBarrier(codegen, slow_path, value, temp, temp2);
+    __ Bind(&value_is_null);
+  }
+
+  if (expected_coordinates_count == 0u) {
+    // A static field VarHandle has no coordinates.
+    __ Ldr(temp2, HeapOperand(varhandle, coordinate_type0_offset));
+    __ Cbnz(temp2, slow_path->GetEntryLabel());
+  } else {
+    DCHECK_EQ(expected_coordinates_count, 1u);
+    Register object = InputRegisterAt(invoke, 1);
+    // Let the runtime throw the NullPointerException.
+    __ Cbz(object, slow_path->GetEntryLabel());
+    // An instance field VarHandle has exactly one coordinate. This also
+    // rejects array element VarHandles and byte array or buffer views.
+    __ Ldr(temp2, HeapOperand(varhandle, coordinate_type1_offset));
+    __ Cbnz(temp2, slow_path->GetEntryLabel());
+    // Check that the object is an instance of the declaring class of the field.
+    // /* HeapReference<Class> */ temp = varhandle->coordinate_type0_
+    __ Ldr(temp, HeapOperand(varhandle, coordinate_type0_offset));
+    codegen->GetAssembler()->MaybeUnpoisonHeapReference(temp);
+    GenerateSubTypeObjectCheckNoReadBarrier(codegen, slow_path, object, temp, temp2);
+  }
+
+  // All checks passed, this is a FieldVarHandle. Load the ArtField* and the offset.
+  // /* ArtField* */ temp = varhandle->art_field_
+  __ Ldr(temp.X(), HeapOperand(varhandle, mirror::FieldVarHandle::ArtFieldOffset()));
+  Register target;
+  if (expected_coordinates_count == 0u) {
+    // The declaring class of a static field is the holder object. The runtime accessor
+    // does not check that the class is initialized, so neither do we.
+    // /* GcRoot<mirror::Class> */ temp2 = temp->declaring_class_
+    codegen->GenerateGcRootFieldLoad(invoke,
+                                     LocationFrom(temp2),
+                                     temp.X(),
+                                     ArtField::DeclaringClassOffset().Uint32Value(),
+                                     /* fixup_label= */ nullptr,
+                                     kCompilerReadBarrierOption);
+    target = temp2;
+  } else {
+    target = InputRegisterAt(invoke, 1);
+  }
+  // /* uint32_t */ temp = temp->offset_
+  __ Ldr(temp, MemOperand(temp.X(), ArtField::OffsetOffset().Int32Value()));
+  return target;
+}
+
+static void GenerateVarHandleGet(HInvoke* invoke, CodeGeneratorARM64* codegen) {
+  MacroAssembler* masm = codegen->GetVIXLAssembler();
+  LocationSummary* locations = invoke->GetLocations();
+  if (locations == nullptr || !locations->Intrinsified()) {
+    return;
+  }
+
+  SlowPathCodeARM64* slow_path =
+      new (codegen->GetScopedAllocator()) IntrinsicSlowPathARM64(invoke);
+  codegen->AddSlowPath(slow_path);
+
+  Register target = GenerateVarHandleFieldAccessChecksAndTarget(invoke, codegen, slow_path);
+  Register offset = WRegisterFrom(locations->GetTemp(0));
+  Location out = locations->Out();
+  DataType::Type type = invoke->GetType();
+  Intrinsics intrinsic = invoke->GetIntrinsic();
+  bool use_load_acquire =
+      intrinsic == Intrinsics::kVarHandleGetAcquire ||
+      intrinsic == Intrinsics::kVarHandleGetVolatile;
+
+  if (type == DataType::Type::kReference && kEmitCompilerReadBarrier) {
+    DCHECK(kUseBakerReadBarrier);
+    // Piggy-back on the field load path using introspection for the Baker read barrier.
+    __ Add(offset, target, offset);
+    codegen->GenerateFieldLoadWithBakerReadBarrier(invoke,
+                                                   out,
+                                                   target,
+                                                   MemOperand(offset.X()),
+                                                   /* needs_null_check= */ false,
+                                                   use_load_acquire);
+  } else {
+    MemOperand field_address(target.X(), offset.X());
+    CPURegister out_reg = CPURegisterFrom(out, type);
+    if (use_load_acquire) {
+      codegen->LoadAcquire(invoke, out_reg, field_address, /* needs_null_check= */ false);
+    } else {
+      codegen->Load(type, out_reg, field_address);
+    }
+    if (type == DataType::Type::kReference) {
+      codegen->GetAssembler()->MaybeUnpoisonHeapReference(WRegisterFrom(out));
+    }
+  }
+
+  __ Bind(slow_path->GetExitLabel());
+}
+
+static void GenerateVarHandleSet(HInvoke* invoke, CodeGeneratorARM64* codegen) {
+  MacroAssembler* masm = codegen->GetVIXLAssembler();
+  LocationSummary* locations = invoke->GetLocations();
+  if (locations == nullptr || !locations->Intrinsified()) {
+    return;
+  }
+
+  SlowPathCodeARM64* slow_path =
+      new (codegen->GetScopedAllocator()) IntrinsicSlowPathARM64(invoke);
+  codegen->AddSlowPath(slow_path);
+
+  Register target = GenerateVarHandleFieldAccessChecksAndTarget(invoke, codegen, slow_path);
+  Register offset = WRegisterFrom(locations->GetTemp(0));
+  MemOperand field_address(target.X(), offset.X());
+  DataType::Type type = GetVarHandleExpectedValueType(invoke);
+  Intrinsics intrinsic = invoke->GetIntrinsic();
+  bool use_store_release =
+      intrinsic == Intrinsics::kVarHandleSetRelease ||
+      intrinsic == Intrinsics::kVarHandleSetVolatile;
+
+  size_t value_index = invoke->GetNumberOfArguments() - 1u;
+  CPURegister value = CPURegisterFrom(locations->InAt(value_index), type);
+  CPURegister source = value;
+  if (kPoisonHeapReferences && type == DataType::Type::kReference) {
+    Register temp = WRegisterFrom(locations->GetTemp(2));
+    __ Mov(temp, InputRegisterAt(invoke, value_index));
+    codegen->GetAssembler()->PoisonHeapReference(temp);
+    source = temp;
+  }
+
+  if (use_store_release) {
+    // The STLR is sequentially consistent together with the LDAR used by
+    // the volatile get, so no additional barrier is needed for SetVolatile.
+    codegen->StoreRelease(invoke, type, source, field_address, /* needs_null_check= */ false);
+  } else {
+    codegen->Store(type, source, field_address);
+  }
+
+  if (type == DataType::Type::kReference) {
+    bool value_can_be_null = true;  // TODO: Worth finding out this information?
+    codegen->MarkGCCard(target, InputRegisterAt(invoke, value_index), value_can_be_null);
+  }
+
+  __ Bind(slow_path->GetExitLabel());
+}
+
+void IntrinsicLocationsBuilderARM64::VisitVarHandleGet(HInvoke* invoke) {
+  CreateVarHandleFieldAccessLocations(invoke);
+}
+
+void IntrinsicCodeGeneratorARM64::VisitVarHandleGet(HInvoke* invoke) {
+  GenerateVarHandleGet(invoke, codegen_);
+}
+
+void IntrinsicLocationsBuilderARM64::VisitVarHandleGetAcquire(HInvoke* invoke) {
+  CreateVarHandleFieldAccessLocations(invoke);
+}
+
+void IntrinsicCodeGeneratorARM64::VisitVarHandleGetAcquire(HInvoke* invoke) {
+  GenerateVarHandleGet(invoke, codegen_);
+}
+
+void IntrinsicLocationsBuilderARM64::VisitVarHandleGetOpaque(HInvoke* invoke) {
+  CreateVarHandleFieldAccessLocations(invoke);
+}
+
+void IntrinsicCodeGeneratorARM64::VisitVarHandleGetOpaque(HInvoke* invoke) {
+  GenerateVarHandleGet(invoke, codegen_);
+}
+
+void IntrinsicLocationsBuilderARM64::VisitVarHandleGetVolatile(HInvoke* invoke) {
+  CreateVarHandleFieldAccessLocations(invoke);
+}
+
+void IntrinsicCodeGeneratorARM64::VisitVarHandleGetVolatile(HInvoke* invoke) {
+  GenerateVarHandleGet(invoke, codegen_);
+}
+
+void IntrinsicLocationsBuilderARM64::VisitVarHandleSet(HInvoke* invoke) {
+  CreateVarHandleFieldAccessLocations(invoke);
+}
+
+void IntrinsicCodeGeneratorARM64::VisitVarHandleSet(HInvoke* invoke) {
+  GenerateVarHandleSet(invoke, codegen_);
+}
+
+void IntrinsicLocationsBuilderARM64::VisitVarHandleSetOpaque(HInvoke* invoke) {
+  CreateVarHandleFieldAccessLocations(invoke);
+}
+
+void IntrinsicCodeGeneratorARM64::VisitVarHandleSetOpaque(HInvoke* invoke) {
+  GenerateVarHandleSet(invoke, codegen_);
+}
+
+void IntrinsicLocationsBuilderARM64::VisitVarHandleSetRelease(HInvoke* invoke) {
+  CreateVarHandleFieldAccessLocations(invoke);
+}
+
+void IntrinsicCodeGeneratorARM64::VisitVarHandleSetRelease(HInvoke* invoke) {
+  GenerateVarHandleSet(invoke, codegen_);
+}
+
+void IntrinsicLocationsBuilderARM64::VisitVarHandleSetVolatile(HInvoke* invoke) {
+  CreateVarHandleFieldAccessLocations(invoke);
+}
+
+void IntrinsicCodeGeneratorARM64::VisitVarHandleSetVolatile(HInvoke* invoke) {
+  GenerateVarHandleSet(invoke, codegen_);
+}
+
 UNIMPLEMENTED_INTRINSIC(ARM64, ReferenceGetReferent)
 
 UNIMPLEMENTED_INTRINSIC(ARM64, StringStringIndexOf);
@@ -2724,6 +2724,15 @@ UNIMPLEMENTED_INTRINSIC(MIPS, UnsafeGetAndSetInt)
 UNIMPLEMENTED_INTRINSIC(MIPS, UnsafeGetAndSetLong)
 UNIMPLEMENTED_INTRINSIC(MIPS, UnsafeGetAndSetObject)
 
+UNIMPLEMENTED_INTRINSIC(MIPS, VarHandleGet)
+UNIMPLEMENTED_INTRINSIC(MIPS, VarHandleGetAcquire)
+UNIMPLEMENTED_INTRINSIC(MIPS, VarHandleGetOpaque)
+UNIMPLEMENTED_INTRINSIC(MIPS, VarHandleGetVolatile)
+UNIMPLEMENTED_INTRINSIC(MIPS, VarHandleSet)
+UNIMPLEMENTED_INTRINSIC(MIPS, VarHandleSetOpaque)
+UNIMPLEMENTED_INTRINSIC(MIPS, VarHandleSetRelease)
+UNIMPLEMENTED_INTRINSIC(MIPS, VarHandleSetVolatile)
+
 UNREACHABLE_INTRINSICS(MIPS)
 
 #undef __
@@ -2374,6 +2374,15 @@ UNIMPLEMENTED_INTRINSIC(MIPS64, UnsafeGetAndSetInt)
 UNIMPLEMENTED_INTRINSIC(MIPS64, UnsafeGetAndSetLong)
 UNIMPLEMENTED_INTRINSIC(MIPS64, UnsafeGetAndSetObject)
 
+UNIMPLEMENTED_INTRINSIC(MIPS64, VarHandleGet)
+UNIMPLEMENTED_INTRINSIC(MIPS64, VarHandleGetAcquire)
+UNIMPLEMENTED_INTRINSIC(MIPS64, VarHandleGetOpaque)
+UNIMPLEMENTED_INTRINSIC(MIPS64, VarHandleGetVolatile)
+UNIMPLEMENTED_INTRINSIC(MIPS64, VarHandleSet)
+UNIMPLEMENTED_INTRINSIC(MIPS64, VarHandleSetOpaque)
+UNIMPLEMENTED_INTRINSIC(MIPS64, VarHandleSetRelease)
+UNIMPLEMENTED_INTRINSIC(MIPS64, VarHandleSetVolatile)
+
 UNREACHABLE_INTRINSICS(MIPS64)
 
 #undef __
@@ -19,6 +19,7 @@
 #include <limits>
 
 #include "arch/x86_64/instruction_set_features_x86_64.h"
+#include "art_field.h"
 #include "art_method.h"
 #include "base/bit_utils.h"
 #include "code_generator_x86_64.h"
@@ -31,6 +32,7 @@
 #include "mirror/object_array-inl.h"
 #include "mirror/reference.h"
 #include "mirror/string.h"
+#include "mirror/var_handle.h"
 #include "scoped_thread_state_change-inl.h"
 #include "thread-current-inl.h"
 #include "utils/x86_64/assembler_x86_64.h"
@@ -2742,6 +2744,354 @@ void IntrinsicLocationsBuilderX86_64::VisitReachabilityFence(HInvoke* invoke) {
 
 void IntrinsicCodeGeneratorX86_64::VisitReachabilityFence(HInvoke* invoke ATTRIBUTE_UNUSED) { }
 
+// Generate subtype check without read barriers: branch to `slow_path` unless the class
+// of the non-null `object` is `klass` or one of its subclasses. Comparing references
+// without read barriers can only yield false negatives, which are handled by `slow_path`.
+static void GenerateSubTypeObjectCheckNoReadBarrier(CodeGeneratorX86_64* codegen,
+                                                    SlowPathCode* slow_path,
+                                                    CpuRegister object,
+                                                    CpuRegister klass,
+                                                    CpuRegister temp) {
+  X86_64Assembler* assembler = codegen->GetAssembler();
+  const uint32_t class_offset = mirror::Object::ClassOffset().Uint32Value();
+  const uint32_t super_class_offset = mirror::Class::SuperClassOffset().Uint32Value();
+  NearLabel loop, success;
+
+  // /* HeapReference<Class> */ temp = object->klass_
+  __ movl(temp, Address(object, class_offset));
+  __ MaybeUnpoisonHeapReference(temp);
+  __ Bind(&loop);
+  __ cmpl(temp, klass);
+  __ j(kEqual, &success);
+  // /* HeapReference<Class> */ temp = temp->super_class_
+  __ movl(temp, Address(temp, super_class_offset));
+  __ MaybeUnpoisonHeapReference(temp);
+  __ testl(temp, temp);
+  __ j(kNotZero, &loop);
+  __ jmp(slow_path->GetEntryLabel());
+  __ Bind(&success);
+}
+
+static void CreateVarHandleFieldAccessLocations(HInvoke* invoke) {
+  if (!HasVarHandleFieldAccessFastPath(invoke)) {
+    return;
+  }
+
+  ArenaAllocator* allocator = invoke->GetBlock()->GetGraph()->GetAllocator();
+  LocationSummary* locations =
+      new (allocator) LocationSummary(invoke, LocationSummary::kCallOnSlowPath, kIntrinsified);
+  // The VarHandle, the holder object of an instance field and the value of a set.
+  for (size_t i = 0, e = invoke->GetNumberOfArguments(); i != e; ++i) {
+    locations->SetInAt(i, DataType::IsFloatingPointType(invoke->InputAt(i)->GetType())
+                              ? Location::RequiresFpuRegister()
+                              : Location::RequiresRegister());
+  }
+  // Temporaries for the ArtField* and then the field offset, and for the type checks and
+  // then the declaring class of a static field.
+  locations->AddTemp(Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresRegister());
+
+  DataType::Type value_type = GetVarHandleExpectedValueType(invoke);
+  if (IsVarHandleGet(invoke)) {
+    if (DataType::IsFloatingPointType(value_type)) {
+      locations->SetOut(Location::RequiresFpuRegister());
+    } else {
+      // The output is written by the Baker read barrier marking code
+      // while the inputs are still needed, so it must not overlap them.
+      locations->SetOut(Location::RequiresRegister(), Location::kOutputOverlap);
+    }
+  } else if (value_type == DataType::Type::kReference) {
+    // Temporary for heap reference poisoning and for marking the GC card.
+    locations->AddTemp(Location::RequiresRegister());
+  }
+}
+
+// Emit the checks guarding the fast path of a VarHandle field access and compute the
+// address of the field: the holder object (or declaring class) and the field offset
+// in the first temporary. Returns the register holding the holder object.
+static CpuRegister GenerateVarHandleFieldAccessChecksAndTarget(HInvoke* invoke,
+                                                               CodeGeneratorX86_64* codegen,
+                                                               SlowPathCode* slow_path) {
+  X86_64Assembler* assembler = codegen->GetAssembler();
+  LocationSummary* locations = invoke->GetLocations();
+  CpuRegister varhandle = locations->InAt(0).AsRegister<CpuRegister>();
+  CpuRegister temp = locations->GetTemp(0).AsRegister<CpuRegister>();
+  CpuRegister temp2 = locations->GetTemp(1).AsRegister<CpuRegister>();
+  size_t expected_coordinates_count = GetExpectedVarHandleCoordinatesCount(invoke);
+  Primitive::Type primitive_type = GetVarHandleExpectedPrimitiveType(invoke);
+
+  const uint32_t access_modes_bit_mask_offset =
+      mirror::VarHandle::AccessModesBitMaskOffset().Uint32Value();
+  const uint32_t var_type_offset = mirror::VarHandle::VarTypeOffset().Uint32Value();
+  const uint32_t coordinate_type0_offset =
+      mirror::VarHandle::CoordinateType0Offset().Uint32Value();
+  const uint32_t coordinate_type1_offset =
+      mirror::VarHandle::CoordinateType1Offset().Uint32Value();
+  const uint32_t primitive_type_offset = mirror::Class::PrimitiveTypeOffset().Uint32Value();
+
+  // Check that the access mode is supported by the VarHandle.
+  mirror::VarHandle::AccessMode access_mode =
+      mirror::VarHandle::GetAccessModeByIntrinsic(invoke->GetIntrinsic());
+  __ testl(Address(varhandle, access_modes_bit_mask_offset),
+           Immediate(1 << static_cast<uint32_t>(access_mode)));
+  __ j(kZero, slow_path->GetEntryLabel());
+
+  // Check that the variable type is the one used by the call site. The primitive type
+  // does not depend on the to-space or from-space copy of the class, so we do not need
+  // a read barrier for `varType`.
+  // /* HeapReference<Class> */ temp = varhandle->var_type_
+  __ movl(temp, Address(varhandle, var_type_offset));
+  __ MaybeUnpoisonHeapReference(temp);
+  __ cmpw(Address(temp, primitive_type_offset), Immediate(static_cast<uint16_t>(primitive_type)));
+  __ j(kNotEqual, slow_path->GetEntryLabel());
+
+  if (!IsVarHandleGet(invoke) && primitive_type == Primitive::kPrimNot) {
+    // Check that the new value is null or an instance of `varType`.
+    CpuRegister value =
+        locations->InAt(invoke->GetNumberOfArguments() - 1u).AsRegister<CpuRegister>();
+    NearLabel value_is_null;
+    __ testl(value, value);
+    __ j(kZero, &value_is_null);
+    GenerateSubTypeObjectCheckNoReadBarrier(codegen, slow_path, value, temp, temp2);
+    __ Bind(&value_is_null);
+  }
+
+  if (expected_coordinates_count == 0u) {
+    // A static field VarHandle has no coordinates.
+    __ cmpl(Address(varhandle, coordinate_type0_offset), Immediate(0));
+    __ j(kNotEqual, slow_path->GetEntryLabel());
+  } else {
+    DCHECK_EQ(expected_coordinates_count, 1u);
+    CpuRegister object = locations->InAt(1).AsRegister<CpuRegister>();
+    // Let the runtime throw the NullPointerException.
+    __ testl(object, object);
+    __ j(kZero, slow_path->GetEntryLabel());
+    // An instance field VarHandle has exactly one coordinate. This also
+    // rejects array element VarHandles and byte array or buffer views.
+    __ cmpl(Address(varhandle, coordinate_type1_offset), Immediate(0));
+    __ j(kNotEqual, slow_path->GetEntryLabel());
+    // Check that the object is an instance of the declaring class of the field.
+    // /* HeapReference<Class> */ temp = varhandle->coordinate_type0_
+    __ movl(temp, Address(varhandle, coordinate_type0_offset));
+    __ MaybeUnpoisonHeapReference(temp);
+    GenerateSubTypeObjectCheckNoReadBarrier(codegen, slow_path, object, temp, temp2);
+  }
+
+  // All checks passed, this is a FieldVarHandle. Load the ArtField* and the offset.
+  // /* ArtField* */ temp = varhandle->art_field_
+  __ movq(temp, Address(varhandle, mirror::FieldVarHandle::ArtFieldOffset().Uint32Value()));
+  CpuRegister target;
+  if (expected_coordinates_count == 0u) {
+    // The declaring class of a static field is the holder object. The runtime accessor
+    // does not check that the class is initialized, so neither do we.
+    // /* GcRoot<mirror::Class> */ temp2 = temp->declaring_class_
+    codegen->GenerateGcRootFieldLoad(invoke,
+                                     Location::RegisterLocation(temp2.AsRegister()),
+                                     Address(temp, ArtField::DeclaringClassOffset().Int32Value()),
+                                     /* fixup_label= */ nullptr,
+                                     kCompilerReadBarrierOption);
+    target = temp2;
+  } else {
+    target = locations->InAt(1).AsRegister<CpuRegister>();
+  }
+  // /* uint32_t */ temp = temp->offset_
+  __ movl(temp, Address(temp, ArtField::OffsetOffset().Uint32Value()));
+  return target;
+}
+
+static void GenerateVarHandleGet(HInvoke* invoke, CodeGeneratorX86_64* codegen) {
+  X86_64Assembler* assembler = codegen->GetAssembler();
+  LocationSummary* locations = invoke->GetLocations();
+  if (locations == nullptr || !locations->Intrinsified()) {
+    return;
+  }
+
+  SlowPathCode* slow_path = new (codegen->GetScopedAllocator()) IntrinsicSlowPathX86_64(invoke);
+  codegen->AddSlowPath(slow_path);
+
+  CpuRegister target = GenerateVarHandleFieldAccessChecksAndTarget(invoke, codegen, slow_path);
+  CpuRegister offset = locations->GetTemp(0).AsRegister<CpuRegister>();
+  Address field_address(target, offset, ScaleFactor::TIMES_1, 0);
+  Location out = locations->Out();
+
+  // Loads need no barrier on x86-64 for any of the get access modes.
+  DataType::Type type = invoke->GetType();
+  switch (type) {
+    case DataType::Type::kBool:
+      __ movzxb(out.AsRegister<CpuRegister>(), field_address);
+      break;
+    case DataType::Type::kInt8:
+      __ movsxb(out.AsRegister<CpuRegister>(), field_address);
+      break;
+    case DataType::Type::kUint16:
+      __ movzxw(out.AsRegister<CpuRegister>(), field_address);
+      break;
+    case DataType::Type::kInt16:
+      __ movsxw(out.AsRegister<CpuRegister>(), field_address);
+      break;
+    case DataType::Type::kInt32:
+      __ movl(out.AsRegister<CpuRegister>(), field_address);
+      break;
+    case DataType::Type::kInt64:
+      __ movq(out.AsRegister<CpuRegister>(), field_address);
+      break;
+    case DataType::Type::kFloat32:
+      __ movss(out.AsFpuRegister<XmmRegister>(), field_address);
+      break;
+    case DataType::Type::kFloat64:
+      __ movsd(out.AsFpuRegister<XmmRegister>(), field_address);
+      break;
+    case DataType::Type::kReference:
+      if (kEmitCompilerReadBarrier) {
+        DCHECK(kUseBakerReadBarrier);
+        codegen->GenerateReferenceLoadWithBakerReadBarrier(
+            invoke, out, target, field_address, /* needs_null_check= */ false);
+      } else {
+        __ movl(out.AsRegister<CpuRegister>(), field_address);
+        __ MaybeUnpoisonHeapReference(out.AsRegister<CpuRegister>());
+      }
+      break;
+    default:
+      LOG(FATAL) << "Unexpected type " << type;
+      UNREACHABLE();
+  }
+
+  __ Bind(slow_path->GetExitLabel());
+}
+
+static void GenerateVarHandleSet(HInvoke* invoke, CodeGeneratorX86_64* codegen) {
+  X86_64Assembler* assembler = codegen->GetAssembler();
+  LocationSummary* locations = invoke->GetLocations();
+  if (locations == nullptr || !locations->Intrinsified()) {
+    return;
+  }
+
+  SlowPathCode* slow_path = new (codegen->GetScopedAllocator()) IntrinsicSlowPathX86_64(invoke);
+  codegen->AddSlowPath(slow_path);
+
+  CpuRegister target = GenerateVarHandleFieldAccessChecksAndTarget(invoke, codegen, slow_path);
+  CpuRegister offset = locations->GetTemp(0).AsRegister<CpuRegister>();
+  Address field_address(target, offset, ScaleFactor::TIMES_1, 0);
+  Location value = locations->InAt(invoke->GetNumberOfArguments() - 1u);
+
+  DataType::Type type = GetVarHandleExpectedValueType(invoke);
+  switch (type) {
+    case DataType::Type::kBool:
+    case DataType::Type::kInt8:
+      __ movb(field_address, value.AsRegister<CpuRegister>());
+      break;
+    case DataType::Type::kUint16:
+    case DataType::Type::kInt16:
+      __ movw(field_address, value.AsRegister<CpuRegister>());
+      break;
+    case DataType::Type::kInt32:
+      __ movl(field_address, value.AsRegister<CpuRegister>());
+      break;
+    case DataType::Type::kInt64:
+      __ movq(field_address, value.AsRegister<CpuRegister>());
+      break;
+    case DataType::Type::kFloat32:
+      __ movss(field_address, value.AsFpuRegister<XmmRegister>());
+      break;
+    case DataType::Type::kFloat64:
+      __ movsd(field_address, value.AsFpuRegister<XmmRegister>());
+      break;
+    case DataType::Type::kReference:
+      if (kPoisonHeapReferences) {
+        CpuRegister temp = locations->GetTemp(2).AsRegister<CpuRegister>();
+        __ movl(temp, value.AsRegister<CpuRegister>());
+        __ PoisonHeapReference(temp);
+        __ movl(field_address, temp);
+      } else {
+        __ movl(field_address, value.AsRegister<CpuRegister>());
+      }
+      break;
+    default:
+      LOG(FATAL) << "Unexpected type " << type;
+      UNREACHABLE();
+  }
+
+  // Plain, opaque and release stores need no barrier on x86-64.
+  if (invoke->GetIntrinsic() == Intrinsics::kVarHandleSetVolatile) {
+    codegen->MemoryFence();
+  }
+
+  if (type == DataType::Type::kReference) {
+    bool value_can_be_null = true;  // TODO: Worth finding out this information?
+    codegen->MarkGCCard(locations->GetTemp(0).AsRegister<CpuRegister>(),
+                        locations->GetTemp(2).AsRegister<CpuRegister>(),
+                        target,
+                        value.AsRegister<CpuRegister>(),
+                        value_can_be_null);
+  }
+
+  __ Bind(slow_path->GetExitLabel());
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitVarHandleGet(HInvoke* invoke) {
+  CreateVarHandleFieldAccessLocations(invoke);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitVarHandleGet(HInvoke* invoke) {
+  GenerateVarHandleGet(invoke, codegen_);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitVarHandleGetAcquire(HInvoke* invoke) {
+  CreateVarHandleFieldAccessLocations(invoke);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitVarHandleGetAcquire(HInvoke* invoke) {
+  GenerateVarHandleGet(invoke, codegen_);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitVarHandleGetOpaque(HInvoke* invoke) {
+  CreateVarHandleFieldAccessLocations(invoke);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitVarHandleGetOpaque(HInvoke* invoke) {
+  GenerateVarHandleGet(invoke, codegen_);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitVarHandleGetVolatile(HInvoke* invoke) {
+  CreateVarHandleFieldAccessLocations(invoke);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitVarHandleGetVolatile(HInvoke* invoke) {
+  GenerateVarHandleGet(invoke, codegen_);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitVarHandleSet(HInvoke* invoke) {
+  CreateVarHandleFieldAccessLocations(invoke);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitVarHandleSet(HInvoke* invoke) {
+  GenerateVarHandleSet(invoke, codegen_);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitVarHandleSetOpaque(HInvoke* invoke) {
+  CreateVarHandleFieldAccessLocations(invoke);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitVarHandleSetOpaque(HInvoke* invoke) {
+  GenerateVarHandleSet(invoke, codegen_);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitVarHandleSetRelease(HInvoke* invoke) {
+  CreateVarHandleFieldAccessLocations(invoke);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitVarHandleSetRelease(HInvoke* invoke) {
+  GenerateVarHandleSet(invoke, codegen_);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitVarHandleSetVolatile(HInvoke* invoke) {
+  CreateVarHandleFieldAccessLocations(invoke);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitVarHandleSetVolatile(HInvoke* invoke) {
+  GenerateVarHandleSet(invoke, codegen_);
+}
+
 UNIMPLEMENTED_INTRINSIC(X86_64, ReferenceGetReferent)
 UNIMPLEMENTED_INTRINSIC(X86_64, FloatIsInfinite)
 UNIMPLEMENTED_INTRINSIC(X86_64, DoubleIsInfinite)
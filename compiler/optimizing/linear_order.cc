@@ -36,10 +36,27 @@ static bool IsInnerLoop(HLoopInformation* outer, HLoopInformation* inner) {
       && inner->IsIn(*outer);
 }
 
+// Returns whether `block` only leads to a throw, e.g. ends with a HThrow or calls a method
+// that always throws. Such blocks are rarely executed.
+static bool IsColdBlock(HBasicBlock* block) {
+  if (block->GetSuccessors().size() != 1u || !block->GetSingleSuccessor()->IsExitBlock()) {
+    return false;
+  }
+  HInstruction* last = block->GetLastInstruction();
+  return !last->IsReturn() && !last->IsReturnVoid();
+}
+
 // Helper method to update work list for linear order.
 static void AddToListForLinearization(ScopedArenaVector<HBasicBlock*>* worklist,
                                       HBasicBlock* block) {
   HLoopInformation* block_loop = block->GetLoopInformation();
+  if (IsColdBlock(block) && !IsLoop(block_loop)) {
+    // Move cold blocks to the bottom of the worklist so that they are placed after the rest
+    // of the method and do not dilute the hot code. Their only successor is the exit block,
+    // so this does not delay any other block, and they are not part of any loop.
+    worklist->insert(worklist->begin(), block);
+    return;
+  }
   auto insert_pos = worklist->rbegin();  // insert_pos.base() will be the actual position.
   for (auto end = worklist->rend(); insert_pos != end; ++insert_pos) {
     HBasicBlock* current = *insert_pos;
@@ -87,7 +104,8 @@ void LinearizeGraphInternal(const HGraph* graph, ArrayRef<HBasicBlock*> linear_o
   DCHECK_EQ(linear_order.size(), graph->GetReversePostOrder().size());
   // Create a reverse post ordering with the following properties:
   // - Blocks in a loop are consecutive,
-  // - Back-edge is the last block before loop exits.
+  // - Back-edge is the last block before loop exits,
+  // - Blocks which only lead to a throw come after all other blocks except the exit block.
   //
   // (1): Record the number of forward predecessors for each block. This is to
   //      ensure the resulting order is reverse post order. We could use the
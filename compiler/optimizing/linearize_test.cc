@@ -242,4 +242,37 @@ TEST_F(LinearizeTest, CFG7) {
   TestCode(data, blocks);
 }
 
+TEST_F(LinearizeTest, ThrowingBlockLast) {
+  // The block ending with the throw comes first in the dex code but is placed
+  // after the block returning from the method.
+  const std::vector<uint16_t> data = ONE_REGISTER_CODE_ITEM(
+    Instruction::CONST_4 | 0 | 0,
+    Instruction::IF_NE, 3,
+    Instruction::THROW | 0 << 8,
+    Instruction::RETURN_VOID);
+
+  HGraph* graph = CreateCFG(data);
+  std::unique_ptr<CodeGenerator> codegen = CodeGenerator::Create(graph, *compiler_options_);
+  SsaLivenessAnalysis liveness(graph, codegen.get(), GetScopedAllocator());
+  liveness.Analyze();
+
+  const ArenaVector<HBasicBlock*>& linear_order = graph->GetLinearOrder();
+  size_t throw_index = linear_order.size();
+  size_t return_index = linear_order.size();
+  for (size_t i = 0; i < linear_order.size(); ++i) {
+    HInstruction* last = linear_order[i]->GetLastInstruction();
+    if (last != nullptr && last->IsThrow()) {
+      throw_index = i;
+    } else if (last != nullptr && last->IsReturnVoid()) {
+      return_index = i;
+    }
+  }
+  ASSERT_LT(return_index, linear_order.size());
+  ASSERT_LT(throw_index, linear_order.size());
+  ASSERT_LT(return_index, throw_index);
+  // Only the exit block comes after the throwing block.
+  ASSERT_EQ(throw_index + 2u, linear_order.size());
+  ASSERT_TRUE(linear_order.back()->IsExitBlock());
+}
+
 }  // namespace art
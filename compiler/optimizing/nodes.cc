@@ -3241,12 +3241,37 @@ static inline IntrinsicExceptions GetExceptionsIntrinsic(Intrinsics i) {
   return kCanThrow;
 }
 
+// Returns whether a polymorphic signature intrinsic is handled by the compiler. The other
+// polymorphic signature methods are only interpreter intrinsics.
+//
+// The VarHandle atomic accessors (compareAndSet, compareAndExchange, getAndSet, getAndAdd and
+// getAndBitwise*) are not compiled yet. Each needs its own code generation: a CAS of a
+// reference must first mark the old field value with Baker read barriers, as UnsafeCASObject
+// does, and getAndAdd of a float or double needs a CAS loop. Until then they keep going
+// through the runtime call, which handles all access modes correctly.
+static bool IsCompilerPolymorphicIntrinsic(Intrinsics intrinsic) {
+  switch (intrinsic) {
+    case Intrinsics::kVarHandleGet:
+    case Intrinsics::kVarHandleGetAcquire:
+    case Intrinsics::kVarHandleGetOpaque:
+    case Intrinsics::kVarHandleGetVolatile:
+    case Intrinsics::kVarHandleSet:
+    case Intrinsics::kVarHandleSetOpaque:
+    case Intrinsics::kVarHandleSetRelease:
+    case Intrinsics::kVarHandleSetVolatile:
+      return true;
+    default:
+      return false;
+  }
+}
+
 void HInvoke::SetResolvedMethod(ArtMethod* method) {
-  // TODO: b/65872996 The intent is that polymorphic signature methods should
-  // be compiler intrinsics. At present, they are only interpreter intrinsics.
+  // TODO: b/65872996 The intent is that all polymorphic signature methods should
+  // be compiler intrinsics. At present, only the VarHandle get and set accessors are.
   if (method != nullptr &&
       method->IsIntrinsic() &&
-      !method->IsPolymorphicSignature()) {
+      (!method->IsPolymorphicSignature() ||
+       IsCompilerPolymorphicIntrinsic(static_cast<Intrinsics>(method->GetIntrinsic())))) {
     Intrinsics intrinsic = static_cast<Intrinsics>(method->GetIntrinsic());
     SetIntrinsic(intrinsic,
                  NeedsEnvironmentOrCacheIntrinsic(intrinsic),
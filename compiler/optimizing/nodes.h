@@ -4437,7 +4437,13 @@ class HInvokePolymorphic final : public HInvoke {
                      uint32_t number_of_arguments,
                      DataType::Type return_type,
                      uint32_t dex_pc,
-                     uint32_t dex_method_index)
+                     uint32_t dex_method_index,
+                     // resolved_method is the ArtMethod object corresponding to the polymorphic
+                     // method (e.g. VarHandle.get), resolved using the class linker. It is needed
+                     // to pass intrinsic information to the HInvokePolymorphic node.
+                     ArtMethod* resolved_method,
+                     const DexFile& dex_file,
+                     dex::ProtoIndex proto_idx)
       : HInvoke(kInvokePolymorphic,
                 allocator,
                 number_of_arguments,
@@ -4445,16 +4451,28 @@ class HInvokePolymorphic final : public HInvoke {
                 return_type,
                 dex_pc,
                 dex_method_index,
-                nullptr,
-                kVirtual) {
+                resolved_method,
+                kVirtual),
+        dex_file_(dex_file),
+        proto_idx_(proto_idx) {
   }
 
   bool IsClonable() const override { return true; }
 
+  // The dex file and prototype of the call site. The shorty of the prototype gives the
+  // types of the arguments and the return value as seen by the caller, which may differ
+  // from the types of the accessed variable.
+  const DexFile& GetDexFile() const { return dex_file_; }
+  dex::ProtoIndex GetProtoIndex() const { return proto_idx_; }
+
   DECLARE_INSTRUCTION(InvokePolymorphic);
 
  protected:
   DEFAULT_COPY_CONSTRUCTOR(InvokePolymorphic);
+
+ private:
+  const DexFile& dex_file_;
+  const dex::ProtoIndex proto_idx_;
 };
 
 class HInvokeCustom final : public HInvoke {
@@ -30,6 +30,7 @@
 #include "base/macros.h"
 #include "base/mutex.h"
 #include "base/scoped_arena_allocator.h"
+#include "base/time_utils.h"
 #include "base/timing_logger.h"
 #include "builder.h"
 #include "class_root.h"
@@ -100,6 +101,48 @@ class CodeVectorAllocator final : public CodeAllocator {
  */
 static constexpr const char kStringFilter[] = "";
 
+/**
+ * Budget of time and graph arena memory for compiling a method, from the compiler options.
+ * Passes are not interrupted, so the budget is only checked between them.
+ */
+class MethodCompilationBudget : public ValueObject {
+ public:
+  MethodCompilationBudget(const CompilerOptions& compiler_options, ArenaAllocator* allocator)
+      : allocator_(allocator),
+        start_ns_(NanoTime()),
+        start_bytes_used_(allocator->BytesUsed()),
+        time_budget_ns_(MsToNs(compiler_options.GetMethodCompileTimeBudgetMs())),
+        memory_budget_(compiler_options.GetMethodMemoryBudget()),
+        exceeded_(false) {
+    // Deterministic compilation must not depend on the load of the machine.
+    DCHECK(!compiler_options.IsForceDeterminism() || time_budget_ns_ == 0u);
+  }
+
+  // Returns whether the budget has been exceeded so far.
+  bool CheckExceeded() {
+    if (!exceeded_) {
+      exceeded_ =
+          (time_budget_ns_ != 0u && NanoTime() - start_ns_ > time_budget_ns_) ||
+          (memory_budget_ != 0u && allocator_->BytesUsed() - start_bytes_used_ > memory_budget_);
+    }
+    return exceeded_;
+  }
+
+  bool IsExceeded() const {
+    return exceeded_;
+  }
+
+ private:
+  ArenaAllocator* const allocator_;
+  const uint64_t start_ns_;
+  const size_t start_bytes_used_;
+  const uint64_t time_budget_ns_;
+  const size_t memory_budget_;
+  bool exceeded_;
+
+  DISALLOW_COPY_AND_ASSIGN(MethodCompilationBudget);
+};
+
 class PassScope;
 
 class PassObserver : public ValueObject {
@@ -108,7 +151,8 @@ class PassObserver : public ValueObject {
                CodeGenerator* codegen,
                std::ostream* visualizer_output,
                const CompilerOptions& compiler_options,
-               Mutex& dump_mutex)
+               Mutex& dump_mutex,
+               MethodCompilationBudget* budget = nullptr)
       : graph_(graph),
         last_seen_graph_size_(0),
         cached_method_name_(),
@@ -120,7 +164,8 @@ class PassObserver : public ValueObject {
         visualizer_enabled_(!compiler_options.GetDumpCfgFileName().empty()),
         visualizer_(&visualizer_oss_, graph, *codegen),
         visualizer_dump_mutex_(dump_mutex),
-        graph_in_bad_state_(false) {
+        graph_in_bad_state_(false),
+        budget_(budget) {
     if (timing_logger_enabled_ || visualizer_enabled_) {
       if (!IsVerboseMethod(compiler_options, GetMethodName())) {
         timing_logger_enabled_ = visualizer_enabled_ = false;
@@ -149,6 +194,9 @@ class PassObserver : public ValueObject {
 
   void SetGraphInBadState() { graph_in_bad_state_ = true; }
 
+  // Returns whether the compilation should be abandoned because it exceeded its budget.
+  bool IsOverBudget() { return budget_ != nullptr && budget_->CheckExceeded(); }
+
   const char* GetMethodName() {
     // PrettyMethod() is expensive, so we delay calling it until we actually have to.
     if (cached_method_name_.empty()) {
@@ -237,6 +285,8 @@ class PassObserver : public ValueObject {
   // expected to validate.
   bool graph_in_bad_state_;
 
+  MethodCompilationBudget* const budget_;
+
   friend PassScope;
 
   DISALLOW_COPY_AND_ASSIGN(PassObserver);
@@ -327,6 +377,9 @@ class OptimizingCompiler final : public Compiler {
     pass_changes[static_cast<size_t>(OptimizationPass::kNone)] = true;
     bool change = false;
     for (size_t i = 0; i < length; ++i) {
+      if (pass_observer->IsOverBudget()) {
+        break;
+      }
       if (pass_changes[static_cast<size_t>(definitions[i].depends_on)]) {
         // Execute the pass and record whether it changed anything.
         PassScope scope(optimizations[i]->GetPassName(), pass_observer);
@@ -376,6 +429,7 @@ class OptimizingCompiler final : public Compiler {
   // 2) Transforms the graph to SSA. Returns null if it failed.
   // 3) Runs optimizations on the graph, including register allocator.
   // 4) Generates code with the `code_allocator` provided.
+  // Returns null if the optional `budget` is exceeded before code generation.
   CodeGenerator* TryCompile(ArenaAllocator* allocator,
                             ArenaStack* arena_stack,
                             CodeVectorAllocator* code_allocator,
@@ -383,7 +437,8 @@ class OptimizingCompiler final : public Compiler {
                             ArtMethod* method,
                             bool baseline,
                             bool osr,
-                            VariableSizedHandleScope* handles) const;
+                            VariableSizedHandleScope* handles,
+                            MethodCompilationBudget* budget = nullptr) const;
 
   CodeGenerator* TryCompileIntrinsic(ArenaAllocator* allocator,
                                      ArenaStack* arena_stack,
@@ -605,8 +660,10 @@ bool OptimizingCompiler::RunArchOptimizations(HGraph* graph,
   }
 }
 
+// Returns false if the compilation budget was exceeded, in which case the graph is left
+// partially allocated.
 NO_INLINE  // Avoid increasing caller's frame size by large stack-allocated objects.
-static void AllocateRegisters(HGraph* graph,
+static bool AllocateRegisters(HGraph* graph,
                               CodeGenerator* codegen,
                               PassObserver* pass_observer,
                               RegisterAllocator::Strategy strategy,
@@ -616,6 +673,9 @@ static void AllocateRegisters(HGraph* graph,
                     pass_observer);
     PrepareForRegisterAllocation(graph, codegen->GetCompilerOptions(), stats).Run();
   }
+  if (pass_observer->IsOverBudget()) {
+    return false;
+  }
   // Use local allocator shared by SSA liveness analysis and register allocator.
   // (Register allocator creates new objects in the liveness data.)
   ScopedArenaAllocator local_allocator(graph->GetArenaStack());
@@ -624,12 +684,17 @@ static void AllocateRegisters(HGraph* graph,
     PassScope scope(SsaLivenessAnalysis::kLivenessPassName, pass_observer);
     liveness.Analyze();
   }
+  if (pass_observer->IsOverBudget()) {
+    return false;
+  }
   {
     PassScope scope(RegisterAllocator::kRegisterAllocatorPassName, pass_observer);
     std::unique_ptr<RegisterAllocator> register_allocator =
         RegisterAllocator::Create(&local_allocator, codegen, liveness, strategy);
     register_allocator->AllocateRegisters();
   }
+  // The register allocator adds moves to the graph, so check once more before generating code.
+  return !pass_observer->IsOverBudget();
 }
 
 // Strip pass name suffix to get optimization name.
@@ -782,7 +847,8 @@ CodeGenerator* OptimizingCompiler::TryCompile(ArenaAllocator* allocator,
                                               ArtMethod* method,
                                               bool baseline,
                                               bool osr,
-                                              VariableSizedHandleScope* handles) const {
+                                              VariableSizedHandleScope* handles,
+                                              MethodCompilationBudget* budget) const {
   MaybeRecordStat(compilation_stats_.get(), MethodCompilationStat::kAttemptBytecodeCompilation);
   const CompilerOptions& compiler_options = GetCompilerOptions();
   InstructionSet instruction_set = compiler_options.GetInstructionSet();
@@ -869,7 +935,8 @@ CodeGenerator* OptimizingCompiler::TryCompile(ArenaAllocator* allocator,
                              codegen.get(),
                              visualizer_output_.get(),
                              compiler_options,
-                             dump_mutex_);
+                             dump_mutex_,
+                             budget);
 
   {
     VLOG(compiler) << "Building " << pass_observer.GetMethodName();
@@ -924,13 +991,24 @@ CodeGenerator* OptimizingCompiler::TryCompile(ArenaAllocator* allocator,
     RunOptimizations(graph, codegen.get(), dex_compilation_unit, &pass_observer, handles);
   }
 
+  if (pass_observer.IsOverBudget()) {
+    VLOG(compiler) << "Exceeded the compilation budget of " << pass_observer.GetMethodName();
+    pass_observer.SetGraphInBadState();
+    return nullptr;
+  }
+
   RegisterAllocator::Strategy regalloc_strategy =
     compiler_options.GetRegisterAllocationStrategy();
-  AllocateRegisters(graph,
-                    codegen.get(),
-                    &pass_observer,
-                    regalloc_strategy,
-                    compilation_stats_.get());
+  if (!AllocateRegisters(graph,
+                         codegen.get(),
+                         &pass_observer,
+                         regalloc_strategy,
+                         compilation_stats_.get())) {
+    VLOG(compiler) << "Exceeded the compilation budget of " << pass_observer.GetMethodName()
+                   << " during register allocation";
+    pass_observer.SetGraphInBadState();
+    return nullptr;
+  }
 
   codegen->Compile(code_allocator);
   pass_observer.DumpDisassembly();
@@ -1098,6 +1176,7 @@ CompiledMethod* OptimizingCompiler::Compile(const dex::CodeItem* code_item,
         }
       }
       if (codegen == nullptr) {
+        MethodCompilationBudget budget(compiler_options, &allocator);
         codegen.reset(
             TryCompile(&allocator,
                        &arena_stack,
@@ -1106,7 +1185,31 @@ CompiledMethod* OptimizingCompiler::Compile(const dex::CodeItem* code_item,
                        method,
                        compiler_options.IsBaseline(),
                        /* osr= */ false,
-                       &handles));
+                       &handles,
+                       &budget));
+        if (codegen == nullptr && budget.IsExceeded() && !compiler_options.IsBaseline()) {
+          // Retry without optimizations, within a fresh budget. The graph of the abandoned
+          // attempt stays in the `allocator` until we are done with the method.
+          MethodCompilationBudget baseline_budget(compiler_options, &allocator);
+          codegen.reset(
+              TryCompile(&allocator,
+                         &arena_stack,
+                         &code_allocator,
+                         dex_compilation_unit,
+                         method,
+                         /* baseline= */ true,
+                         /* osr= */ false,
+                         &handles,
+                         &baseline_budget));
+          if (codegen != nullptr) {
+            MaybeRecordStat(compilation_stats_.get(),
+                            MethodCompilationStat::kCompiledBaselineBudgetExceeded);
+          }
+        }
+        if (codegen == nullptr && budget.IsExceeded()) {
+          MaybeRecordStat(compilation_stats_.get(),
+                          MethodCompilationStat::kNotCompiledBudgetExceeded);
+        }
       }
     }
     if (codegen.get() != nullptr) {
@@ -22,6 +22,7 @@
 #include <inttypes.h>
 
 #include <algorithm>
+#include <atomic>
 #include <unordered_map>
 
 #include "android-base/stringprintf.h"
@@ -44,6 +45,9 @@ struct DedupeSet<InKey, StoreKey, Alloc, HashType, HashFunc, kShard>::Stats {
   size_t collision_max = 0u;
   size_t total_probe_distance = 0u;
   size_t total_size = 0u;
+  size_t lock_acquisitions = 0u;
+  size_t contended_lock_acquisitions = 0u;
+  size_t discarded_copies = 0u;
 };
 
 template <typename InKey,
@@ -58,7 +62,10 @@ class DedupeSet<InKey, StoreKey, Alloc, HashType, HashFunc, kShard>::Shard {
       : alloc_(alloc),
         lock_name_(lock_name),
         lock_(lock_name_.c_str()),
-        keys_() {
+        keys_(),
+        lock_acquisitions_(0u),
+        contended_lock_acquisitions_(0u),
+        discarded_copies_(0u) {
   }
 
   ~Shard() {
@@ -69,16 +76,34 @@ class DedupeSet<InKey, StoreKey, Alloc, HashType, HashFunc, kShard>::Shard {
   }
 
   const StoreKey* Add(Thread* self, size_t hash, const InKey& in_key) REQUIRES(!lock_) {
-    MutexLock lock(self, lock_);
     HashedKey<InKey> hashed_in_key(hash, &in_key);
+    AcquireLock(self);
     auto it = keys_.find(hashed_in_key);
     if (it != keys_.end()) {
       DCHECK(it->Key() != nullptr);
-      return it->Key();
+      const StoreKey* existing_key = it->Key();
+      lock_.ExclusiveUnlock(self);
+      return existing_key;
     }
+    lock_.ExclusiveUnlock(self);
+
+    // Copy the key without holding the lock. The copy is proportional to the size of the key
+    // and the allocation may need to take the swap space lock.
     const StoreKey* store_key = alloc_.Copy(in_key);
-    keys_.insert(HashedKey<StoreKey> { hash, store_key });
-    return store_key;
+
+    AcquireLock(self);
+    it = keys_.find(hashed_in_key);
+    if (it == keys_.end()) {
+      keys_.insert(HashedKey<StoreKey> { hash, store_key });
+      lock_.ExclusiveUnlock(self);
+      return store_key;
+    }
+    // Another thread added an equal key in the meantime.
+    const StoreKey* existing_key = it->Key();
+    lock_.ExclusiveUnlock(self);
+    alloc_.Destroy(store_key);
+    discarded_copies_.fetch_add(1u, std::memory_order_relaxed);
+    return existing_key;
   }
 
   void UpdateStats(Thread* self, Stats* global_stats) REQUIRES(!lock_) {
@@ -91,6 +116,10 @@ class DedupeSet<InKey, StoreKey, Alloc, HashType, HashFunc, kShard>::Shard {
       // It may have been higher before a re-hash.
       global_stats->total_probe_distance += keys_.TotalProbeDistance();
       global_stats->total_size += keys_.size();
+      global_stats->lock_acquisitions += lock_acquisitions_.load(std::memory_order_relaxed);
+      global_stats->contended_lock_acquisitions +=
+          contended_lock_acquisitions_.load(std::memory_order_relaxed);
+      global_stats->discarded_copies += discarded_copies_.load(std::memory_order_relaxed);
       for (const HashedKey<StoreKey>& key : keys_) {
         auto it = stats.find(key.Hash());
         if (it == stats.end()) {
@@ -110,6 +139,15 @@ class DedupeSet<InKey, StoreKey, Alloc, HashType, HashFunc, kShard>::Shard {
   }
 
  private:
+  // Acquires the lock, recording whether another thread was holding it.
+  void AcquireLock(Thread* self) ACQUIRE(lock_) NO_THREAD_SAFETY_ANALYSIS {
+    if (!lock_.ExclusiveTryLock(self)) {
+      contended_lock_acquisitions_.fetch_add(1u, std::memory_order_relaxed);
+      lock_.ExclusiveLock(self);
+    }
+    lock_acquisitions_.fetch_add(1u, std::memory_order_relaxed);
+  }
+
   template <typename T>
   class HashedKey {
    public:
@@ -178,6 +216,11 @@ class DedupeSet<InKey, StoreKey, Alloc, HashType, HashFunc, kShard>::Shard {
   const std::string lock_name_;
   Mutex lock_;
   HashSet<HashedKey<StoreKey>, ShardEmptyFn, ShardHashFn, ShardPred> keys_ GUARDED_BY(lock_);
+
+  // Contention statistics.
+  std::atomic<size_t> lock_acquisitions_;
+  std::atomic<size_t> contended_lock_acquisitions_;
+  std::atomic<size_t> discarded_copies_;
 };
 
 template <typename InKey,
@@ -195,7 +238,7 @@ const StoreKey* DedupeSet<InKey, StoreKey, Alloc, HashType, HashFunc, kShard>::A
   HashType raw_hash = HashFunc()(key);
   if (kIsDebugBuild) {
     uint64_t hash_end = NanoTime();
-    hash_time_ += hash_end - hash_start;
+    hash_time_.fetch_add(hash_end - hash_start, std::memory_order_relaxed);
   }
   HashType shard_hash = raw_hash / kShard;
   HashType shard_bin = raw_hash % kShard;
@@ -241,12 +284,17 @@ std::string DedupeSet<InKey, StoreKey, Alloc, HashType, HashFunc, kShard>::DumpS
     shards_[shard]->UpdateStats(self, &stats);
   }
   return android::base::StringPrintf("%zu collisions, %zu max hash collisions, "
-                                     "%zu/%zu probe distance, %" PRIu64 " ns hash time",
+                                     "%zu/%zu probe distance, %" PRIu64 " ns hash time, "
+                                     "%zu/%zu contended lock acquisitions, "
+                                     "%zu discarded copies",
                                      stats.collision_sum,
                                      stats.collision_max,
                                      stats.total_probe_distance,
                                      stats.total_size,
-                                     hash_time_);
+                                     hash_time_.load(std::memory_order_relaxed),
+                                     stats.contended_lock_acquisitions,
+                                     stats.lock_acquisitions,
+                                     stats.discarded_copies);
 }
 
 
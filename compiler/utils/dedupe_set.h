@@ -18,6 +18,7 @@
 #define ART_COMPILER_UTILS_DEDUPE_SET_H_
 
 #include <stdint.h>
+#include <atomic>
 #include <memory>
 #include <string>
 
@@ -29,7 +30,8 @@ class Thread;
 
 // A set of Keys that support a HashFunc returning HashType. Used to find duplicates of Key in the
 // Add method. The data-structure is thread-safe through the use of internal locks, it also
-// supports the lock being sharded.
+// supports the lock being sharded. Keys are hashed and copied outside of the locks, which are
+// only held for the lookups and insertions.
 template <typename InKey,
           typename StoreKey,
           typename Alloc,
@@ -52,7 +54,7 @@ class DedupeSet {
   class Shard;
 
   std::unique_ptr<Shard> shards_[kShard];
-  uint64_t hash_time_;
+  std::atomic<uint64_t> hash_time_;
 
   DISALLOW_COPY_AND_ASSIGN(DedupeSet);
 };
@@ -18,6 +18,7 @@
 
 #include <algorithm>
 #include <cstdio>
+#include <thread>
 #include <vector>
 
 #include "base/array_ref.h"
@@ -88,4 +89,38 @@ TEST(DedupeSetTest, Test) {
   }
 }
 
+TEST(DedupeSetTest, Concurrent) {
+  DedupeSetTestAlloc alloc;
+  DedupeSet<ArrayRef<const uint8_t>,
+            std::vector<uint8_t>,
+            DedupeSetTestAlloc,
+            size_t,
+            DedupeSetTestHashFunc,
+            4u> deduplicator("test", alloc);
+  static constexpr size_t kNumThreads = 8u;
+  static constexpr size_t kNumKeys = 1000u;
+  std::vector<std::vector<const std::vector<uint8_t>*>> results(kNumThreads);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t != kNumThreads; ++t) {
+    threads.emplace_back([&deduplicator, &results, t]() {
+      for (size_t i = 0; i != kNumKeys; ++i) {
+        uint8_t raw_key[] = { static_cast<uint8_t>(i), static_cast<uint8_t>(i >> 8), 1u, 2u };
+        ArrayRef<const uint8_t> key(raw_key);
+        results[t].push_back(deduplicator.Add(/* self= */ nullptr, key));
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  // All threads must get the same stored key for equal keys.
+  for (size_t i = 0; i != kNumKeys; ++i) {
+    ASSERT_EQ(results[0][i]->size(), 4u);
+    ASSERT_EQ((*results[0][i])[0], static_cast<uint8_t>(i));
+    for (size_t t = 1; t != kNumThreads; ++t) {
+      ASSERT_EQ(results[0][i], results[t][i]);
+    }
+  }
+}
+
 }  // namespace art
@@ -162,6 +162,7 @@ SwapSpace::SpaceChunk SwapSpace::NewFileChunk(size_t min_size) {
     LOG(FATAL) << "Aborting...";
   }
   size_ += next_part;
+  maps_.emplace_back(ptr, next_part);
   SpaceChunk new_chunk = {ptr, next_part};
   return new_chunk;
 #else
@@ -171,6 +172,19 @@ SwapSpace::SpaceChunk SwapSpace::NewFileChunk(size_t min_size) {
 #endif
 }
 
+void SwapSpace::ReleaseResidentPages() {
+  MutexLock lock(Thread::Current(), lock_);
+  for (const std::pair<uint8_t*, size_t>& map : maps_) {
+    // The mappings are MAP_SHARED, so MADV_DONTNEED only unmaps the pages from this process.
+    // Dirty pages are kept in the page cache and written back to the file rather than
+    // discarded, and a later access reads them back.
+    if (madvise(map.first, map.second, MADV_DONTNEED) != 0) {
+      PLOG(WARNING) << "Failed to release swap space pages at "
+          << static_cast<const void*>(map.first) << " size=" << map.second;
+    }
+  }
+}
+
 // TODO: Full coalescing.
 void SwapSpace::Free(void* ptr, size_t size) {
   MutexLock lock(Thread::Current(), lock_);
@@ -22,6 +22,7 @@
 #include <cstdlib>
 #include <list>
 #include <set>
+#include <utility>
 #include <vector>
 
 #include <android-base/logging.h>
@@ -39,6 +40,10 @@ class SwapSpace {
   void* Alloc(size_t size) REQUIRES(!lock_);
   void Free(void* ptr, size_t size) REQUIRES(!lock_);
 
+  // Drops the pages of the swap file from the resident set of the process. The data stays in
+  // the file and is paged back in when accessed, so this is safe while allocations are live.
+  void ReleaseResidentPages() REQUIRES(!lock_);
+
   size_t GetSize() {
     return size_;
   }
@@ -104,6 +109,9 @@ class SwapSpace {
   // Free chunks ordered by size.
   FreeBySizeSet free_by_size_ GUARDED_BY(lock_);
 
+  // All mappings of the file, as (start, size).
+  std::vector<std::pair<uint8_t*, size_t>> maps_ GUARDED_BY(lock_);
+
   mutable Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
   DISALLOW_COPY_AND_ASSIGN(SwapSpace);
 };
@@ -20,6 +20,7 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#include <algorithm>
 #include <cstdio>
 
 #include "gtest/gtest.h"
@@ -80,4 +81,32 @@ TEST_F(SwapSpaceTest, Swap) {
   SwapTest(true);
 }
 
+TEST_F(SwapSpaceTest, ReleaseResidentPages) {
+  ScratchFile scratch;
+  int fd = scratch.GetFd();
+  unlink(scratch.GetFilename().c_str());
+
+  SwapSpace pool(fd, 1 * MB);
+  SwapAllocator<void> alloc(&pool);
+
+  SwapVector<int32_t> v(alloc);
+  v.reserve(1000000);
+  for (int32_t i = 0; i < 1000000; ++i) {
+    v.push_back(i);
+  }
+  pool.ReleaseResidentPages();
+
+  // The contents are paged back in from the file.
+  for (int32_t i = 0; i < 1000000; ++i) {
+    EXPECT_EQ(i, v[i]);
+  }
+  // New allocations still work.
+  SwapVector<int32_t> v2(alloc);
+  v2.assign(v.begin(), v.end());
+  pool.ReleaseResidentPages();
+  EXPECT_TRUE(std::equal(v.begin(), v.end(), v2.begin()));
+
+  scratch.Close();
+}
+
 }  // namespace art
@@ -68,6 +68,7 @@
 #include "dex2oat_options.h"
 #include "dex2oat_return_codes.h"
 #include "dexlayout.h"
+#include "driver/compiled_method_cache.h"
 #include "driver/compiler_driver.h"
 #include "driver/compiler_options.h"
 #include "driver/compiler_options_map-inl.h"
@@ -251,6 +252,15 @@ NO_RETURN static void Usage(const char* fmt, ...) {
   UsageError("      descriptor.");
   UsageError("      Example: --output-vdex-fd=6");
   UsageError("");
+  UsageError("  --input-compiled-methods=<file>: reuse the code of methods recorded by a previous");
+  UsageError("      compilation whose dependencies did not change.");
+  UsageError("");
+  UsageError("  --output-compiled-methods=<file>: record the compiled methods for use with");
+  UsageError("      --input-compiled-methods by a later compilation.");
+  UsageError("");
+  UsageError("  --compiled-method-cache-dir=<directory>: reuse compiled methods from, and add");
+  UsageError("      them to, a cache directory which can be shared by compilations of any app.");
+  UsageError("");
   UsageError("  --oat-location=<oat-name>: specifies a symbolic name for the file corresponding");
   UsageError("      to the file descriptor specified by --oat-fd.");
   UsageError("      Example: --oat-location=/data/dalvik-cache/system@app@Calculator.apk.oat");
@@ -496,6 +506,17 @@ NO_RETURN static void Usage(const char* fmt, ...) {
   UsageError("");
   UsageError("  --max-image-block-size=<size>: Maximum solid block size for compressed images.");
   UsageError("");
+  UsageError("  --method-compile-time-budget-ms=<ms>: Time budget for compiling one method.");
+  UsageError("      The budget is checked between optimization passes. A method exceeding it is");
+  UsageError("      compiled again without optimizations, and left to the interpreter if that");
+  UsageError("      exceeds the budget too. The outcomes are counted by --dump-stats.");
+  UsageError("      Ignored with --force-determinism.");
+  UsageError("      Default: 0 (unlimited)");
+  UsageError("");
+  UsageError("  --method-memory-budget=<bytes>: Arena memory budget for the graph of one method,");
+  UsageError("      enforced like --method-compile-time-budget-ms.");
+  UsageError("      Default: 0 (unlimited)");
+  UsageError("");
   std::cerr << "See log for usage error information\n";
   exit(EXIT_FAILURE);
 }
@@ -975,6 +996,12 @@ class Dex2Oat final {
       }
     }
     compiler_options_->force_determinism_ = force_determinism_;
+    if (force_determinism_ && compiler_options_->method_compile_time_budget_ms_ != 0u) {
+      // The time spent compiling a method depends on the load of the machine. The memory
+      // budget only depends on the input and stays in effect.
+      LOG(WARNING) << "Ignoring --method-compile-time-budget-ms for deterministic compilation.";
+      compiler_options_->method_compile_time_budget_ms_ = 0u;
+    }
 
     if (passes_to_run_filename_ != nullptr) {
       passes_to_run_ = ReadCommentedInputFromFile<std::vector<std::string>>(
@@ -1127,6 +1154,9 @@ class Dex2Oat final {
     AssignIfExists(args, M::OutputVdexFd, &output_vdex_fd_);
     AssignIfExists(args, M::InputVdex, &input_vdex_);
     AssignIfExists(args, M::OutputVdex, &output_vdex_);
+    AssignIfExists(args, M::InputCompiledMethods, &input_compiled_methods_);
+    AssignIfExists(args, M::OutputCompiledMethods, &output_compiled_methods_);
+    AssignIfExists(args, M::CompiledMethodCacheDir, &compiled_method_cache_dir_);
     AssignIfExists(args, M::DmFd, &dm_fd_);
     AssignIfExists(args, M::DmFile, &dm_file_location_);
     AssignIfExists(args, M::OatFd, &oat_fd_);
@@ -1583,6 +1613,7 @@ class Dex2Oat final {
             verify,
             update_input_vdex_,
             copy_dex_files_,
+            thread_count_,
             &opened_dex_files_map,
             &opened_dex_files)) {
           return dex2oat::ReturnCode::kOther;
@@ -1801,6 +1832,27 @@ class Dex2Oat final {
     if (!IsBootImage()) {
       driver_->SetClasspathDexFiles(class_loader_context_->FlattenOpenedDexFiles());
     }
+    if (!input_compiled_methods_.empty() ||
+        !output_compiled_methods_.empty() ||
+        !compiled_method_cache_dir_.empty()) {
+      compiled_method_cache_.reset(new CompiledMethodCache(*compiler_options_,
+                                                           driver_->GetCompiledMethodStorage()));
+      std::string error_msg;
+      if (!input_compiled_methods_.empty() &&
+          !compiled_method_cache_->Load(input_compiled_methods_, &error_msg)) {
+        LOG(WARNING) << "Not reusing compiled methods: " << error_msg;
+      }
+      compiled_method_cache_->SetRecordEntries(!output_compiled_methods_.empty());
+      if (!compiled_method_cache_dir_.empty()) {
+        if (OS::DirectoryExists(compiled_method_cache_dir_.c_str())) {
+          compiled_method_cache_->SetDirectory(compiled_method_cache_dir_);
+        } else {
+          LOG(WARNING) << "Compiled method cache directory does not exist: "
+                       << compiled_method_cache_dir_;
+        }
+      }
+      driver_->SetCompiledMethodCache(compiled_method_cache_.get());
+    }
 
     const bool compile_individually = ShouldCompileDexFilesIndividually();
     if (compile_individually) {
@@ -1833,12 +1885,32 @@ class Dex2Oat final {
       callbacks_->SetVerifierDeps(new verifier::VerifierDeps(dex_files));
     }
     // Invoke the compilation.
+    jobject class_loader = nullptr;
     if (compile_individually) {
       CompileDexFilesIndividually();
       // Return a null classloader since we already freed released it.
-      return nullptr;
+    } else {
+      class_loader = CompileDexFiles(dex_files);
+    }
+    SaveCompiledMethods();
+    return class_loader;
+  }
+
+  void SaveCompiledMethods() {
+    if (compiled_method_cache_ == nullptr) {
+      return;
+    }
+    if (compiler_options_->GetDumpStats()) {
+      LOG(INFO) << "Reused " << compiled_method_cache_->GetNumberOfHits() << " compiled methods";
+    } else {
+      VLOG(compiler) << "Reused " << compiled_method_cache_->GetNumberOfHits()
+                     << " compiled methods";
+    }
+    std::string error_msg;
+    if (!output_compiled_methods_.empty() &&
+        !compiled_method_cache_->Save(output_compiled_methods_, &error_msg)) {
+      LOG(WARNING) << "Failed to record compiled methods: " << error_msg;
     }
-    return CompileDexFiles(dex_files);
   }
 
   // Create the class loader, use it to compile, and return.
@@ -1875,6 +1947,12 @@ class Dex2Oat final {
                         verification_results_.get());
     callbacks_->SetVerificationResults(nullptr);  // Should not be needed anymore.
     compiler_options_->verification_results_ = verification_results_.get();
+    if (compiled_method_cache_ != nullptr) {
+      auto it = key_value_store_->find(OatHeader::kClassPathKey);
+      std::string class_path_key = (it != key_value_store_->end()) ? it->second : std::string();
+      ScopedObjectAccess soa(Thread::Current());
+      compiled_method_cache_->Prepare(class_path_key);
+    }
     driver_->CompileAll(class_loader, dex_files, timings_);
     driver_->FreeThreadPools();
     return class_loader;
@@ -2080,6 +2158,9 @@ class Dex2Oat final {
           return false;
         }
         elf_writer->EndText(text);
+        // The code has been written out. Only the stack maps and CFI are still needed, for
+        // the debug info, and they are paged back in as they are read.
+        driver_->GetCompiledMethodStorage()->ReleaseSwapPages();
 
         if (oat_writer->GetDataBimgRelRoSize() != 0u) {
           OutputStream* data_bimg_rel_ro = elf_writer->StartDataBimgRelRo();
@@ -2434,7 +2515,8 @@ class Dex2Oat final {
     elf_writers_.reserve(oat_files_.size());
     oat_writers_.reserve(oat_files_.size());
     for (const std::unique_ptr<File>& oat_file : oat_files_) {
-      elf_writers_.emplace_back(linker::CreateElfWriterQuick(*compiler_options_, oat_file.get()));
+      elf_writers_.emplace_back(
+          linker::CreateElfWriterQuick(*compiler_options_, oat_file.get(), thread_count_));
       elf_writers_.back()->Start();
       bool do_oat_writer_layout = DoDexLayoutOptimizations() || DoOatLayoutOptimizations();
       if (profile_compilation_info_ != nullptr && profile_compilation_info_->IsEmpty()) {
@@ -2587,7 +2669,8 @@ class Dex2Oat final {
     }
     if (!image_writer_->Write(app_image_fd_,
                               image_filenames_,
-                              oat_filenames_)) {
+                              oat_filenames_,
+                              thread_count_)) {
       LOG(ERROR) << "Failure during image file creation";
       return false;
     }
@@ -2758,6 +2841,9 @@ class Dex2Oat final {
   std::string input_vdex_;
   std::string output_vdex_;
   std::unique_ptr<VdexFile> input_vdex_file_;
+  std::string input_compiled_methods_;
+  std::string output_compiled_methods_;
+  std::string compiled_method_cache_dir_;
   int dm_fd_;
   std::string dm_file_location_;
   std::unique_ptr<ZipArchive> dm_file_;
@@ -2787,6 +2873,7 @@ class Dex2Oat final {
   std::vector<std::unique_ptr<OutputStream>> vdex_out_;
   std::unique_ptr<linker::ImageWriter> image_writer_;
   std::unique_ptr<CompilerDriver> driver_;
+  std::unique_ptr<CompiledMethodCache> compiled_method_cache_;
 
   std::vector<MemMap> opened_dex_files_maps_;
   std::vector<std::unique_ptr<const DexFile>> opened_dex_files_;
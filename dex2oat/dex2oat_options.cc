@@ -86,6 +86,15 @@ static void AddGeneratedArtifactMappings(Builder& builder) {
       .Define("--output-vdex=_")
           .WithType<std::string>()
           .IntoKey(M::OutputVdex)
+      .Define("--input-compiled-methods=_")
+          .WithType<std::string>()
+          .IntoKey(M::InputCompiledMethods)
+      .Define("--output-compiled-methods=_")
+          .WithType<std::string>()
+          .IntoKey(M::OutputCompiledMethods)
+      .Define("--compiled-method-cache-dir=_")
+          .WithType<std::string>()
+          .IntoKey(M::CompiledMethodCacheDir)
       .Define("--dm-fd=_")
           .WithType<int>()
           .IntoKey(M::DmFd)
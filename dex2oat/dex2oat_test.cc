@@ -20,6 +20,7 @@
 #include <string>
 #include <vector>
 
+#include <sys/stat.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
@@ -1327,6 +1328,194 @@ TEST_F(Dex2oatDeterminism, UnloadCompile) {
   EXPECT_GT(app_image_file->GetLength(), 0u);
 }
 
+// Test that laying out dex files on several threads converts them to the same compact dex files
+// as a single-threaded compilation.
+TEST_F(Dex2oatDeterminism, ParallelDexLayout) {
+  if (!kUseReadBarrier &&
+      gc::kCollectorTypeDefault != gc::kCollectorTypeCMS &&
+      gc::kCollectorTypeDefault != gc::kCollectorTypeMS) {
+    LOG(INFO) << "Test requires determinism support.";
+    return;
+  }
+  using Hotness = ProfileCompilationInfo::MethodHotness;
+  // Several input files, one of them with several dex files, with a profile for each dex file.
+  std::vector<std::string> dex_locations;
+  ProfileCompilationInfo info;
+  for (const char* dex_name : {"MultiDex", "ManyMethods", "Statics"}) {
+    dex_locations.push_back(GetTestDexFileName(dex_name));
+    for (const std::unique_ptr<const DexFile>& dex : OpenTestDexFiles(dex_name)) {
+      std::string profile_key = ProfileCompilationInfo::GetProfileDexFileKey(dex->GetLocation());
+      for (ClassAccessor accessor : dex->GetClasses()) {
+        info.AddClassIndex(profile_key,
+                           dex->GetLocationChecksum(),
+                           accessor.GetClassIdx(),
+                           dex->NumMethodIds());
+      }
+      std::vector<uint16_t> startup_methods;
+      for (uint32_t method_idx = 0; method_idx < dex->NumMethodIds(); method_idx += 2u) {
+        startup_methods.push_back(method_idx);
+      }
+      info.AddMethodsForDex(static_cast<Hotness::Flag>(Hotness::kFlagHot | Hotness::kFlagStartup),
+                            dex.get(),
+                            startup_methods.begin(),
+                            startup_methods.end());
+    }
+  }
+  ScratchFile profile_file;
+  ASSERT_TRUE(info.Save(profile_file.GetFd()));
+
+  std::unique_ptr<File> oat_files[2];
+  std::unique_ptr<File> vdex_files[2];
+  for (size_t i = 0; i != 2u; ++i) {
+    const std::string base_name = GetScratchDir() + (i == 0u ? "/layout-j1" : "/layout-j4");
+    const std::string oat_location = base_name + ".oat";
+    std::string error_msg;
+    const int res = GenerateOdexForTestWithStatus(
+        dex_locations,
+        oat_location,
+        CompilerFilter::Filter::kSpeedProfile,
+        &error_msg,
+        {"--compact-dex-level=fast",
+         "--profile-file=" + profile_file.GetFilename(),
+         "--force-determinism",
+         "--avoid-storing-invocation",
+         i == 0u ? "-j1" : "-j4"});
+    ASSERT_EQ(res, 0) << error_msg;
+    std::unique_ptr<OatFile> odex_file(OatFile::Open(/*zip_fd=*/ -1,
+                                                     oat_location.c_str(),
+                                                     oat_location.c_str(),
+                                                     /*executable=*/ false,
+                                                     /*low_4gb=*/ false,
+                                                     /*abs_dex_location=*/ nullptr,
+                                                     /*reservation=*/ nullptr,
+                                                     &error_msg));
+    ASSERT_TRUE(odex_file != nullptr) << error_msg;
+    ASSERT_LT(2u, odex_file->GetOatDexFiles().size());
+    for (const OatDexFile* oat_dex_file : odex_file->GetOatDexFiles()) {
+      std::unique_ptr<const DexFile> dex_file = oat_dex_file->OpenDexFile(&error_msg);
+      ASSERT_TRUE(dex_file != nullptr) << error_msg;
+      EXPECT_TRUE(dex_file->IsCompactDexFile()) << dex_file->GetLocation();
+    }
+    oat_files[i].reset(OS::OpenFileForReading(oat_location.c_str()));
+    vdex_files[i].reset(OS::OpenFileForReading((base_name + ".vdex").c_str()));
+    ASSERT_TRUE(oat_files[i] != nullptr);
+    ASSERT_TRUE(vdex_files[i] != nullptr);
+  }
+  EXPECT_EQ(vdex_files[0]->Compare(vdex_files[1].get()), 0);
+  EXPECT_EQ(oat_files[0]->Compare(oat_files[1].get()), 0);
+}
+
+// Test that the methods recorded with --output-compiled-methods or in a compiled method cache
+// directory are reused by the next compilation, which then writes the same oat file, and that
+// the methods accessing the fields of a class miss once the layout of that class changes.
+TEST_F(Dex2oatDeterminism, CompiledMethodCache) {
+  if (!kUseReadBarrier &&
+      gc::kCollectorTypeDefault != gc::kCollectorTypeCMS &&
+      gc::kCollectorTypeDefault != gc::kCollectorTypeMS) {
+    LOG(INFO) << "Test requires determinism support.";
+    return;
+  }
+  const std::string compiled_methods = GetScratchDir() + "/compiled_methods";
+  const std::string cache_dir = GetScratchDir() + "/compiled_method_cache";
+  ASSERT_EQ(0, mkdir(cache_dir.c_str(), 0700));
+
+  // Compiles `dex_name` to `name`.odex and returns the number of reused methods in `hits`.
+  auto compile = [&](const char* dex_name,
+                     const std::string& name,
+                     const std::string& cache_arg,
+                     /*out*/ size_t* hits) {
+    std::string error_msg;
+    output_.clear();
+    const int res = GenerateOdexForTestWithStatus(
+        {GetTestDexFileName(dex_name)},
+        GetScratchDir() + "/" + name + ".odex",
+        CompilerFilter::Filter::kSpeed,
+        &error_msg,
+        {"--dump-stats", "--force-determinism", "--avoid-storing-invocation", cache_arg});
+    ASSERT_EQ(res, 0) << error_msg << output_;
+    size_t pos = output_.find("Reused ");
+    ASSERT_NE(pos, std::string::npos) << output_;
+    *hits = std::stoul(output_.substr(pos + strlen("Reused ")));
+  };
+  auto compare_oat_files = [&](const std::string& name, const std::string& other_name) {
+    std::unique_ptr<File> oat_file(
+        OS::OpenFileForReading((GetScratchDir() + "/" + name + ".odex").c_str()));
+    std::unique_ptr<File> other_oat_file(
+        OS::OpenFileForReading((GetScratchDir() + "/" + other_name + ".odex").c_str()));
+    ASSERT_TRUE(oat_file != nullptr);
+    ASSERT_TRUE(other_oat_file != nullptr);
+    EXPECT_EQ(oat_file->Compare(other_oat_file.get()), 0) << name << " " << other_name;
+  };
+
+  size_t hits;
+  compile("CompiledMethodsA", "output", "--output-compiled-methods=" + compiled_methods, &hits);
+  EXPECT_EQ(0u, hits);
+
+  size_t input_hits;
+  compile("CompiledMethodsA", "input", "--input-compiled-methods=" + compiled_methods, &input_hits);
+  EXPECT_NE(0u, input_hits);
+  compare_oat_files("output", "input");
+
+  compile("CompiledMethodsA", "dir-empty", "--compiled-method-cache-dir=" + cache_dir, &hits);
+  EXPECT_EQ(0u, hits);
+  compile("CompiledMethodsA", "dir", "--compiled-method-cache-dir=" + cache_dir, &hits);
+  EXPECT_EQ(input_hits, hits);
+  compare_oat_files("output", "dir");
+
+  // Only CompiledMethods.readSecond() reads a field of Fields, whose layout changed.
+  compile("CompiledMethodsC", "changed", "--input-compiled-methods=" + compiled_methods, &hits);
+  EXPECT_EQ(input_hits - 1u, hits);
+}
+
+// Test that methods exceeding the memory budget of the optimizing pipeline are compiled on the
+// baseline pipeline. The memory used for a method depends on the target, so try decreasing
+// budgets until one is exceeded by an optimized compilation but not by the baseline one.
+TEST_F(Dex2oatTest, MethodMemoryBudgetFallsBackToBaseline) {
+  const std::string dex_location = GetScratchDir() + "/ManyMethods.jar";
+  const std::string odex_location = GetOdexDir() + "/ManyMethods.odex";
+  Copy(GetTestDexFileName("ManyMethods"), dex_location);
+  std::regex baseline_regex("OptStat#k?CompiledBaselineBudgetExceeded: [1-9]");
+  bool compiled_baseline = false;
+  for (size_t budget = 64 * KB; budget >= KB && !compiled_baseline; budget /= 2u) {
+    output_.clear();
+    std::string error_msg;
+    const int res = GenerateOdexForTestWithStatus(
+        {dex_location},
+        odex_location,
+        CompilerFilter::Filter::kSpeed,
+        &error_msg,
+        {"--dump-stats", "--method-memory-budget=" + std::to_string(budget)});
+    ASSERT_EQ(res, 0) << error_msg << output_;
+    compiled_baseline = std::regex_search(output_, baseline_regex);
+  }
+  EXPECT_TRUE(compiled_baseline) << output_;
+}
+
+// Test that deterministic compilation ignores the time budget, which depends on the load
+// of the machine.
+TEST_F(Dex2oatTest, MethodCompileTimeBudgetIgnoredForDeterminism) {
+  if (!kUseReadBarrier &&
+      gc::kCollectorTypeDefault != gc::kCollectorTypeCMS &&
+      gc::kCollectorTypeDefault != gc::kCollectorTypeMS) {
+    LOG(INFO) << "Test requires determinism support.";
+    return;
+  }
+  const std::string dex_location = GetScratchDir() + "/ManyMethods.jar";
+  const std::string odex_location = GetOdexDir() + "/ManyMethods.odex";
+  Copy(GetTestDexFileName("ManyMethods"), dex_location);
+  std::string error_msg;
+  const int res = GenerateOdexForTestWithStatus(
+      {dex_location},
+      odex_location,
+      CompilerFilter::Filter::kSpeed,
+      &error_msg,
+      {"--dump-stats", "--force-determinism", "--method-compile-time-budget-ms=1"});
+  ASSERT_EQ(res, 0) << error_msg << output_;
+  EXPECT_NE(output_.find("Ignoring --method-compile-time-budget-ms"), std::string::npos)
+      << output_;
+  EXPECT_EQ(output_.find("BudgetExceeded"), std::string::npos) << output_;
+}
+
 // Test that dexlayout section info is correctly written to the oat file for profile based
 // compilation.
 TEST_F(Dex2oatTest, LayoutSections) {
@@ -0,0 +1,1040 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "compiled_method_cache.h"
+
+#include <inttypes.h>
+#ifndef __APPLE__
+#include <link.h>  // For dl_iterate_phdr.
+#endif
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <set>
+#include <sstream>
+#include <unordered_set>
+
+#include <openssl/sha.h>
+
+#include "android-base/file.h"
+#include "android-base/stringprintf.h"
+
+#include "arch/instruction_set_features.h"
+#include "art_field-inl.h"
+#include "art_method-inl.h"
+#include "base/array_ref.h"
+#include "base/bit_utils.h"
+#include "base/data_hash.h"
+#include "base/logging.h"  // For VLOG.
+#include "base/utils.h"
+#include "class_linker.h"
+#include "compiled_method.h"
+#include "compiler_filter.h"
+#include "dex/code_item_accessors-inl.h"
+#include "dex/dex_file-inl.h"
+#include "dex/dex_file_exception_helpers.h"
+#include "dex/dex_instruction-inl.h"
+#include "driver/compiler_options.h"
+#include "gc/heap.h"
+#include "gc/space/image_space.h"
+#include "handle_scope-inl.h"
+#include "linker/linker_patch.h"
+#include "mirror/class-inl.h"
+#include "mirror/dex_cache-inl.h"
+#include "mirror/iftable-inl.h"
+#include "oat.h"
+#include "profile/profile_compilation_info.h"
+#include "runtime.h"
+#include "thread-current-inl.h"
+
+namespace art {
+
+using android::base::StringPrintf;
+
+// Identifies the format of the file written by Save().
+static constexpr const char kFileMagic[] = "cmc\n002\n";
+
+// Identifies the format of the files holding a single entry in the cache directory.
+static constexpr const char kEntryFileMagic[] = "cme\n002\n";
+
+// Upper bound on the number of methods followed when computing a key, so that the cost of a
+// lookup stays well below the cost of compiling.
+static constexpr size_t kMaxDependentMethods = 1000u;
+
+static std::string GetSignature(const DexFile& dex_file) {
+  const DexFile::Header& header = dex_file.GetHeader();
+  return std::string(reinterpret_cast<const char*>(header.signature_), DexFile::kSha1DigestSize);
+}
+
+// Appends the GNU build IDs of the loaded ELF objects, which identify the compiler binaries.
+// Returns false if there are none.
+static bool AppendBuildIds(std::ostream& os) {
+#ifdef __APPLE__
+  UNUSED(os);
+  return false;
+#else
+  struct dl_iterate_context {
+    static int callback(dl_phdr_info* info, size_t size ATTRIBUTE_UNUSED, void* data) {
+      auto* context = reinterpret_cast<dl_iterate_context*>(data);
+      if (info->dlpi_name != nullptr && strstr(info->dlpi_name, "vdso") != nullptr) {
+        return 0;  // Provided by the kernel.
+      }
+      for (ElfW(Half) i = 0; i < info->dlpi_phnum; ++i) {
+        if (info->dlpi_phdr[i].p_type != PT_NOTE) {
+          continue;
+        }
+        const uint8_t* note = reinterpret_cast<const uint8_t*>(info->dlpi_addr +
+                                                               info->dlpi_phdr[i].p_vaddr);
+        const uint8_t* end = note + info->dlpi_phdr[i].p_memsz;
+        while (static_cast<size_t>(end - note) >= sizeof(ElfW(Nhdr))) {
+          const ElfW(Nhdr)* header = reinterpret_cast<const ElfW(Nhdr)*>(note);
+          const uint8_t* name = note + sizeof(ElfW(Nhdr));
+          const uint8_t* desc = name + RoundUp(header->n_namesz, 4u);
+          note = desc + RoundUp(header->n_descsz, 4u);
+          if (note > end) {
+            break;
+          }
+          if (header->n_type == 3u /* NT_GNU_BUILD_ID */ &&
+              header->n_namesz == 4u &&
+              memcmp(name, "GNU", 4u) == 0) {
+            for (size_t j = 0; j != header->n_descsz; ++j) {
+              *context->os << StringPrintf("%02x", desc[j]);
+            }
+            *context->os << ' ';
+            context->found = true;
+          }
+        }
+      }
+      return 0;  // Continue iteration.
+    }
+
+    std::ostream* const os;
+    bool found = false;
+  };
+  dl_iterate_context context = { &os };
+  dl_iterate_phdr(dl_iterate_context::callback, &context);
+  return context.found;
+#endif
+}
+
+static void AppendUint32(std::string* out, uint32_t value) {
+  out->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void AppendData(std::string* out, ArrayRef<const uint8_t> data) {
+  AppendUint32(out, data.size());
+  out->append(reinterpret_cast<const char*>(data.data()), data.size());
+}
+
+static void AppendString(std::string* out, const std::string& data) {
+  AppendData(out, ArrayRef<const uint8_t>(reinterpret_cast<const uint8_t*>(data.data()),
+                                          data.size()));
+}
+
+// Reads the data written by the functions above. Fails once for reads past the end.
+class DataReader {
+ public:
+  explicit DataReader(const std::string& data) : data_(data), pos_(0u), ok_(true) {}
+
+  uint32_t ReadUint32() {
+    uint32_t value = 0u;
+    if (Check(sizeof(value))) {
+      memcpy(&value, data_.data() + pos_, sizeof(value));
+      pos_ += sizeof(value);
+    }
+    return value;
+  }
+
+  ArrayRef<const uint8_t> ReadBytes(size_t size) {
+    if (!Check(size)) {
+      return ArrayRef<const uint8_t>();
+    }
+    ArrayRef<const uint8_t> bytes(reinterpret_cast<const uint8_t*>(data_.data()) + pos_, size);
+    pos_ += size;
+    return bytes;
+  }
+
+  ArrayRef<const uint8_t> ReadData() {
+    return ReadBytes(ReadUint32());
+  }
+
+  std::string ReadString() {
+    ArrayRef<const uint8_t> bytes = ReadData();
+    return std::string(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+  }
+
+  bool IsOk() const {
+    return ok_;
+  }
+
+  bool AtEnd() const {
+    return pos_ == data_.size();
+  }
+
+ private:
+  bool Check(size_t size) {
+    ok_ = ok_ && size <= data_.size() - pos_;
+    return ok_;
+  }
+
+  const std::string& data_;
+  size_t pos_;
+  bool ok_;
+};
+
+// Builds the key of the code compiled for a method. The key covers the code item of the
+// method and of the callees the compiler may inline, and what each index used by this
+// bytecode resolves to: the strings, the classes with their access flags and status, the
+// fields with their offsets, and the methods with their vtable or IMT index.
+//
+// Compiled code also embeds indices that do not appear in the bytecode, such as the type
+// index of the declaring class of a resolved field or the method index of an inlined callee.
+// These are recorded relative to the dex file of the compiled method. The key, like the
+// bytecode it hashes, thus depends on the indices of the dex file: a method is only reused
+// from a different dex file if its references have the same indices there, which is not the
+// case for a library merged into another app's dex file. Entities in other dex files outside
+// of the boot class path are recorded with the signature of their dex file.
+//
+// The references of each method are resolved before they are described, as the compiler
+// resolves them when building the graph. A reference is described as unresolved only if it
+// cannot be resolved at all, in which case the compiler cannot resolve it either.
+class KeyBuilder {
+ public:
+  KeyBuilder(const CompilerOptions& compiler_options, ClassLinker* class_linker, Thread* self)
+      : compiler_options_(compiler_options),
+        class_linker_(class_linker),
+        pointer_size_(class_linker->GetImagePointerSize()),
+        self_(self),
+        handles_(self),
+        dex_file_(nullptr) {}
+
+  // Returns false if the code of `method` must not be reused.
+  bool Build(ArtMethod* method, /*out*/ std::string* key) REQUIRES_SHARED(Locks::mutator_lock_) {
+    dex_file_ = method->GetDexFile();
+    std::string record;
+    visited_methods_.insert(method);
+    if (!DescribeMethodCode(method, /* is_root= */ true, &record)) {
+      return false;
+    }
+    while (!worklist_.empty()) {
+      while (!worklist_.empty()) {
+        ArtMethod* m = worklist_.back();
+        worklist_.pop_back();
+        std::string callee_record;
+        if (!DescribeMethodCode(m, /* is_root= */ false, &callee_record)) {
+          return false;
+        }
+        callee_records_.insert(std::move(callee_record));
+      }
+      // A virtual call may be devirtualized to any override in a class known to the compiler,
+      // and that override inlined.
+      std::vector<ArtMethod*> virtual_callees(virtual_callees_.begin(), virtual_callees_.end());
+      for (ObjPtr<mirror::Class> klass : classes_) {
+        if (klass->IsInterface() || klass->IsArrayClass() || klass->IsPrimitive()) {
+          continue;
+        }
+        for (ArtMethod* callee : virtual_callees) {
+          ObjPtr<mirror::Class> declaring_class = callee->GetDeclaringClass();
+          bool is_subtype = declaring_class->IsInterface() ? klass->Implements(declaring_class)
+                                                           : klass->IsSubClass(declaring_class);
+          if (is_subtype) {
+            AddCallee(klass->FindVirtualMethodForVirtualOrInterface(callee, pointer_size_));
+          }
+        }
+      }
+      if (visited_methods_.size() > kMaxDependentMethods) {
+        return false;
+      }
+    }
+    // The callees are visited in no particular order. Sort their records to keep the key
+    // deterministic.
+    SHA256_CTX ctx;
+    SHA256_Init(&ctx);
+    AppendUint32(&record, callee_records_.size());
+    SHA256_Update(&ctx, record.data(), record.size());
+    for (const std::string& callee_record : callee_records_) {
+      std::string size;
+      AppendUint32(&size, callee_record.size());
+      SHA256_Update(&ctx, size.data(), size.size());
+      SHA256_Update(&ctx, callee_record.data(), callee_record.size());
+    }
+    uint8_t digest[SHA256_DIGEST_LENGTH];
+    SHA256_Final(digest, &ctx);
+    key->assign(reinterpret_cast<const char*>(digest), sizeof(digest));
+    return true;
+  }
+
+ private:
+  // Describes the code of `method` and everything its bytecode refers to. The location of
+  // the compiled method itself is left out as its code does not refer to it.
+  bool DescribeMethodCode(ArtMethod* method, bool is_root, /*out*/ std::string* out)
+      REQUIRES_SHARED(Locks::mutator_lock_) {
+    DescribeMethod(method, /* with_location= */ !is_root, out);
+    const DexFile& dex_file = *method->GetDexFile();
+    const ProfileCompilationInfo* profile = compiler_options_.GetProfileCompilationInfo();
+    if (profile != nullptr) {
+      std::unique_ptr<ProfileCompilationInfo::OfflineProfileMethodInfo> info =
+          profile->GetMethod(dex_file.GetLocation(),
+                             dex_file.GetLocationChecksum(),
+                             method->GetDexMethodIndex());
+      if (info != nullptr && info->inline_caches != nullptr && !info->inline_caches->empty()) {
+        return false;
+      }
+    }
+    if (method->IsNative() || method->IsAbstract() || method->GetCodeItem() == nullptr) {
+      return true;
+    }
+    if (!ResolveReferences(method)) {
+      return false;
+    }
+    CodeItemDataAccessor accessor(method->DexInstructionData());
+    AppendUint32(out, accessor.RegistersSize());
+    AppendUint32(out, accessor.InsSize());
+    AppendUint32(out, accessor.OutsSize());
+    AppendData(out, ArrayRef<const uint8_t>(
+        reinterpret_cast<const uint8_t*>(accessor.Insns()),
+        accessor.InsnsSizeInCodeUnits() * sizeof(uint16_t)));
+    AppendUint32(out, accessor.TriesSize());
+    for (const dex::TryItem& try_item : accessor.TryItems()) {
+      AppendUint32(out, try_item.start_addr_);
+      AppendUint32(out, try_item.insn_count_);
+      for (CatchHandlerIterator it(accessor, try_item); it.HasNext(); it.Next()) {
+        AppendUint32(out, it.GetHandlerAddress());
+        if (it.GetHandlerTypeIndex().IsValid()) {
+          DescribeType(method, it.GetHandlerTypeIndex(), out);
+        } else {
+          out->push_back('*');  // Catch all.
+        }
+      }
+      out->push_back(';');
+    }
+    for (const DexInstructionPcPair& inst : method->DexInstructions()) {
+      Instruction::Code opcode = inst->Opcode();
+      switch (Instruction::IndexTypeOf(opcode)) {
+        case Instruction::kIndexNone:
+          break;
+        case Instruction::kIndexTypeRef:
+          DescribeType(method, dex::TypeIndex(GetIndex(inst.Inst())), out);
+          break;
+        case Instruction::kIndexStringRef:
+          out->append(dex_file.StringDataByIdx(dex::StringIndex(GetIndex(inst.Inst()))));
+          out->push_back(';');
+          break;
+        case Instruction::kIndexFieldRef: {
+          bool is_static = opcode >= Instruction::SGET && opcode <= Instruction::SPUT_SHORT;
+          DescribeFieldRef(method, GetIndex(inst.Inst()), is_static, out);
+          break;
+        }
+        case Instruction::kIndexMethodRef:
+          DescribeInvoke(method, GetIndex(inst.Inst()), opcode, out);
+          break;
+        default:
+          // Quickened instructions and the method handle and call site references are rare.
+          // Do not bother describing them.
+          return false;
+      }
+    }
+    return true;
+  }
+
+  // Resolves the types, fields and methods referenced by the code of `method`, including the
+  // types of the fields and the prototypes of the methods, so that the descriptions below
+  // do not depend on what other threads happened to resolve. Returns false if the code uses
+  // references which are not described, like DescribeMethodCode().
+  bool ResolveReferences(ArtMethod* method) REQUIRES_SHARED(Locks::mutator_lock_) {
+    const DexFile& dex_file = *method->GetDexFile();
+    CodeItemDataAccessor accessor(method->DexInstructionData());
+    for (const dex::TryItem& try_item : accessor.TryItems()) {
+      for (CatchHandlerIterator it(accessor, try_item); it.HasNext(); it.Next()) {
+        if (it.GetHandlerTypeIndex().IsValid()) {
+          ResolveType(method, it.GetHandlerTypeIndex());
+        }
+      }
+    }
+    StackHandleScope<2> hs(self_);
+    Handle<mirror::DexCache> dex_cache(hs.NewHandle(method->GetDexCache()));
+    Handle<mirror::ClassLoader> class_loader(hs.NewHandle(method->GetClassLoader()));
+    for (const DexInstructionPcPair& inst : method->DexInstructions()) {
+      Instruction::Code opcode = inst->Opcode();
+      switch (Instruction::IndexTypeOf(opcode)) {
+        case Instruction::kIndexNone:
+        case Instruction::kIndexStringRef:
+          break;
+        case Instruction::kIndexTypeRef:
+          ResolveType(method, dex::TypeIndex(GetIndex(inst.Inst())));
+          break;
+        case Instruction::kIndexFieldRef: {
+          uint32_t field_idx = GetIndex(inst.Inst());
+          bool is_static = opcode >= Instruction::SGET && opcode <= Instruction::SPUT_SHORT;
+          const dex::FieldId& field_id = dex_file.GetFieldId(field_idx);
+          ResolveType(method, field_id.class_idx_);
+          ResolveType(method, field_id.type_idx_);
+          if (class_linker_->ResolveField(field_idx, method, is_static) == nullptr) {
+            self_->ClearException();
+          }
+          break;
+        }
+        case Instruction::kIndexMethodRef: {
+          uint32_t method_idx = GetIndex(inst.Inst());
+          const dex::MethodId& method_id = dex_file.GetMethodId(method_idx);
+          const dex::ProtoId& proto_id = dex_file.GetProtoId(method_id.proto_idx_);
+          ResolveType(method, method_id.class_idx_);
+          ResolveType(method, proto_id.return_type_idx_);
+          const dex::TypeList* params = dex_file.GetProtoParameters(proto_id);
+          if (params != nullptr) {
+            for (uint32_t i = 0; i != params->Size(); ++i) {
+              ResolveType(method, params->GetTypeItem(i).type_idx_);
+            }
+          }
+          if (class_linker_->ResolveMethodWithoutInvokeType(
+                  method_idx, dex_cache, class_loader) == nullptr) {
+            self_->ClearException();
+          }
+          break;
+        }
+        default:
+          return false;
+      }
+    }
+    // Resolution may have suspended the thread and let the GC move the classes seen so far.
+    classes_.clear();
+    for (Handle<mirror::Class> klass : class_handles_) {
+      classes_.insert(klass.Get());
+    }
+    return true;
+  }
+
+  void ResolveType(ArtMethod* method, dex::TypeIndex type_idx)
+      REQUIRES_SHARED(Locks::mutator_lock_) {
+    if (class_linker_->ResolveType(type_idx, method) == nullptr) {
+      // Leave the type unresolved, as the compiler does.
+      self_->ClearException();
+    }
+  }
+
+  static uint32_t GetIndex(const Instruction& inst) {
+    return (Instruction::FormatOf(inst.Opcode()) == Instruction::k22c) ? inst.VRegC()
+                                                                       : inst.VRegB();
+  }
+
+  void DescribeInvoke(ArtMethod* caller,
+                      uint32_t method_idx,
+                      Instruction::Code opcode,
+                      /*out*/ std::string* out) REQUIRES_SHARED(Locks::mutator_lock_) {
+    const DexFile& dex_file = *caller->GetDexFile();
+    const dex::MethodId& method_id = dex_file.GetMethodId(method_idx);
+    const dex::ProtoId& proto_id = dex_file.GetProtoId(method_id.proto_idx_);
+    DescribeType(caller, method_id.class_idx_, out);
+    DescribeType(caller, proto_id.return_type_idx_, out);
+    const dex::TypeList* params = dex_file.GetProtoParameters(proto_id);
+    if (params != nullptr) {
+      for (uint32_t i = 0; i != params->Size(); ++i) {
+        DescribeType(caller, params->GetTypeItem(i).type_idx_, out);
+      }
+    }
+    ArtMethod* callee =
+        class_linker_->LookupResolvedMethod(method_idx, caller->GetDexCache(),
+                                            caller->GetClassLoader());
+    if (callee == nullptr) {
+      out->append("?");
+      out->append(dex_file.GetMethodName(method_id));
+      out->append(dex_file.GetMethodSignature(method_id).ToString());
+      out->push_back(';');
+      return;
+    }
+    DescribeMethod(callee, /* with_location= */ true, out);
+    AddCallee(callee);
+    bool is_virtual = opcode == Instruction::INVOKE_VIRTUAL ||
+                      opcode == Instruction::INVOKE_VIRTUAL_RANGE ||
+                      opcode == Instruction::INVOKE_INTERFACE ||
+                      opcode == Instruction::INVOKE_INTERFACE_RANGE;
+    if (is_virtual) {
+      virtual_callees_.insert(callee);
+    }
+  }
+
+  void DescribeFieldRef(ArtMethod* method,
+                        uint32_t field_idx,
+                        bool is_static,
+                        /*out*/ std::string* out) REQUIRES_SHARED(Locks::mutator_lock_) {
+    const DexFile& dex_file = *method->GetDexFile();
+    const dex::FieldId& field_id = dex_file.GetFieldId(field_idx);
+    DescribeType(method, field_id.class_idx_, out);
+    DescribeType(method, field_id.type_idx_, out);
+    ArtField* field = class_linker_->LookupResolvedField(field_idx, method, is_static);
+    if (field == nullptr) {
+      out->append("?");
+      out->append(dex_file.GetFieldName(field_id));
+      out->push_back(';');
+      return;
+    }
+    DescribeClass(field->GetDeclaringClass(), out);
+    out->append(field->GetName());
+    out->push_back(';');
+    AppendUint32(out, field->GetAccessFlags());
+    AppendUint32(out, field->GetOffset().Uint32Value());
+  }
+
+  void DescribeType(ArtMethod* method, dex::TypeIndex type_idx, /*out*/ std::string* out)
+      REQUIRES_SHARED(Locks::mutator_lock_) {
+    ObjPtr<mirror::Class> klass = class_linker_->LookupResolvedType(type_idx, method);
+    if (klass == nullptr) {
+      // ResolveReferences() failed to resolve the type.
+      out->append("?");
+      out->append(method->GetDexFile()->StringByTypeIdx(type_idx));
+      out->push_back(';');
+      return;
+    }
+    DescribeClass(klass, out);
+  }
+
+  void DescribeClass(ObjPtr<mirror::Class> klass, /*out*/ std::string* out)
+      REQUIRES_SHARED(Locks::mutator_lock_) {
+    AddClass(klass);
+    while (klass->IsArrayClass()) {
+      out->push_back('[');
+      klass = klass->GetComponentType();
+    }
+    std::string temp;
+    out->append(klass->GetDescriptor(&temp));
+    if (klass->IsPrimitive()) {
+      return;
+    }
+    AppendUint32(out, klass->GetAccessFlags());
+    AppendUint32(out, static_cast<uint32_t>(klass->GetStatus()));
+    if (!klass->IsProxyClass()) {
+      DescribeLocation(klass, klass->GetDexFile(), klass->GetDexTypeIndex().index_, out);
+    }
+  }
+
+  void DescribeMethod(ArtMethod* method, bool with_location, /*out*/ std::string* out)
+      REQUIRES_SHARED(Locks::mutator_lock_) {
+    DescribeClass(method->GetDeclaringClass(), out);
+    out->append(method->GetName());
+    out->append(method->GetSignature().ToString());
+    AppendUint32(out, method->GetAccessFlags());
+    if (!method->IsStatic() && !method->IsDirect()) {
+      AppendUint32(out, method->GetDeclaringClass()->IsInterface() ? method->GetImtIndex()
+                                                                   : method->GetMethodIndex());
+    }
+    if (with_location) {
+      DescribeLocation(method->GetDeclaringClass(),
+                       *method->GetDexFile(),
+                       method->GetDexMethodIndex(),
+                       out);
+    }
+  }
+
+  // Describes where the entity with `index` in `dex_file`, defined by `klass` or one of its
+  // members, comes from, as compiled code may refer to it by that index.
+  void DescribeLocation(ObjPtr<mirror::Class> klass,
+                        const DexFile& dex_file,
+                        uint32_t index,
+                        /*out*/ std::string* out) REQUIRES_SHARED(Locks::mutator_lock_) {
+    if (&dex_file == dex_file_) {
+      out->push_back('=');
+      AppendUint32(out, index);
+    } else if (!klass->IsBootStrapClassLoaded()) {
+      // The boot class path is covered by the fingerprint.
+      out->append(GetSignature(dex_file));
+      AppendUint32(out, index);
+    }
+  }
+
+  void AddCallee(ArtMethod* callee) REQUIRES_SHARED(Locks::mutator_lock_) {
+    if (callee == nullptr || visited_methods_.count(callee) != 0u) {
+      return;
+    }
+    // Only methods the inliner accepts can contribute code. Other callees are described
+    // by the invoke.
+    if (!callee->IsNative() && !callee->IsAbstract() && callee->GetCodeItem() != nullptr &&
+        callee->DexInstructions().InsnsSizeInCodeUnits() <=
+            compiler_options_.GetInlineMaxCodeUnits()) {
+      visited_methods_.insert(callee);
+      worklist_.push_back(callee);
+    }
+  }
+
+  void AddClass(ObjPtr<mirror::Class> klass) REQUIRES_SHARED(Locks::mutator_lock_) {
+    while (klass != nullptr && klass->IsArrayClass()) {
+      klass = klass->GetComponentType();
+    }
+    if (klass == nullptr || klass->IsPrimitive() || !classes_.insert(klass.Ptr()).second) {
+      return;
+    }
+    class_handles_.push_back(handles_.NewHandle(klass));
+    AddClass(klass->GetSuperClass());
+    for (int32_t i = 0, count = klass->GetIfTableCount(); i != count; ++i) {
+      AddClass(klass->GetIfTable()->GetInterface(i));
+    }
+  }
+
+  const CompilerOptions& compiler_options_;
+  ClassLinker* const class_linker_;
+  const PointerSize pointer_size_;
+  Thread* const self_;
+  VariableSizedHandleScope handles_;
+  const DexFile* dex_file_;
+
+  std::vector<ArtMethod*> worklist_;
+  std::unordered_set<ArtMethod*> visited_methods_;
+  std::unordered_set<ArtMethod*> virtual_callees_;
+  // The classes seen so far. `classes_` is rebuilt from the handles whenever the thread may
+  // have been suspended.
+  std::vector<Handle<mirror::Class>> class_handles_;
+  std::unordered_set<mirror::Class*> classes_;
+  std::set<std::string> callee_records_;
+};
+
+CompiledMethodCache::CompiledMethodCache(const CompilerOptions& compiler_options,
+                                         CompiledMethodStorage* storage)
+    : compiler_options_(compiler_options),
+      storage_(storage),
+      record_entries_(false),
+      lock_("compiled method cache lock"),
+      number_of_hits_(0u) {}
+
+CompiledMethodCache::~CompiledMethodCache() {}
+
+bool CompiledMethodCache::Load(const std::string& filename, std::string* error_msg) {
+  std::string data;
+  if (!android::base::ReadFileToString(filename, &data)) {
+    *error_msg = StringPrintf("Failed to read %s: %s", filename.c_str(), strerror(errno));
+    return false;
+  }
+  DataReader reader(data);
+  ArrayRef<const uint8_t> magic = reader.ReadBytes(sizeof(kFileMagic) - 1u);
+  if (!reader.IsOk() || memcmp(magic.data(), kFileMagic, magic.size()) != 0) {
+    *error_msg = StringPrintf("Invalid compiled method cache file %s", filename.c_str());
+    return false;
+  }
+  loaded_fingerprint_ = reader.ReadString();
+  while (reader.IsOk() && !reader.AtEnd()) {
+    std::string key = reader.ReadString();
+    std::string entry = reader.ReadString();
+    loaded_entries_.emplace(std::move(key), std::move(entry));
+  }
+  if (!reader.IsOk()) {
+    *error_msg = StringPrintf("Truncated compiled method cache file %s", filename.c_str());
+    loaded_entries_.clear();
+    return false;
+  }
+  return true;
+}
+
+bool CompiledMethodCache::Save(const std::string& filename, std::string* error_msg) const {
+  std::string data(kFileMagic, sizeof(kFileMagic) - 1u);
+  AppendString(&data, fingerprint_);
+  {
+    MutexLock mu(Thread::Current(), lock_);
+    // Sort the entries to keep the file deterministic.
+    std::vector<const std::pair<const std::string, std::string>*> entries;
+    entries.reserve(entries_.size());
+    for (const auto& entry : entries_) {
+      entries.push_back(&entry);
+    }
+    std::sort(entries.begin(), entries.end(), [](const auto* lhs, const auto* rhs) {
+      return lhs->first < rhs->first;
+    });
+    for (const auto* entry : entries) {
+      AppendString(&data, entry->first);
+      AppendString(&data, entry->second);
+    }
+  }
+  if (!android::base::WriteStringToFile(data, filename)) {
+    *error_msg = StringPrintf("Failed to write %s: %s", filename.c_str(), strerror(errno));
+    return false;
+  }
+  return true;
+}
+
+void CompiledMethodCache::Prepare(const std::string& class_loader_context) {
+  Runtime* runtime = Runtime::Current();
+  std::ostringstream oss;
+  if (runtime == nullptr ||
+      compiler_options_.IsBootImage() ||
+      compiler_options_.GetPassesToRun() != nullptr ||
+      !AppendBuildIds(oss)) {
+    fingerprint_.clear();
+    loaded_entries_.clear();
+    return;
+  }
+  ClassLinker* class_linker = runtime->GetClassLinker();
+  oss << OatHeader::kOatVersion
+      << ' ' << GetInstructionSetString(compiler_options_.GetInstructionSet())
+      << ' ' << compiler_options_.GetInstructionSetFeatures()->GetFeatureString()
+      << ' ' << CompilerFilter::NameOfFilter(compiler_options_.GetCompilerFilter())
+      << ' ' << compiler_options_.GetDebuggable()
+      << compiler_options_.GetGenerateDebugInfo()
+      << compiler_options_.GetGenerateMiniDebugInfo()
+      << compiler_options_.GetImplicitNullChecks()
+      << compiler_options_.GetImplicitStackOverflowChecks()
+      << compiler_options_.GetImplicitSuspendChecks()
+      << compiler_options_.IsBaseline()
+      << compiler_options_.GetCompilePic()
+      << compiler_options_.IsAppImage()
+      << compiler_options_.CompilingWithCoreImage()
+      << compiler_options_.CountHotnessInCompiledCode()
+      << compiler_options_.ResolveStartupConstStrings()
+      << compiler_options_.IsForceDeterminism()
+      << ' ' << static_cast<int>(compiler_options_.GetRegisterAllocationStrategy())
+      << ' ' << compiler_options_.GetInlineMaxCodeUnits()
+      << ' ' << compiler_options_.GetHugeMethodThreshold()
+      << ' ' << compiler_options_.GetLargeMethodThreshold()
+      << ' ' << compiler_options_.GetSmallMethodThreshold()
+      << ' ' << compiler_options_.GetTinyMethodThreshold()
+      << ' ' << compiler_options_.GetNumDexMethodsThreshold()
+      << ' ' << compiler_options_.GetMethodCompileTimeBudgetMs()
+      << ' ' << compiler_options_.GetMethodMemoryBudget()
+      << ' ' << gc::space::ImageSpace::GetBootClassPathChecksums(
+                    runtime->GetHeap()->GetBootImageSpaces(), class_linker->GetBootClassPath())
+      << ' ' << class_loader_context;
+  for (const DexFile* dex_file : compiler_options_.GetNoInlineFromDexFile()) {
+    oss << " no-inline:" << GetSignature(*dex_file);
+  }
+  if (compiler_options_.IsAppImage()) {
+    // Classes in the app image may be referenced differently.
+    std::vector<std::string> image_classes(compiler_options_.GetImageClasses().begin(),
+                                           compiler_options_.GetImageClasses().end());
+    std::sort(image_classes.begin(), image_classes.end());
+    for (const std::string& descriptor : image_classes) {
+      oss << ' ' << descriptor;
+    }
+  }
+  fingerprint_ = oss.str();
+  if (fingerprint_ != loaded_fingerprint_) {
+    VLOG(compiler) << "Not reusing " << loaded_entries_.size() << " compiled methods"
+                   << " from a different compiler or a compilation with different options";
+    loaded_entries_.clear();
+  }
+
+  // Dex files compiled individually are unloaded between calls.
+  dex_files_by_signature_.clear();
+  Thread* self = Thread::Current();
+  ReaderMutexLock mu(self, *Locks::dex_lock_);
+  for (const ClassLinker::DexCacheData& data : class_linker->GetDexCachesData()) {
+    if (!data.IsValid()) {
+      continue;
+    }
+    auto it = dex_files_by_signature_.emplace(GetSignature(*data.dex_file), data.dex_file).first;
+    if (it->second != data.dex_file) {
+      // The same dex file is opened more than once. The linker patches would be ambiguous.
+      it->second = nullptr;
+    }
+  }
+}
+
+std::string CompiledMethodCache::ComputeKey(ArtMethod* method) const {
+  if (fingerprint_.empty()) {
+    return std::string();
+  }
+  KeyBuilder builder(compiler_options_, Runtime::Current()->GetClassLinker(), Thread::Current());
+  std::string key;
+  if (!builder.Build(method, &key)) {
+    return std::string();
+  }
+  return key;
+}
+
+void CompiledMethodCache::SetDirectory(const std::string& directory) {
+  directory_ = directory;
+}
+
+CompiledMethod* CompiledMethodCache::Lookup(const std::string& key, const DexFile& dex_file) {
+  CompiledMethod* compiled_method = nullptr;
+  auto it = loaded_entries_.find(key);
+  if (it != loaded_entries_.end()) {
+    compiled_method = Deserialize(it->second, dex_file);
+  } else if (!directory_.empty()) {
+    std::string data;
+    if (ReadEntryFile(key, &data)) {
+      compiled_method = Deserialize(data, dex_file);
+    }
+  }
+  if (compiled_method != nullptr) {
+    MutexLock mu(Thread::Current(), lock_);
+    ++number_of_hits_;
+  }
+  return compiled_method;
+}
+
+void CompiledMethodCache::Insert(const std::string& key,
+                                 const DexFile& dex_file,
+                                 const CompiledMethod* compiled_method) {
+  if (!record_entries_ && directory_.empty()) {
+    return;
+  }
+  std::string data = Serialize(compiled_method, dex_file);
+  if (!directory_.empty()) {
+    WriteEntryFile(key, data);
+  }
+  if (record_entries_) {
+    MutexLock mu(Thread::Current(), lock_);
+    entries_.emplace(key, std::move(data));
+  }
+}
+
+std::string CompiledMethodCache::GetEntryFilename(const std::string& full_key) const {
+  // Two independent hashes make collisions unlikely enough for the file name. The file
+  // holds the full key, so a collision only costs a miss.
+  uint32_t hash1 = DataHash()(full_key);
+  uint64_t hash2 = HashBytes(reinterpret_cast<const uint8_t*>(full_key.data()), full_key.size());
+  std::string name = StringPrintf("%08x%016" PRIx64, hash1, hash2);
+  // Spread the entries over subdirectories to keep directories small.
+  return directory_ + "/" + name.substr(0, 2) + "/" + name.substr(2);
+}
+
+bool CompiledMethodCache::ReadEntryFile(const std::string& key, /*out*/ std::string* data) const {
+  std::string full_key = fingerprint_ + key;
+  std::string contents;
+  if (!android::base::ReadFileToString(GetEntryFilename(full_key), &contents)) {
+    return false;
+  }
+  DataReader reader(contents);
+  ArrayRef<const uint8_t> magic = reader.ReadBytes(sizeof(kEntryFileMagic) - 1u);
+  if (!reader.IsOk() || memcmp(magic.data(), kEntryFileMagic, magic.size()) != 0) {
+    return false;
+  }
+  if (reader.ReadString() != full_key) {
+    return false;
+  }
+  *data = reader.ReadString();
+  return reader.IsOk() && reader.AtEnd();
+}
+
+void CompiledMethodCache::WriteEntryFile(const std::string& key, const std::string& data) const {
+  std::string existing_data;
+  if (ReadEntryFile(key, &existing_data) && existing_data == data) {
+    return;
+  }
+  // Replace entries that are corrupt, or that were written for a different key with the same
+  // file name, e.g. by a different compiler.
+  std::string full_key = fingerprint_ + key;
+  std::string filename = GetEntryFilename(full_key);
+  std::string contents(kEntryFileMagic, sizeof(kEntryFileMagic) - 1u);
+  AppendString(&contents, full_key);
+  AppendString(&contents, data);
+  std::string subdirectory = filename.substr(0, filename.rfind('/'));
+  if (mkdir(subdirectory.c_str(), 0755) != 0 && errno != EEXIST) {
+    PLOG(WARNING) << "Failed to create " << subdirectory;
+    return;
+  }
+  // Other processes may share the directory. Write to a temporary file first so that they
+  // never see a partial entry.
+  std::string temp_filename = StringPrintf("%s.%d.tmp", filename.c_str(), GetTid());
+  if (!android::base::WriteStringToFile(contents, temp_filename) ||
+      rename(temp_filename.c_str(), filename.c_str()) != 0) {
+    PLOG(WARNING) << "Failed to write " << filename;
+    unlink(temp_filename.c_str());
+  }
+}
+
+size_t CompiledMethodCache::GetNumberOfHits() const {
+  MutexLock mu(Thread::Current(), lock_);
+  return number_of_hits_;
+}
+
+// Patch targets in the dex file of the compiled method are recorded with an empty signature.
+void CompiledMethodCache::SerializeTargetDexFile(const DexFile* target_dex_file,
+                                                 const DexFile& dex_file,
+                                                 /*out*/ std::string* out) const {
+  AppendString(out, target_dex_file != &dex_file ? GetSignature(*target_dex_file) : std::string());
+}
+
+const DexFile* CompiledMethodCache::DeserializeTargetDexFile(const std::string& signature,
+                                                             const DexFile& dex_file) const {
+  if (signature.empty()) {
+    return &dex_file;
+  }
+  auto it = dex_files_by_signature_.find(signature);
+  return (it != dex_files_by_signature_.end()) ? it->second : nullptr;
+}
+
+std::string CompiledMethodCache::Serialize(const CompiledMethod* compiled_method,
+                                           const DexFile& dex_file) const {
+  std::string data;
+  AppendUint32(&data, static_cast<uint32_t>(compiled_method->GetInstructionSet()));
+  AppendUint32(&data, compiled_method->IsIntrinsic() ? 1u : 0u);
+  AppendData(&data, compiled_method->GetQuickCode());
+  AppendData(&data, compiled_method->GetVmapTable());
+  AppendData(&data, compiled_method->GetCFIInfo());
+  ArrayRef<const linker::LinkerPatch> patches = compiled_method->GetPatches();
+  AppendUint32(&data, patches.size());
+  for (const linker::LinkerPatch& patch : patches) {
+    AppendUint32(&data, static_cast<uint32_t>(patch.GetType()));
+    AppendUint32(&data, patch.LiteralOffset());
+    switch (patch.GetType()) {
+      case linker::LinkerPatch::Type::kIntrinsicReference:
+        AppendUint32(&data, patch.PcInsnOffset());
+        AppendUint32(&data, patch.IntrinsicData());
+        break;
+      case linker::LinkerPatch::Type::kDataBimgRelRo:
+        AppendUint32(&data, patch.PcInsnOffset());
+        AppendUint32(&data, patch.BootImageOffset());
+        break;
+      case linker::LinkerPatch::Type::kMethodRelative:
+      case linker::LinkerPatch::Type::kMethodBssEntry:
+        SerializeTargetDexFile(patch.TargetMethod().dex_file, dex_file, &data);
+        AppendUint32(&data, patch.PcInsnOffset());
+        AppendUint32(&data, patch.TargetMethod().index);
+        break;
+      case linker::LinkerPatch::Type::kCallRelative:
+        SerializeTargetDexFile(patch.TargetMethod().dex_file, dex_file, &data);
+        AppendUint32(&data, patch.TargetMethod().index);
+        break;
+      case linker::LinkerPatch::Type::kTypeRelative:
+      case linker::LinkerPatch::Type::kTypeBssEntry:
+        SerializeTargetDexFile(patch.TargetTypeDexFile(), dex_file, &data);
+        AppendUint32(&data, patch.PcInsnOffset());
+        AppendUint32(&data, patch.TargetTypeIndex().index_);
+        break;
+      case linker::LinkerPatch::Type::kStringRelative:
+      case linker::LinkerPatch::Type::kStringBssEntry:
+        SerializeTargetDexFile(patch.TargetStringDexFile(), dex_file, &data);
+        AppendUint32(&data, patch.PcInsnOffset());
+        AppendUint32(&data, patch.TargetStringIndex().index_);
+        break;
+      case linker::LinkerPatch::Type::kBakerReadBarrierBranch:
+        AppendUint32(&data, patch.GetBakerCustomValue1());
+        AppendUint32(&data, patch.GetBakerCustomValue2());
+        break;
+    }
+  }
+  return data;
+}
+
+CompiledMethod* CompiledMethodCache::Deserialize(const std::string& data,
+                                                 const DexFile& dex_file) const {
+  using Type = linker::LinkerPatch::Type;
+  DataReader reader(data);
+  InstructionSet instruction_set = static_cast<InstructionSet>(reader.ReadUint32());
+  bool is_intrinsic = reader.ReadUint32() != 0u;
+  ArrayRef<const uint8_t> code = reader.ReadData();
+  ArrayRef<const uint8_t> vmap_table = reader.ReadData();
+  ArrayRef<const uint8_t> cfi_info = reader.ReadData();
+  std::vector<linker::LinkerPatch> patches;
+  bool missing_dex_file = false;
+  for (uint32_t i = 0, count = reader.ReadUint32(); i != count && reader.IsOk(); ++i) {
+    uint32_t type = reader.ReadUint32();
+    uint32_t literal_offset = reader.ReadUint32();
+    if (!reader.IsOk() || literal_offset >= code.size()) {
+      LOG(WARNING) << "Ignoring corrupt compiled method cache entry";
+      return nullptr;
+    }
+    const DexFile* target_dex_file = nullptr;
+    switch (static_cast<Type>(type)) {
+      case Type::kMethodRelative:
+      case Type::kMethodBssEntry:
+      case Type::kCallRelative:
+      case Type::kTypeRelative:
+      case Type::kTypeBssEntry:
+      case Type::kStringRelative:
+      case Type::kStringBssEntry:
+        target_dex_file = DeserializeTargetDexFile(reader.ReadString(), dex_file);
+        missing_dex_file = missing_dex_file || target_dex_file == nullptr;
+        break;
+      default:
+        break;
+    }
+    switch (static_cast<Type>(type)) {
+      case Type::kIntrinsicReference: {
+        uint32_t pc_insn_offset = reader.ReadUint32();
+        patches.push_back(linker::LinkerPatch::IntrinsicReferencePatch(
+            literal_offset, pc_insn_offset, reader.ReadUint32()));
+        break;
+      }
+      case Type::kDataBimgRelRo: {
+        uint32_t pc_insn_offset = reader.ReadUint32();
+        patches.push_back(linker::LinkerPatch::DataBimgRelRoPatch(
+            literal_offset, pc_insn_offset, reader.ReadUint32()));
+        break;
+      }
+      case Type::kMethodRelative: {
+        uint32_t pc_insn_offset = reader.ReadUint32();
+        patches.push_back(linker::LinkerPatch::RelativeMethodPatch(
+            literal_offset, target_dex_file, pc_insn_offset, reader.ReadUint32()));
+        break;
+      }
+      case Type::kMethodBssEntry: {
+        uint32_t pc_insn_offset = reader.ReadUint32();
+        patches.push_back(linker::LinkerPatch::MethodBssEntryPatch(
+            literal_offset, target_dex_file, pc_insn_offset, reader.ReadUint32()));
+        break;
+      }
+      case Type::kCallRelative:
+        patches.push_back(linker::LinkerPatch::RelativeCodePatch(
+            literal_offset, target_dex_file, reader.ReadUint32()));
+        break;
+      case Type::kTypeRelative: {
+        uint32_t pc_insn_offset = reader.ReadUint32();
+        patches.push_back(linker::LinkerPatch::RelativeTypePatch(
+            literal_offset, target_dex_file, pc_insn_offset, reader.ReadUint32()));
+        break;
+      }
+      case Type::kTypeBssEntry: {
+        uint32_t pc_insn_offset = reader.ReadUint32();
+        patches.push_back(linker::LinkerPatch::TypeBssEntryPatch(
+            literal_offset, target_dex_file, pc_insn_offset, reader.ReadUint32()));
+        break;
+      }
+      case Type::kStringRelative: {
+        uint32_t pc_insn_offset = reader.ReadUint32();
+        patches.push_back(linker::LinkerPatch::RelativeStringPatch(
+            literal_offset, target_dex_file, pc_insn_offset, reader.ReadUint32()));
+        break;
+      }
+      case Type::kStringBssEntry: {
+        uint32_t pc_insn_offset = reader.ReadUint32();
+        patches.push_back(linker::LinkerPatch::StringBssEntryPatch(
+            literal_offset, target_dex_file, pc_insn_offset, reader.ReadUint32()));
+        break;
+      }
+      case Type::kBakerReadBarrierBranch: {
+        uint32_t custom_value1 = reader.ReadUint32();
+        patches.push_back(linker::LinkerPatch::BakerReadBarrierBranchPatch(
+            literal_offset, custom_value1, reader.ReadUint32()));
+        break;
+      }
+      default:
+        LOG(WARNING) << "Ignoring compiled method cache entry with unknown patch type " << type;
+        return nullptr;
+    }
+  }
+  if (!reader.IsOk() || !reader.AtEnd() ||
+      instruction_set != compiler_options_.GetInstructionSet()) {
+    LOG(WARNING) << "Ignoring corrupt compiled method cache entry";
+    return nullptr;
+  }
+  if (missing_dex_file) {
+    // The code refers to a dex file that is not loaded, or loaded more than once.
+    return nullptr;
+  }
+  CompiledMethod* compiled_method = CompiledMethod::SwapAllocCompiledMethod(
+      storage_,
+      instruction_set,
+      code,
+      vmap_table,
+      cfi_info,
+      ArrayRef<const linker::LinkerPatch>(patches));
+  if (is_intrinsic) {
+    compiled_method->MarkAsIntrinsic();
+  }
+  return compiled_method;
+}
+
+}  // namespace art
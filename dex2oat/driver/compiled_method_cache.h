@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_DEX2OAT_DRIVER_COMPILED_METHOD_CACHE_H_
+#define ART_DEX2OAT_DRIVER_COMPILED_METHOD_CACHE_H_
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/mutex.h"
+
+namespace art {
+
+class ArtMethod;
+class CompiledMethod;
+class CompiledMethodStorage;
+class CompilerOptions;
+class DexFile;
+
+// Lets dex2oat reuse the code compiled for a method by a previous invocation.
+//
+// Each compiled method is stored under a key which hashes what its code was derived from: the
+// code item of the method and of the callees small enough to be inlined, with their overrides
+// in the referenced classes, and what the indices used by this bytecode resolve to. See
+// KeyBuilder in the .cc file. Methods are thus reused when their dex file changed elsewhere,
+// as long as the indices their code refers to are unchanged. Methods with profile inline caches
+// are never reused since the profile changes between compilations.
+//
+// Everything common to all methods, i.e. the compiler binaries, the compiler options and
+// instruction set features, the boot class path and the class loader context, goes into a
+// fingerprint. Entries recorded with a different fingerprint are all discarded.
+//
+// Entries are either kept in a single file written by Save() and read by Load(), or in a
+// directory shared between compilations, with one file per entry named after the hash of its
+// key. The directory lets compilations of different apps reuse the code of the libraries they
+// have in common when the library is a separate dex file on the class path, e.g. a shared
+// library. A library merged into the dex file of each app, as D8 does with the classes of an
+// AAR, gets different indices in each dex file, so its methods have different keys and are
+// not reused across apps.
+class CompiledMethodCache {
+ public:
+  // The cache is disabled, i.e. ComputeKey() always returns an empty key, when compiling a
+  // boot image, with a subset of the optimization passes, without a runtime, or when the
+  // compiler binaries have no build ID.
+  CompiledMethodCache(const CompilerOptions& compiler_options, CompiledMethodStorage* storage);
+  ~CompiledMethodCache();
+
+  // Loads the entries written to `filename` by a previous compilation.
+  bool Load(const std::string& filename, std::string* error_msg);
+
+  // Writes the entries of the methods compiled or reused by this compilation to `filename`.
+  // Requires SetRecordEntries(true) before compiling.
+  bool Save(const std::string& filename, std::string* error_msg) const;
+
+  void SetRecordEntries(bool record_entries) {
+    record_entries_ = record_entries;
+  }
+
+  // Looks up entries missing from the loaded file in `directory`, and adds new entries to it.
+  void SetDirectory(const std::string& directory);
+
+  // Must be called once all dex files the compiled code can refer to have been registered
+  // with the class linker, and before Lookup(). `class_loader_context` is the encoded class
+  // loader context the dex files are compiled in.
+  void Prepare(const std::string& class_loader_context) REQUIRES_SHARED(Locks::mutator_lock_);
+
+  // Whether Prepare() enabled the cache.
+  bool IsEnabled() const {
+    return !fingerprint_.empty();
+  }
+
+  // Returns the key for the code of `method`, or an empty string if it must not be reused.
+  std::string ComputeKey(ArtMethod* method) const REQUIRES_SHARED(Locks::mutator_lock_);
+
+  // Returns the method stored under `key`, allocated in the storage, or null. `dex_file` is
+  // the dex file of the method.
+  CompiledMethod* Lookup(const std::string& key, const DexFile& dex_file) REQUIRES(!lock_);
+
+  // Records `compiled_method`, compiled for a method of `dex_file`, under `key`.
+  void Insert(const std::string& key,
+              const DexFile& dex_file,
+              const CompiledMethod* compiled_method) REQUIRES(!lock_);
+
+  size_t GetNumberOfHits() const REQUIRES(!lock_);
+
+ private:
+  std::string Serialize(const CompiledMethod* compiled_method, const DexFile& dex_file) const;
+  CompiledMethod* Deserialize(const std::string& data, const DexFile& dex_file) const;
+  void SerializeTargetDexFile(const DexFile* target_dex_file,
+                              const DexFile& dex_file,
+                              /*out*/ std::string* out) const;
+  const DexFile* DeserializeTargetDexFile(const std::string& signature,
+                                          const DexFile& dex_file) const;
+
+  std::string GetEntryFilename(const std::string& full_key) const;
+  bool ReadEntryFile(const std::string& key, /*out*/ std::string* data) const;
+  void WriteEntryFile(const std::string& key, const std::string& data) const;
+
+  const CompilerOptions& compiler_options_;
+  CompiledMethodStorage* const storage_;
+  bool record_entries_;
+  std::string directory_;
+
+  // Everything the compiled code depends on that is common to all methods. Empty if the cache
+  // is disabled.
+  std::string fingerprint_;
+
+  // Dex files by SHA-1 signature, for mapping the targets of linker patches outside of the
+  // dex file of the compiled method.
+  std::unordered_map<std::string, const DexFile*> dex_files_by_signature_;
+
+  // Entries loaded from a previous compilation and the fingerprint they were compiled with.
+  // Not modified after Prepare().
+  std::string loaded_fingerprint_;
+  std::unordered_map<std::string, std::string> loaded_entries_;
+
+  mutable Mutex lock_;
+  std::unordered_map<std::string, std::string> entries_ GUARDED_BY(lock_);
+  size_t number_of_hits_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(CompiledMethodCache);
+};
+
+}  // namespace art
+
+#endif  // ART_DEX2OAT_DRIVER_COMPILED_METHOD_CACHE_H_
@@ -0,0 +1,402 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "driver/compiled_method_cache.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "android-base/file.h"
+
+#include "art_method-inl.h"
+#include "base/array_ref.h"
+#include "class_linker.h"
+#include "common_compiler_driver_test.h"
+#include "compiled_method-inl.h"
+#include "dex/dex_file.h"
+#include "driver/compiler_driver.h"
+#include "driver/compiler_options.h"
+#include "handle_scope-inl.h"
+#include "linker/linker_patch.h"
+#include "mirror/class-inl.h"
+#include "mirror/class_loader.h"
+#include "scoped_thread_state_change-inl.h"
+
+namespace art {
+
+class CompiledMethodCacheTest : public CommonCompilerDriverTest {
+ protected:
+  void SetUp() override {
+    CommonCompilerDriverTest::SetUp();
+    // The cache is disabled when compiling a boot image.
+    ClearBootImageOption();
+    ScopedObjectAccess soa(Thread::Current());
+    class_loader_a_ = LoadDex("CompiledMethodsA");
+    class_loader_b_ = LoadDex("CompiledMethodsB");
+    // Defining the classes registers the dex files with the class linker.
+    FindCompiledMethodsClass(class_loader_a_);
+    FindCompiledMethodsClass(class_loader_b_);
+    cache_dir_ = android_data_ + "/compiled_methods";
+    ASSERT_EQ(0, mkdir(cache_dir_.c_str(), 0700));
+  }
+
+  void TearDown() override {
+    ClearDirectory(cache_dir_.c_str());
+    ASSERT_EQ(0, rmdir(cache_dir_.c_str()));
+    CommonCompilerDriverTest::TearDown();
+  }
+
+  ObjPtr<mirror::Class> FindCompiledMethodsClass(jobject class_loader)
+      REQUIRES_SHARED(Locks::mutator_lock_) {
+    ScopedObjectAccessUnchecked soa(Thread::Current());
+    StackHandleScope<1> hs(soa.Self());
+    Handle<mirror::ClassLoader> loader(
+        hs.NewHandle(soa.Decode<mirror::ClassLoader>(class_loader)));
+    ObjPtr<mirror::Class> klass =
+        class_linker_->FindClass(soa.Self(), "LCompiledMethods;", loader);
+    CHECK(klass != nullptr);
+    return klass;
+  }
+
+  std::unique_ptr<CompiledMethodCache> CreateCache() {
+    return std::make_unique<CompiledMethodCache>(*compiler_options_,
+                                                 compiler_driver_->GetCompiledMethodStorage());
+  }
+
+  void Prepare(CompiledMethodCache* cache, const std::string& class_loader_context = "PCL[]") {
+    ScopedObjectAccess soa(Thread::Current());
+    cache->Prepare(class_loader_context);
+    ASSERT_TRUE(cache->IsEnabled());
+  }
+
+  std::string ComputeKey(CompiledMethodCache* cache,
+                         jobject class_loader,
+                         const char* name,
+                         const char* signature) {
+    ScopedObjectAccess soa(Thread::Current());
+    ArtMethod* method = FindCompiledMethodsClass(class_loader)->FindClassMethod(
+        name, signature, class_linker_->GetImagePointerSize());
+    CHECK(method != nullptr) << name;
+    std::string key = cache->ComputeKey(method);
+    EXPECT_FALSE(key.empty()) << name;
+    return key;
+  }
+
+  const DexFile& GetDexFile(jobject class_loader) {
+    std::vector<const DexFile*> dex_files = GetDexFiles(class_loader);
+    CHECK_EQ(dex_files.size(), 1u);
+    return *dex_files[0];
+  }
+
+  // Creates a compiled method with a patch of each type. Patches referencing the dex file of
+  // the method target `dex_file`, the others `other_dex_file`.
+  CompiledMethod* CreateCompiledMethod(const DexFile* dex_file, const DexFile* other_dex_file) {
+    std::vector<uint8_t> code(64u);
+    for (size_t i = 0; i != code.size(); ++i) {
+      code[i] = static_cast<uint8_t>(i);
+    }
+    const uint8_t vmap_table[] = { 1u, 2u, 3u };
+    const uint8_t cfi_info[] = { 4u, 5u };
+    const linker::LinkerPatch patches[] = {
+        linker::LinkerPatch::IntrinsicReferencePatch(0u, 0u, 0x12345678u),
+        linker::LinkerPatch::DataBimgRelRoPatch(4u, 0u, 0x1000u),
+        linker::LinkerPatch::RelativeMethodPatch(8u, dex_file, 4u, 1u),
+        linker::LinkerPatch::MethodBssEntryPatch(12u, other_dex_file, 12u, 2u),
+        linker::LinkerPatch::RelativeCodePatch(16u, dex_file, 3u),
+        linker::LinkerPatch::RelativeTypePatch(20u, dex_file, 20u, 4u),
+        linker::LinkerPatch::TypeBssEntryPatch(24u, other_dex_file, 24u, 5u),
+        linker::LinkerPatch::RelativeStringPatch(28u, dex_file, 28u, 6u),
+        linker::LinkerPatch::StringBssEntryPatch(32u, dex_file, 32u, 7u),
+        linker::LinkerPatch::BakerReadBarrierBranchPatch(36u, 8u, 9u),
+    };
+    return CompiledMethod::SwapAllocCompiledMethod(compiler_driver_->GetCompiledMethodStorage(),
+                                                   compiler_options_->GetInstructionSet(),
+                                                   ArrayRef<const uint8_t>(code),
+                                                   ArrayRef<const uint8_t>(vmap_table),
+                                                   ArrayRef<const uint8_t>(cfi_info),
+                                                   ArrayRef<const linker::LinkerPatch>(patches));
+  }
+
+  void Release(CompiledMethod* compiled_method) {
+    CompiledMethod::ReleaseSwapAllocatedCompiledMethod(
+        compiler_driver_->GetCompiledMethodStorage(), compiled_method);
+  }
+
+  // Records a method of the A dex file in `filename`, and returns its key.
+  std::string SaveMethod(const std::string& filename) {
+    std::unique_ptr<CompiledMethodCache> cache = CreateCache();
+    cache->SetRecordEntries(true);
+    Prepare(cache.get());
+    std::string key = ComputeKey(cache.get(), class_loader_a_, "unchanged", "(I)I");
+    const DexFile& dex_file = GetDexFile(class_loader_a_);
+    CompiledMethod* compiled_method = CreateCompiledMethod(&dex_file, &dex_file);
+    cache->Insert(key, dex_file, compiled_method);
+    Release(compiled_method);
+    std::string error_msg;
+    EXPECT_TRUE(cache->Save(filename, &error_msg)) << error_msg;
+    return key;
+  }
+
+  // Adds a method of the A dex file to the cache directory, and returns its key.
+  std::string AddToDirectory(const char* name) {
+    std::unique_ptr<CompiledMethodCache> cache = CreateCache();
+    cache->SetDirectory(cache_dir_);
+    Prepare(cache.get());
+    std::string key = ComputeKey(cache.get(), class_loader_a_, name, "(I)I");
+    const DexFile& dex_file = GetDexFile(class_loader_a_);
+    CompiledMethod* compiled_method = CreateCompiledMethod(&dex_file, &dex_file);
+    cache->Insert(key, dex_file, compiled_method);
+    Release(compiled_method);
+    return key;
+  }
+
+  // Returns whether the directory has an entry for the method of the B dex file.
+  bool LookupInDirectory(const char* name, const std::string& class_loader_context = "PCL[]") {
+    std::unique_ptr<CompiledMethodCache> cache = CreateCache();
+    cache->SetDirectory(cache_dir_);
+    Prepare(cache.get(), class_loader_context);
+    CompiledMethod* compiled_method = cache->Lookup(
+        ComputeKey(cache.get(), class_loader_b_, name, "(I)I"), GetDexFile(class_loader_b_));
+    if (compiled_method == nullptr) {
+      return false;
+    }
+    EXPECT_EQ(1u, cache->GetNumberOfHits());
+    Release(compiled_method);
+    return true;
+  }
+
+  // Returns the files holding the entries of the cache directory.
+  std::vector<std::string> GetEntryFiles() {
+    std::vector<std::string> entry_files;
+    std::unique_ptr<DIR, decltype(&closedir)> dir(opendir(cache_dir_.c_str()), closedir);
+    CHECK(dir != nullptr);
+    for (dirent* e = readdir(dir.get()); e != nullptr; e = readdir(dir.get())) {
+      if (e->d_name[0] == '.') {
+        continue;
+      }
+      std::string subdirectory = cache_dir_ + "/" + e->d_name;
+      std::unique_ptr<DIR, decltype(&closedir)> subdir(opendir(subdirectory.c_str()), closedir);
+      CHECK(subdir != nullptr);
+      for (dirent* f = readdir(subdir.get()); f != nullptr; f = readdir(subdir.get())) {
+        if (f->d_name[0] != '.') {
+          entry_files.push_back(subdirectory + "/" + f->d_name);
+        }
+      }
+    }
+    return entry_files;
+  }
+
+  jobject class_loader_a_;
+  jobject class_loader_b_;
+  std::string cache_dir_;
+};
+
+TEST_F(CompiledMethodCacheTest, SaveAndLoad) {
+  ScratchFile file;
+  const DexFile& dex_file_a = GetDexFile(class_loader_a_);
+  const DexFile& dex_file_b = GetDexFile(class_loader_b_);
+  std::unique_ptr<CompiledMethodCache> cache = CreateCache();
+  cache->SetRecordEntries(true);
+  Prepare(cache.get());
+  std::string key = ComputeKey(cache.get(), class_loader_a_, "unchanged", "(I)I");
+  CompiledMethod* compiled_method = CreateCompiledMethod(&dex_file_a, &dex_file_b);
+  cache->Insert(key, dex_file_a, compiled_method);
+  std::string error_msg;
+  ASSERT_TRUE(cache->Save(file.GetFilename(), &error_msg)) << error_msg;
+
+  std::unique_ptr<CompiledMethodCache> loaded_cache = CreateCache();
+  ASSERT_TRUE(loaded_cache->Load(file.GetFilename(), &error_msg)) << error_msg;
+  Prepare(loaded_cache.get());
+  CompiledMethod* loaded_method = loaded_cache->Lookup(key, dex_file_a);
+  ASSERT_TRUE(loaded_method != nullptr);
+  EXPECT_EQ(1u, loaded_cache->GetNumberOfHits());
+  EXPECT_EQ(compiled_method->GetInstructionSet(), loaded_method->GetInstructionSet());
+  EXPECT_EQ(compiled_method->IsIntrinsic(), loaded_method->IsIntrinsic());
+  EXPECT_EQ(compiled_method->GetQuickCode(), loaded_method->GetQuickCode());
+  EXPECT_EQ(compiled_method->GetVmapTable(), loaded_method->GetVmapTable());
+  EXPECT_EQ(compiled_method->GetCFIInfo(), loaded_method->GetCFIInfo());
+  EXPECT_EQ(compiled_method->GetPatches(), loaded_method->GetPatches());
+  Release(loaded_method);
+
+  // Patches into the dex file of the method follow the method to another dex file.
+  loaded_method = loaded_cache->Lookup(key, dex_file_b);
+  ASSERT_TRUE(loaded_method != nullptr);
+  ArrayRef<const linker::LinkerPatch> patches = compiled_method->GetPatches();
+  ArrayRef<const linker::LinkerPatch> loaded_patches = loaded_method->GetPatches();
+  ASSERT_EQ(patches.size(), loaded_patches.size());
+  EXPECT_EQ(&dex_file_b, loaded_patches[2].TargetMethod().dex_file);
+  EXPECT_EQ(patches[2].TargetMethod().index, loaded_patches[2].TargetMethod().index);
+  EXPECT_EQ(&dex_file_b, loaded_patches[5].TargetTypeDexFile());
+  EXPECT_EQ(&dex_file_b, loaded_patches[3].TargetMethod().dex_file);
+  Release(loaded_method);
+  Release(compiled_method);
+}
+
+TEST_F(CompiledMethodCacheTest, RejectsDifferentFingerprint) {
+  ScratchFile file;
+  std::string key = SaveMethod(file.GetFilename());
+  const DexFile& dex_file = GetDexFile(class_loader_a_);
+
+  std::unique_ptr<CompiledMethodCache> cache = CreateCache();
+  std::string error_msg;
+  ASSERT_TRUE(cache->Load(file.GetFilename(), &error_msg)) << error_msg;
+  Prepare(cache.get(), "PCL[other.jar*1234]");
+  EXPECT_TRUE(cache->Lookup(key, dex_file) == nullptr);
+  EXPECT_EQ(0u, cache->GetNumberOfHits());
+}
+
+TEST_F(CompiledMethodCacheTest, RejectsDifferentVersion) {
+  ScratchFile file;
+  std::string key = SaveMethod(file.GetFilename());
+  const DexFile& dex_file = GetDexFile(class_loader_a_);
+
+  // The version follows the "cmc\n" magic.
+  std::string data;
+  ASSERT_TRUE(android::base::ReadFileToString(file.GetFilename(), &data));
+  ASSERT_EQ("cmc\n", data.substr(0u, 4u));
+  data[6]++;
+  ASSERT_TRUE(android::base::WriteStringToFile(data, file.GetFilename()));
+
+  std::unique_ptr<CompiledMethodCache> cache = CreateCache();
+  std::string error_msg;
+  EXPECT_FALSE(cache->Load(file.GetFilename(), &error_msg));
+  Prepare(cache.get());
+  EXPECT_TRUE(cache->Lookup(key, dex_file) == nullptr);
+}
+
+TEST_F(CompiledMethodCacheTest, RejectsTruncatedFile) {
+  ScratchFile file;
+  std::string key = SaveMethod(file.GetFilename());
+  const DexFile& dex_file = GetDexFile(class_loader_a_);
+
+  std::string data;
+  ASSERT_TRUE(android::base::ReadFileToString(file.GetFilename(), &data));
+  data.pop_back();
+  ASSERT_TRUE(android::base::WriteStringToFile(data, file.GetFilename()));
+
+  std::unique_ptr<CompiledMethodCache> cache = CreateCache();
+  std::string error_msg;
+  EXPECT_FALSE(cache->Load(file.GetFilename(), &error_msg));
+  Prepare(cache.get());
+  EXPECT_TRUE(cache->Lookup(key, dex_file) == nullptr);
+}
+
+TEST_F(CompiledMethodCacheTest, RejectsCorruptEntry) {
+  ScratchFile file;
+  std::string key = SaveMethod(file.GetFilename());
+  const DexFile& dex_file = GetDexFile(class_loader_a_);
+
+  // The entry ends with the two custom values of the Baker read barrier patch, preceded by
+  // its literal offset and type. Replace the type with an unknown one.
+  std::string data;
+  ASSERT_TRUE(android::base::ReadFileToString(file.GetFilename(), &data));
+  const size_t type_offset = data.size() - 4u * sizeof(uint32_t);
+  ASSERT_EQ(static_cast<char>(linker::LinkerPatch::Type::kBakerReadBarrierBranch),
+            data[type_offset]);
+  data[type_offset] = static_cast<char>(0xff);
+  ASSERT_TRUE(android::base::WriteStringToFile(data, file.GetFilename()));
+
+  std::unique_ptr<CompiledMethodCache> cache = CreateCache();
+  std::string error_msg;
+  ASSERT_TRUE(cache->Load(file.GetFilename(), &error_msg)) << error_msg;
+  Prepare(cache.get());
+  EXPECT_TRUE(cache->Lookup(key, dex_file) == nullptr);
+  EXPECT_EQ(0u, cache->GetNumberOfHits());
+}
+
+TEST_F(CompiledMethodCacheTest, OnlyChangedMethodsMiss) {
+  std::unique_ptr<CompiledMethodCache> cache = CreateCache();
+  Prepare(cache.get());
+  // The dex files differ, but only in the code of changed().
+  ASSERT_NE(0, memcmp(GetDexFile(class_loader_a_).GetHeader().signature_,
+                      GetDexFile(class_loader_b_).GetHeader().signature_,
+                      DexFile::kSha1DigestSize));
+  EXPECT_EQ(ComputeKey(cache.get(), class_loader_a_, "unchanged", "(I)I"),
+            ComputeKey(cache.get(), class_loader_b_, "unchanged", "(I)I"));
+  EXPECT_EQ(ComputeKey(cache.get(), class_loader_a_, "greeting", "()Ljava/lang/String;"),
+            ComputeKey(cache.get(), class_loader_b_, "greeting", "()Ljava/lang/String;"));
+  EXPECT_NE(ComputeKey(cache.get(), class_loader_a_, "changed", "(I)I"),
+            ComputeKey(cache.get(), class_loader_b_, "changed", "(I)I"));
+  EXPECT_NE(ComputeKey(cache.get(), class_loader_a_, "unchanged", "(I)I"),
+            ComputeKey(cache.get(), class_loader_a_, "changed", "(I)I"));
+
+  // Methods recorded for the A dex file are reused for the B dex file, except changed().
+  const DexFile& dex_file_a = GetDexFile(class_loader_a_);
+  const DexFile& dex_file_b = GetDexFile(class_loader_b_);
+  cache->SetRecordEntries(true);
+  for (const char* name : { "unchanged", "changed" }) {
+    CompiledMethod* compiled_method = CreateCompiledMethod(&dex_file_a, &dex_file_a);
+    cache->Insert(ComputeKey(cache.get(), class_loader_a_, name, "(I)I"),
+                  dex_file_a,
+                  compiled_method);
+    Release(compiled_method);
+  }
+  ScratchFile file;
+  std::string error_msg;
+  ASSERT_TRUE(cache->Save(file.GetFilename(), &error_msg)) << error_msg;
+
+  std::unique_ptr<CompiledMethodCache> loaded_cache = CreateCache();
+  ASSERT_TRUE(loaded_cache->Load(file.GetFilename(), &error_msg)) << error_msg;
+  Prepare(loaded_cache.get());
+  CompiledMethod* unchanged = loaded_cache->Lookup(
+      ComputeKey(loaded_cache.get(), class_loader_b_, "unchanged", "(I)I"), dex_file_b);
+  ASSERT_TRUE(unchanged != nullptr);
+  Release(unchanged);
+  EXPECT_TRUE(loaded_cache->Lookup(
+      ComputeKey(loaded_cache.get(), class_loader_b_, "changed", "(I)I"), dex_file_b) == nullptr);
+  EXPECT_EQ(1u, loaded_cache->GetNumberOfHits());
+}
+
+// A method found in another dex file is reused from the cache directory when its references
+// have the same indices in both dex files, as here. This is not the case for a library merged
+// into the dex files of different apps, whose methods do not hit.
+TEST_F(CompiledMethodCacheTest, DirectoryHit) {
+  AddToDirectory("unchanged");
+  EXPECT_EQ(1u, GetEntryFiles().size());
+  EXPECT_TRUE(LookupInDirectory("unchanged"));
+}
+
+TEST_F(CompiledMethodCacheTest, DirectoryMiss) {
+  AddToDirectory("changed");
+  EXPECT_EQ(1u, GetEntryFiles().size());
+  EXPECT_FALSE(LookupInDirectory("changed"));
+  EXPECT_FALSE(LookupInDirectory("unchanged"));
+}
+
+TEST_F(CompiledMethodCacheTest, DirectoryInvalidation) {
+  std::string key = AddToDirectory("unchanged");
+  std::vector<std::string> entry_files = GetEntryFiles();
+  ASSERT_EQ(1u, entry_files.size());
+
+  // Entries written by a compilation with a different fingerprint are not used.
+  EXPECT_FALSE(LookupInDirectory("unchanged", "PCL[other.jar*1234]"));
+
+  // Corrupt entries are not used, and replaced by the next compilation of the method.
+  std::string data;
+  ASSERT_TRUE(android::base::ReadFileToString(entry_files[0], &data));
+  data.pop_back();
+  ASSERT_TRUE(android::base::WriteStringToFile(data, entry_files[0]));
+  EXPECT_FALSE(LookupInDirectory("unchanged"));
+  EXPECT_EQ(key, AddToDirectory("unchanged"));
+  EXPECT_EQ(entry_files, GetEntryFiles());
+  EXPECT_TRUE(LookupInDirectory("unchanged"));
+}
+
+}  // namespace art
@@ -54,6 +54,7 @@
 #include "dex/dex_to_dex_compiler.h"
 #include "dex/verification_results.h"
 #include "dex/verified_method.h"
+#include "driver/compiled_method_cache.h"
 #include "driver/compiler_options.h"
 #include "driver/dex_compilation_unit.h"
 #include "gc/accounting/card_table-inl.h"
@@ -265,7 +266,8 @@ CompilerDriver::CompilerDriver(
       stats_(new AOTCompilationStats),
       compiled_method_storage_(swap_fd),
       max_arena_alloc_(0),
-      dex_to_dex_compiler_(this) {
+      dex_to_dex_compiler_(this),
+      compiled_method_cache_(nullptr) {
   DCHECK(compiler_options_ != nullptr);
 
   compiled_method_storage_.SetDedupeEnabled(compiler_options_->DeduplicateCode());
@@ -585,15 +587,33 @@ static void CompileMethodQuick(
               driver->ShouldCompileBasedOnProfile(method_ref);
 
       if (compile) {
-        // NOTE: if compiler declines to compile this method, it will return null.
-        compiled_method = driver->GetCompiler()->Compile(code_item,
-                                                         access_flags,
-                                                         invoke_type,
-                                                         class_def_idx,
-                                                         method_idx,
-                                                         class_loader,
-                                                         dex_file,
-                                                         dex_cache);
+        CompiledMethodCache* cache = driver->GetCompiledMethodCache();
+        std::string cache_key;
+        if (cache != nullptr) {
+          ScopedObjectAccess soa(self);
+          ArtMethod* method = Runtime::Current()->GetClassLinker()->LookupResolvedMethod(
+              method_idx, dex_cache.Get(), class_loader.Get());
+          if (method != nullptr) {
+            cache_key = cache->ComputeKey(method);
+          }
+        }
+        if (!cache_key.empty()) {
+          compiled_method = cache->Lookup(cache_key, dex_file);
+        }
+        if (compiled_method == nullptr) {
+          // NOTE: if compiler declines to compile this method, it will return null.
+          compiled_method = driver->GetCompiler()->Compile(code_item,
+                                                           access_flags,
+                                                           invoke_type,
+                                                           class_def_idx,
+                                                           method_idx,
+                                                           class_loader,
+                                                           dex_file,
+                                                           dex_cache);
+        }
+        if (compiled_method != nullptr && !cache_key.empty()) {
+          cache->Insert(cache_key, dex_file, compiled_method);
+        }
         ProfileMethodsCheck check_type =
             driver->GetCompilerOptions().CheckProfiledMethodsCompiled();
         if (UNLIKELY(check_type != ProfileMethodsCheck::kNone)) {
@@ -2673,6 +2693,10 @@ void CompilerDriver::Compile(jobject class_loader,
     const size_t arena_alloc = arena_pool->GetBytesAllocated();
     max_arena_alloc_ = std::max(arena_alloc, max_arena_alloc_);
     Runtime::Current()->ReclaimArenaPoolMemory();
+    // Most of the code of the dex file is not accessed again until it is written out. The
+    // dedupe sets still compare the code compiled for later dex files with the stored entries,
+    // which pages some of it back in. Releasing the pages only affects residency, not content.
+    compiled_method_storage_.ReleaseSwapPages();
   }
 
   if (dex_to_dex_compiler_.NumCodeItemsToQuicken(Thread::Current()) > 0u) {
@@ -61,6 +61,7 @@ class VerifierDepsTest;
 class ArtField;
 class BitVector;
 class CompiledMethod;
+class CompiledMethodCache;
 class CompilerOptions;
 class DexCompilationUnit;
 class DexFile;
@@ -226,6 +227,15 @@ class CompilerDriver {
     return dex_to_dex_compiler_;
   }
 
+  // Sets the cache of methods compiled by a previous invocation. Not owned.
+  void SetCompiledMethodCache(CompiledMethodCache* cache) {
+    compiled_method_cache_ = cache;
+  }
+
+  CompiledMethodCache* GetCompiledMethodCache() const {
+    return compiled_method_cache_;
+  }
+
  private:
   void LoadImageClasses(TimingLogger* timings, /*inout*/ HashSet<std::string>* image_classes)
       REQUIRES(!Locks::mutator_lock_);
@@ -338,6 +348,9 @@ class CompilerDriver {
   // Compiler for dex to dex (quickening).
   optimizer::DexToDexCompiler dex_to_dex_compiler_;
 
+  // Code reused from a previous compilation, or null.
+  CompiledMethodCache* compiled_method_cache_;
+
   friend class CommonCompilerDriverTest;
   friend class CompileClassVisitor;
   friend class DexToDexDecompilerTest;
@@ -49,14 +49,16 @@ class DebugInfoTask : public Task {
                 size_t text_section_size,
                 uint64_t dex_section_address,
                 size_t dex_section_size,
-                const debug::DebugInfo& debug_info)
+                const debug::DebugInfo& debug_info,
+                size_t num_threads)
       : isa_(isa),
         instruction_set_features_(features),
         text_section_address_(text_section_address),
         text_section_size_(text_section_size),
         dex_section_address_(dex_section_address),
         dex_section_size_(dex_section_size),
-        debug_info_(debug_info) {
+        debug_info_(debug_info),
+        num_threads_(num_threads) {
   }
 
   void Run(Thread*) override {
@@ -66,7 +68,8 @@ class DebugInfoTask : public Task {
                                        text_section_size_,
                                        dex_section_address_,
                                        dex_section_size_,
-                                       debug_info_);
+                                       debug_info_,
+                                       num_threads_);
   }
 
   std::vector<uint8_t>* GetResult() {
@@ -81,6 +84,7 @@ class DebugInfoTask : public Task {
   uint64_t dex_section_address_;
   size_t dex_section_size_;
   const debug::DebugInfo& debug_info_;
+  size_t num_threads_;
   std::vector<uint8_t> result_;
 };
 
@@ -88,7 +92,8 @@ template <typename ElfTypes>
 class ElfWriterQuick final : public ElfWriter {
  public:
   ElfWriterQuick(const CompilerOptions& compiler_options,
-                 File* elf_file);
+                 File* elf_file,
+                 size_t thread_count);
   ~ElfWriterQuick();
 
   void Start() override;
@@ -121,6 +126,7 @@ class ElfWriterQuick final : public ElfWriter {
  private:
   const CompilerOptions& compiler_options_;
   File* const elf_file_;
+  const size_t thread_count_;
   size_t rodata_size_;
   size_t text_size_;
   size_t data_bimg_rel_ro_size_;
@@ -137,19 +143,23 @@ class ElfWriterQuick final : public ElfWriter {
 };
 
 std::unique_ptr<ElfWriter> CreateElfWriterQuick(const CompilerOptions& compiler_options,
-                                                File* elf_file) {
+                                                File* elf_file,
+                                                size_t thread_count) {
   if (Is64BitInstructionSet(compiler_options.GetInstructionSet())) {
-    return std::make_unique<ElfWriterQuick<ElfTypes64>>(compiler_options, elf_file);
+    return std::make_unique<ElfWriterQuick<ElfTypes64>>(compiler_options, elf_file, thread_count);
   } else {
-    return std::make_unique<ElfWriterQuick<ElfTypes32>>(compiler_options, elf_file);
+    return std::make_unique<ElfWriterQuick<ElfTypes32>>(compiler_options, elf_file, thread_count);
   }
 }
 
 template <typename ElfTypes>
-ElfWriterQuick<ElfTypes>::ElfWriterQuick(const CompilerOptions& compiler_options, File* elf_file)
+ElfWriterQuick<ElfTypes>::ElfWriterQuick(const CompilerOptions& compiler_options,
+                                         File* elf_file,
+                                         size_t thread_count)
     : ElfWriter(),
       compiler_options_(compiler_options),
       elf_file_(elf_file),
+      thread_count_(thread_count),
       rodata_size_(0u),
       text_size_(0u),
       data_bimg_rel_ro_size_(0u),
@@ -256,7 +266,8 @@ void ElfWriterQuick<ElfTypes>::PrepareDebugInfo(const debug::DebugInfo& debug_in
         text_size_,
         builder_->GetDex()->Exists() ? builder_->GetDex()->GetAddress() : 0,
         dex_section_size_,
-        debug_info);
+        debug_info,
+        thread_count_);
     debug_info_thread_pool_ = std::make_unique<ThreadPool>("Mini-debug-info writer", 1);
     debug_info_thread_pool_->AddTask(self, debug_info_task_.get());
     debug_info_thread_pool_->StartWorkers(self);
@@ -263,6 +263,7 @@ inline void ImageTest::DoCompile(ImageHeader::StorageMode storage_mode,
             /* verify */ false,           // Dex files may be dex-to-dex-ed, don't verify.
             /* update_input_vdex */ false,
             /* copy_dex_files */ CopyOption::kOnlyIfCompressed,
+            /* thread_count */ 1u,
             &cur_opened_dex_files_maps,
             &cur_opened_dex_files);
         ASSERT_TRUE(dex_files_ok);
@@ -344,7 +345,8 @@ inline void ImageTest::DoCompile(ImageHeader::StorageMode storage_mode,
 
     bool success_image = writer->Write(kInvalidFd,
                                        image_filenames,
-                                       oat_filenames);
+                                       oat_filenames,
+                                       number_of_threads_);
     ASSERT_TRUE(success_image);
 
     for (size_t i = 0, size = oat_filenames.size(); i != size; ++i) {
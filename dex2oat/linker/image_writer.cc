@@ -21,6 +21,7 @@
 #include <sys/stat.h>
 #include <zlib.h>
 
+#include <algorithm>
 #include <memory>
 #include <numeric>
 #include <unordered_set>
@@ -79,6 +80,7 @@
 #include "runtime.h"
 #include "scoped_thread_state_change-inl.h"
 #include "subtype_check.h"
+#include "thread_pool.h"
 #include "utils/dex_cache_arrays_layout-inl.h"
 #include "well_known_classes.h"
 
@@ -700,7 +702,8 @@ class ImageWriter::ImageFileGuard {
 
 bool ImageWriter::Write(int image_fd,
                         const std::vector<std::string>& image_filenames,
-                        const std::vector<std::string>& oat_filenames) {
+                        const std::vector<std::string>& oat_filenames,
+                        size_t thread_count) {
   // If image_fd or oat_fd are not kInvalidFd then we may have empty strings in image_filenames or
   // oat_filenames.
   CHECK(!image_filenames.empty());
@@ -711,11 +714,16 @@ bool ImageWriter::Write(int image_fd,
   CHECK_EQ(image_filenames.size(), oat_filenames.size());
 
   Thread* const self = Thread::Current();
+  // The calling thread also does work, see CopyAndFixupInParallel().
+  std::unique_ptr<ThreadPool> thread_pool;
+  if (thread_count > 1u) {
+    thread_pool.reset(new ThreadPool("Image writer thread pool", thread_count - 1u));
+  }
   {
     ScopedObjectAccess soa(self);
     for (size_t i = 0; i < oat_filenames.size(); ++i) {
       CreateHeader(i);
-      CopyAndFixupNativeData(i);
+      CopyAndFixupNativeData(i, thread_pool.get());
     }
   }
 
@@ -723,8 +731,9 @@ bool ImageWriter::Write(int image_fd,
     // TODO: heap validation can't handle these fix up passes.
     ScopedObjectAccess soa(self);
     Runtime::Current()->GetHeap()->DisableObjectValidation();
-    CopyAndFixupObjects();
+    CopyAndFixupObjects(thread_pool.get());
   }
+  thread_pool.reset();
 
   if (compiler_options_.IsAppImage()) {
     CopyMetadata();
@@ -2806,74 +2815,118 @@ void ImageWriter::CopyAndFixupImtConflictTable(ImtConflictTable* orig, ImtConfli
   }
 }
 
-void ImageWriter::CopyAndFixupNativeData(size_t oat_index) {
-  const ImageInfo& image_info = GetImageInfo(oat_index);
-  // Copy ArtFields and methods to their locations and update the array for convenience.
-  for (auto& pair : native_object_relocations_) {
-    NativeObjectRelocation& relocation = pair.second;
-    // Only work with fields and methods that are in the current oat file.
-    if (relocation.oat_index != oat_index) {
-      continue;
+// Calls `fn(index)` for each index in [0, size). With a thread pool, the range is split into
+// chunks which the pool workers and the calling thread process concurrently, so `fn` must only
+// write to memory owned by its index.
+template <typename Fn>
+static void CopyAndFixupInParallel(ThreadPool* thread_pool, size_t size, size_t chunk_size, Fn fn)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  if (thread_pool == nullptr || size <= chunk_size) {
+    for (size_t i = 0; i != size; ++i) {
+      fn(i);
     }
-    auto* dest = image_info.image_.Begin() + relocation.offset;
-    DCHECK_GE(dest, image_info.image_.Begin() + image_info.image_end_);
-    DCHECK(!IsInBootImage(pair.first));
-    switch (relocation.type) {
-      case NativeObjectRelocationType::kArtField: {
-        memcpy(dest, pair.first, sizeof(ArtField));
-        CopyAndFixupReference(
-            reinterpret_cast<ArtField*>(dest)->GetDeclaringClassAddressWithoutBarrier(),
-            reinterpret_cast<ArtField*>(pair.first)->GetDeclaringClass());
-        break;
-      }
-      case NativeObjectRelocationType::kRuntimeMethod:
-      case NativeObjectRelocationType::kArtMethodClean:
-      case NativeObjectRelocationType::kArtMethodDirty: {
-        CopyAndFixupMethod(reinterpret_cast<ArtMethod*>(pair.first),
-                           reinterpret_cast<ArtMethod*>(dest),
-                           oat_index);
-        break;
-      }
-      // For arrays, copy just the header since the elements will get copied by their corresponding
-      // relocations.
-      case NativeObjectRelocationType::kArtFieldArray: {
-        memcpy(dest, pair.first, LengthPrefixedArray<ArtField>::ComputeSize(0));
-        break;
-      }
-      case NativeObjectRelocationType::kArtMethodArrayClean:
-      case NativeObjectRelocationType::kArtMethodArrayDirty: {
-        size_t size = ArtMethod::Size(target_ptr_size_);
-        size_t alignment = ArtMethod::Alignment(target_ptr_size_);
-        memcpy(dest, pair.first, LengthPrefixedArray<ArtMethod>::ComputeSize(0, size, alignment));
-        // Clear padding to avoid non-deterministic data in the image.
-        // Historical note: We also did that to placate Valgrind.
-        reinterpret_cast<LengthPrefixedArray<ArtMethod>*>(dest)->ClearPadding(size, alignment);
-        break;
-      }
-      case NativeObjectRelocationType::kDexCacheArray:
-        // Nothing to copy here, everything is done in FixupDexCache().
-        break;
-      case NativeObjectRelocationType::kIMTable: {
-        ImTable* orig_imt = reinterpret_cast<ImTable*>(pair.first);
-        ImTable* dest_imt = reinterpret_cast<ImTable*>(dest);
-        CopyAndFixupImTable(orig_imt, dest_imt);
-        break;
-      }
-      case NativeObjectRelocationType::kIMTConflictTable: {
-        auto* orig_table = reinterpret_cast<ImtConflictTable*>(pair.first);
-        CopyAndFixupImtConflictTable(
-            orig_table,
-            new(dest)ImtConflictTable(orig_table->NumEntries(target_ptr_size_), target_ptr_size_));
-        break;
-      }
-      case NativeObjectRelocationType::kGcRootPointer: {
-        auto* orig_pointer = reinterpret_cast<GcRoot<mirror::Object>*>(pair.first);
-        auto* dest_pointer = reinterpret_cast<GcRoot<mirror::Object>*>(dest);
-        CopyAndFixupReference(dest_pointer->AddressWithoutBarrier(), orig_pointer->Read());
-        break;
+    return;
+  }
+  Thread* const self = Thread::Current();
+  for (size_t begin = 0; begin < size; begin += chunk_size) {
+    const size_t end = std::min(size, begin + chunk_size);
+    thread_pool->AddTask(self, new FunctionTask([begin, end, &fn](Thread* worker) {
+      ScopedObjectAccess soa(worker);
+      for (size_t i = begin; i != end; ++i) {
+        fn(i);
       }
+    }));
+  }
+  thread_pool->StartWorkers(self);
+  {
+    // Go to native since we don't want to suspend while holding the mutator lock.
+    ScopedThreadSuspension sts(self, kNative);
+    thread_pool->Wait(self, /*do_work=*/ true, /*may_hold_locks=*/ false);
+  }
+  thread_pool->StopWorkers(self);
+}
+
+void ImageWriter::CopyAndFixupNativeObject(void* orig,
+                                           const NativeObjectRelocation& relocation,
+                                           const ImageInfo& image_info) {
+  auto* dest = image_info.image_.Begin() + relocation.offset;
+  DCHECK_GE(dest, image_info.image_.Begin() + image_info.image_end_);
+  DCHECK(!IsInBootImage(orig));
+  switch (relocation.type) {
+    case NativeObjectRelocationType::kArtField: {
+      memcpy(dest, orig, sizeof(ArtField));
+      CopyAndFixupReference(
+          reinterpret_cast<ArtField*>(dest)->GetDeclaringClassAddressWithoutBarrier(),
+          reinterpret_cast<ArtField*>(orig)->GetDeclaringClass());
+      break;
+    }
+    case NativeObjectRelocationType::kRuntimeMethod:
+    case NativeObjectRelocationType::kArtMethodClean:
+    case NativeObjectRelocationType::kArtMethodDirty: {
+      CopyAndFixupMethod(reinterpret_cast<ArtMethod*>(orig),
+                         reinterpret_cast<ArtMethod*>(dest),
+                         relocation.oat_index);
+      break;
+    }
+    // For arrays, copy just the header since the elements will get copied by their corresponding
+    // relocations.
+    case NativeObjectRelocationType::kArtFieldArray: {
+      memcpy(dest, orig, LengthPrefixedArray<ArtField>::ComputeSize(0));
+      break;
+    }
+    case NativeObjectRelocationType::kArtMethodArrayClean:
+    case NativeObjectRelocationType::kArtMethodArrayDirty: {
+      size_t size = ArtMethod::Size(target_ptr_size_);
+      size_t alignment = ArtMethod::Alignment(target_ptr_size_);
+      memcpy(dest, orig, LengthPrefixedArray<ArtMethod>::ComputeSize(0, size, alignment));
+      // Clear padding to avoid non-deterministic data in the image.
+      // Historical note: We also did that to placate Valgrind.
+      reinterpret_cast<LengthPrefixedArray<ArtMethod>*>(dest)->ClearPadding(size, alignment);
+      break;
+    }
+    case NativeObjectRelocationType::kDexCacheArray:
+      // Nothing to copy here, everything is done in FixupDexCache().
+      break;
+    case NativeObjectRelocationType::kIMTable: {
+      ImTable* orig_imt = reinterpret_cast<ImTable*>(orig);
+      ImTable* dest_imt = reinterpret_cast<ImTable*>(dest);
+      CopyAndFixupImTable(orig_imt, dest_imt);
+      break;
+    }
+    case NativeObjectRelocationType::kIMTConflictTable: {
+      auto* orig_table = reinterpret_cast<ImtConflictTable*>(orig);
+      CopyAndFixupImtConflictTable(
+          orig_table,
+          new(dest)ImtConflictTable(orig_table->NumEntries(target_ptr_size_), target_ptr_size_));
+      break;
+    }
+    case NativeObjectRelocationType::kGcRootPointer: {
+      auto* orig_pointer = reinterpret_cast<GcRoot<mirror::Object>*>(orig);
+      auto* dest_pointer = reinterpret_cast<GcRoot<mirror::Object>*>(dest);
+      CopyAndFixupReference(dest_pointer->AddressWithoutBarrier(), orig_pointer->Read());
+      break;
     }
   }
+}
+
+void ImageWriter::CopyAndFixupNativeData(size_t oat_index, ThreadPool* thread_pool) {
+  const ImageInfo& image_info = GetImageInfo(oat_index);
+  // Copy ArtFields and methods to their locations and update the array for convenience.
+  // Only work with fields and methods that are in the current oat file.
+  std::vector<const std::pair<void* const, NativeObjectRelocation>*> relocations;
+  for (const auto& pair : native_object_relocations_) {
+    if (pair.second.oat_index == oat_index) {
+      relocations.push_back(&pair);
+    }
+  }
+  static constexpr size_t kRelocationsPerTask = 1024u;
+  CopyAndFixupInParallel(
+      thread_pool,
+      relocations.size(),
+      kRelocationsPerTask,
+      [&](size_t i) REQUIRES_SHARED(Locks::mutator_lock_) {
+        CopyAndFixupNativeObject(relocations[i]->first, relocations[i]->second, image_info);
+      });
   // Fixup the image method roots.
   auto* image_header = reinterpret_cast<ImageHeader*>(image_info.image_.Begin());
   for (size_t i = 0; i < ImageHeader::kImageMethodsCount; ++i) {
@@ -2982,7 +3035,8 @@ void ImageWriter::CopyAndFixupObject(Object* obj) {
   DCHECK_LT(offset, image_info.image_end_);
   const auto* src = reinterpret_cast<const uint8_t*>(obj);
 
-  image_info.image_bitmap_->Set(dst);  // Mark the obj as live.
+  // Mark the obj as live. Other threads may be marking neighbouring objects.
+  image_info.image_bitmap_->AtomicTestAndSet(dst);
 
   const size_t n = obj->SizeOf();
 
@@ -3046,12 +3100,21 @@ class ImageWriter::FixupVisitor {
   mirror::Object* const copy_;
 };
 
-void ImageWriter::CopyAndFixupObjects() {
+void ImageWriter::CopyAndFixupObjects(ThreadPool* thread_pool) {
+  std::vector<Object*> objects;
   auto visitor = [&](Object* obj) REQUIRES_SHARED(Locks::mutator_lock_) {
     DCHECK(obj != nullptr);
-    CopyAndFixupObject(obj);
+    if (IsImageObject(obj)) {
+      objects.push_back(obj);
+    }
   };
   Runtime::Current()->GetHeap()->VisitObjects(visitor);
+  static constexpr size_t kObjectsPerTask = 4096u;
+  CopyAndFixupInParallel(
+      thread_pool,
+      objects.size(),
+      kObjectsPerTask,
+      [&](size_t i) REQUIRES_SHARED(Locks::mutator_lock_) { CopyAndFixupObject(objects[i]); });
   // Copy the padding objects since they are required for in order traversal of the image space.
   for (const ImageInfo& image_info : image_infos_) {
     for (const size_t offset : image_info.padding_object_offsets_) {
@@ -3179,11 +3242,10 @@ void ImageWriter::FixupObject(Object* orig, Object* copy) {
   }
   if (orig->IsIntArray() || orig->IsLongArray()) {
     // Is this a native pointer array?
+    // Objects may be fixed up concurrently, so pointer_arrays_ must not be modified here.
     auto it = pointer_arrays_.find(down_cast<mirror::PointerArray*>(orig));
     if (it != pointer_arrays_.end()) {
-      // Should only need to fixup every pointer array exactly once.
       FixupPointerArray(copy, down_cast<mirror::PointerArray*>(orig), it->second);
-      pointer_arrays_.erase(it);
       return;
     }
   }
@@ -67,6 +67,7 @@ class CompilerOptions;
 template<class T> class Handle;
 class ImTable;
 class ImtConflictTable;
+class ThreadPool;
 class TimingLogger;
 
 static constexpr int kInvalidFd = -1;
@@ -141,9 +142,11 @@ class ImageWriter final {
   // the names in image_filenames.
   // If oat_fd is not kInvalidFd, then we use that for the oat file. Otherwise we open
   // the names in oat_filenames.
+  // Objects and native data are copied and fixed up using up to thread_count threads.
   bool Write(int image_fd,
              const std::vector<std::string>& image_filenames,
-             const std::vector<std::string>& oat_filenames)
+             const std::vector<std::string>& oat_filenames,
+             size_t thread_count)
       REQUIRES(!Locks::mutator_lock_);
 
   uintptr_t GetOatDataBegin(size_t oat_index) {
@@ -495,9 +498,15 @@ class ImageWriter final {
   void UnbinObjectsIntoOffset(mirror::Object* obj)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
-  // Creates the contiguous image in memory and adjusts pointers.
-  void CopyAndFixupNativeData(size_t oat_index) REQUIRES_SHARED(Locks::mutator_lock_);
-  void CopyAndFixupObjects() REQUIRES_SHARED(Locks::mutator_lock_);
+  // Creates the contiguous image in memory and adjusts pointers. The copies do not depend on
+  // each other, so the work is split into chunks run on `thread_pool` if it is not null.
+  void CopyAndFixupNativeData(size_t oat_index, ThreadPool* thread_pool)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+  void CopyAndFixupNativeObject(void* orig,
+                                const NativeObjectRelocation& relocation,
+                                const ImageInfo& image_info)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+  void CopyAndFixupObjects(ThreadPool* thread_pool) REQUIRES_SHARED(Locks::mutator_lock_);
   void CopyAndFixupObject(mirror::Object* obj) REQUIRES_SHARED(Locks::mutator_lock_);
   void CopyAndFixupMethod(ArtMethod* orig, ArtMethod* copy, size_t oat_index)
       REQUIRES_SHARED(Locks::mutator_lock_);
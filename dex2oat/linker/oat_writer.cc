@@ -17,6 +17,8 @@
 #include "oat_writer.h"
 
 #include <algorithm>
+#include <atomic>
+#include <thread>
 #include <unistd.h>
 #include <zlib.h>
 
@@ -357,6 +359,15 @@ class OatWriter::OatDexFile {
   DISALLOW_COPY_AND_ASSIGN(OatDexFile);
 };
 
+// A dex file opened and laid out ahead of writing it. The `dex_layout` refers to the `options`,
+// so a PreparedDexFile must not be moved once prepared.
+struct OatWriter::PreparedDexFile {
+  Options options;
+  std::unique_ptr<const DexFile> dex_file;
+  std::unique_ptr<DexLayout> dex_layout;
+  std::string error_msg;
+};
+
 #define DCHECK_OFFSET() \
   DCHECK_EQ(static_cast<off_t>(file_offset + relative_offset), out->Seek(0, kSeekCurrent)) \
     << "file_offset=" << file_offset << " relative_offset=" << relative_offset
@@ -663,6 +674,7 @@ bool OatWriter::WriteAndOpenDexFiles(
     bool verify,
     bool update_input_vdex,
     CopyOption copy_dex_files,
+    size_t thread_count,
     /*out*/ std::vector<MemMap>* opened_dex_files_map,
     /*out*/ std::vector<std::unique_ptr<const DexFile>>* opened_dex_files) {
   CHECK(write_state_ == WriteState::kAddingDexFileSources);
@@ -690,7 +702,7 @@ bool OatWriter::WriteAndOpenDexFiles(
   // Write DEX files into VDEX, mmap and open them.
   std::vector<MemMap> dex_files_map;
   std::vector<std::unique_ptr<const DexFile>> dex_files;
-  if (!WriteDexFiles(vdex_out.get(), vdex_file, update_input_vdex, copy_dex_files) ||
+  if (!WriteDexFiles(vdex_out.get(), vdex_file, update_input_vdex, copy_dex_files, thread_count) ||
       !OpenDexFiles(vdex_file, verify, &dex_files_map, &dex_files)) {
     return false;
   }
@@ -3168,7 +3180,8 @@ bool OatWriter::RecordOatDataOffset(OutputStream* out) {
 bool OatWriter::WriteDexFiles(OutputStream* out,
                               File* file,
                               bool update_input_vdex,
-                              CopyOption copy_dex_files) {
+                              CopyOption copy_dex_files,
+                              size_t thread_count) {
   TimingLogger::ScopedTiming split("Write Dex files", timings_);
 
   // If extraction is enabled, only do it if not all the dex files are aligned and uncompressed.
@@ -3196,11 +3209,27 @@ bool OatWriter::WriteDexFiles(OutputStream* out,
     // Add the dex section header.
     vdex_size_ += sizeof(VdexFile::DexSectionHeader);
     vdex_dex_files_offset_ = vdex_size_;
-    // Write dex files.
-    for (OatDexFile& oat_dex_file : oat_dex_files_) {
-      if (!WriteDexFile(out, file, &oat_dex_file, update_input_vdex)) {
-        return false;
+    // Write dex files. With dex layout or compact dex, the dex files are opened and laid out
+    // in parallel, `thread_count` at a time to bound the memory used by their IR. They are
+    // then converted and written one by one since they share the compact dex data section.
+    const bool layout = profile_compilation_info_ != nullptr ||
+        compact_dex_level_ != CompactDexLevel::kCompactDexLevelNone;
+    const size_t batch_size = layout ? std::max<size_t>(thread_count, 1u) : 1u;
+    for (size_t begin = 0, size = oat_dex_files_.size(); begin != size; ) {
+      const size_t end = std::min(begin + batch_size, size);
+      std::vector<PreparedDexFile> prepared(layout ? end - begin : 0u);
+      if (layout) {
+        CHECK(!update_input_vdex)
+            << "We should never update the input vdex when doing dexlayout or compact dex";
+        PrepareDexFilesForLayout(begin, end, thread_count, &prepared);
       }
+      for (size_t i = begin; i != end; ++i) {
+        PreparedDexFile* prepared_dex_file = layout ? &prepared[i - begin] : nullptr;
+        if (!WriteDexFile(out, file, &oat_dex_files_[i], update_input_vdex, prepared_dex_file)) {
+          return false;
+        }
+      }
+      begin = end;
     }
 
     // Write shared dex file data section and fix up the dex file headers.
@@ -3322,16 +3351,15 @@ void OatWriter::CloseSources() {
 bool OatWriter::WriteDexFile(OutputStream* out,
                              File* file,
                              OatDexFile* oat_dex_file,
-                             bool update_input_vdex) {
+                             bool update_input_vdex,
+                             PreparedDexFile* prepared) {
   if (!SeekToDexFile(out, file, oat_dex_file)) {
     return false;
   }
   // update_input_vdex disables compact dex and layout.
-  if (profile_compilation_info_ != nullptr ||
-      compact_dex_level_ != CompactDexLevel::kCompactDexLevelNone) {
-    CHECK(!update_input_vdex)
-        << "We should never update the input vdex when doing dexlayout or compact dex";
-    if (!LayoutAndWriteDexFile(out, oat_dex_file)) {
+  if (prepared != nullptr) {
+    DCHECK(!update_input_vdex);
+    if (!LayoutAndWriteDexFile(out, oat_dex_file, prepared)) {
       return false;
     }
   } else if (oat_dex_file->source_.IsZipEntry()) {
@@ -3398,9 +3426,35 @@ bool OatWriter::SeekToDexFile(OutputStream* out, File* file, OatDexFile* oat_dex
   return true;
 }
 
-bool OatWriter::LayoutAndWriteDexFile(OutputStream* out, OatDexFile* oat_dex_file) {
-  TimingLogger::ScopedTiming split("Dex Layout", timings_);
-  std::string error_msg;
+void OatWriter::PrepareDexFilesForLayout(size_t begin,
+                                         size_t end,
+                                         size_t thread_count,
+                                         /*out*/ std::vector<PreparedDexFile>* prepared) {
+  TimingLogger::ScopedTiming split("Prepare Dex Layout", timings_);
+  DCHECK_EQ(prepared->size(), end - begin);
+  // The zip archives are not meant to be read concurrently, so extraction is serialized.
+  std::mutex zip_lock;
+  std::atomic<size_t> next_index(begin);
+  auto prepare_dex_files = [&]() {
+    for (size_t i = next_index++; i < end; i = next_index++) {
+      PrepareDexFileForLayout(&oat_dex_files_[i], &zip_lock, &(*prepared)[i - begin]);
+    }
+  };
+  size_t num_threads = std::min(end - begin, std::max<size_t>(thread_count, 1u));
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < num_threads; ++i) {
+    threads.emplace_back(prepare_dex_files);
+  }
+  prepare_dex_files();
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+void OatWriter::PrepareDexFileForLayout(OatDexFile* oat_dex_file,
+                                        std::mutex* zip_lock,
+                                        /*out*/ PreparedDexFile* prepared) {
+  std::string& error_msg = prepared->error_msg;
   std::string location(oat_dex_file->GetLocation());
   std::unique_ptr<const DexFile> dex_file;
   const ArtDexFileLoader dex_file_loader;
@@ -3408,14 +3462,13 @@ bool OatWriter::LayoutAndWriteDexFile(OutputStream* out, OatDexFile* oat_dex_fil
     ZipEntry* zip_entry = oat_dex_file->source_.GetZipEntry();
     MemMap mem_map;
     {
-      TimingLogger::ScopedTiming extract("Unzip", timings_);
+      std::lock_guard<std::mutex> lock(*zip_lock);
       mem_map = zip_entry->ExtractToMemMap(location.c_str(), "classes.dex", &error_msg);
     }
     if (!mem_map.IsValid()) {
-      LOG(ERROR) << "Failed to extract dex file to mem map for layout: " << error_msg;
-      return false;
+      error_msg = "Failed to extract dex file to mem map for layout: " + error_msg;
+      return;
     }
-    TimingLogger::ScopedTiming extract("Open", timings_);
     dex_file = dex_file_loader.Open(location,
                                     zip_entry->GetCrc32(),
                                     std::move(mem_map),
@@ -3426,10 +3479,10 @@ bool OatWriter::LayoutAndWriteDexFile(OutputStream* out, OatDexFile* oat_dex_fil
     File* raw_file = oat_dex_file->source_.GetRawFile();
     int dup_fd = DupCloexec(raw_file->Fd());
     if (dup_fd < 0) {
-      PLOG(ERROR) << "Failed to dup dex file descriptor (" << raw_file->Fd() << ") at " << location;
-      return false;
+      error_msg = "Failed to dup dex file descriptor (" + std::to_string(raw_file->Fd()) +
+          ") at " + location + ": " + strerror(errno);
+      return;
     }
-    TimingLogger::ScopedTiming extract("Open", timings_);
     dex_file = dex_file_loader.OpenDex(dup_fd, location,
                                        /* verify */ true,
                                        /* verify_checksum */ true,
@@ -3456,18 +3509,36 @@ bool OatWriter::LayoutAndWriteDexFile(OutputStream* out, OatDexFile* oat_dex_fil
                                     &error_msg);
   }
   if (dex_file == nullptr) {
-    LOG(ERROR) << "Failed to open dex file for layout: " << error_msg;
+    error_msg = "Failed to open dex file for layout: " + error_msg;
+    return;
+  }
+  prepared->options.compact_dex_level_ = compact_dex_level_;
+  prepared->options.update_checksum_ = true;
+  prepared->dex_layout.reset(new DexLayout(prepared->options,
+                                           profile_compilation_info_,
+                                           /*file*/ nullptr,
+                                           /*header*/ nullptr));
+  prepared->dex_layout->PrepareDexFile(dex_file.get());
+  prepared->dex_file = std::move(dex_file);
+}
+
+bool OatWriter::LayoutAndWriteDexFile(OutputStream* out,
+                                      OatDexFile* oat_dex_file,
+                                      PreparedDexFile* prepared) {
+  TimingLogger::ScopedTiming split("Dex Layout", timings_);
+  if (prepared->dex_file == nullptr) {
+    LOG(ERROR) << prepared->error_msg;
     return false;
   }
-  Options options;
-  options.compact_dex_level_ = compact_dex_level_;
-  options.update_checksum_ = true;
-  DexLayout dex_layout(options, profile_compilation_info_, /*file*/ nullptr, /*header*/ nullptr);
+  std::string error_msg;
+  std::string location(oat_dex_file->GetLocation());
+  const DexFile* dex_file = prepared->dex_file.get();
+  DexLayout& dex_layout = *prepared->dex_layout;
   const uint8_t* dex_src = nullptr;
   {
     TimingLogger::ScopedTiming extract("ProcessDexFile", timings_);
     if (dex_layout.ProcessDexFile(location.c_str(),
-                                  dex_file.get(),
+                                  dex_file,
                                   0,
                                   &dex_container_,
                                   &error_msg)) {
@@ -3495,6 +3566,9 @@ bool OatWriter::LayoutAndWriteDexFile(OutputStream* out, OatDexFile* oat_dex_fil
     dex_container_->GetMainSection()->Clear();
   }
   CHECK_EQ(oat_dex_file->dex_file_location_checksum_, dex_file->GetLocationChecksum());
+  // Release the input dex file and its IR now that they have been written.
+  prepared->dex_layout.reset();
+  prepared->dex_file.reset();
   return true;
 }
 
@@ -21,6 +21,7 @@
 #include <cstddef>
 #include <list>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include "base/array_ref.h"
@@ -172,12 +173,14 @@ class OatWriter {
   // This is generally the case, and should only be false for tests.
   // If `update_input_vdex` is true, then this method won't actually write the dex files,
   // and the compiler will just re-use the existing vdex file.
+  // Dex layout and compact dex conversion use up to `thread_count` threads.
   bool WriteAndOpenDexFiles(File* vdex_file,
                             OutputStream* oat_rodata,
                             SafeMap<std::string, std::string>* key_value_store,
                             bool verify,
                             bool update_input_vdex,
                             CopyOption copy_dex_files,
+                            size_t thread_count,
                             /*out*/ std::vector<MemMap>* opened_dex_files_map,
                             /*out*/ std::vector<std::unique_ptr<const DexFile>>* opened_dex_files);
   // Initialize the writer with the given parameters.
@@ -262,6 +265,7 @@ class OatWriter {
   class OatClassHeader;
   class OatClass;
   class OatDexFile;
+  struct PreparedDexFile;
 
   // The function VisitDexMethods() below iterates through all the methods in all
   // the compiled dex files in order of their definitions. The method visitor
@@ -293,13 +297,24 @@ class OatWriter {
   bool WriteDexFiles(OutputStream* out,
                      File* file,
                      bool update_input_vdex,
-                     CopyOption copy_dex_files);
+                     CopyOption copy_dex_files,
+                     size_t thread_count);
   bool WriteDexFile(OutputStream* out,
                     File* file,
                     OatDexFile* oat_dex_file,
-                    bool update_input_vdex);
+                    bool update_input_vdex,
+                    PreparedDexFile* prepared);
   bool SeekToDexFile(OutputStream* out, File* file, OatDexFile* oat_dex_file);
-  bool LayoutAndWriteDexFile(OutputStream* out, OatDexFile* oat_dex_file);
+  void PrepareDexFilesForLayout(size_t begin,
+                                size_t end,
+                                size_t thread_count,
+                                /*out*/ std::vector<PreparedDexFile>* prepared);
+  void PrepareDexFileForLayout(OatDexFile* oat_dex_file,
+                               std::mutex* zip_lock,
+                               /*out*/ PreparedDexFile* prepared);
+  bool LayoutAndWriteDexFile(OutputStream* out,
+                             OatDexFile* oat_dex_file,
+                             PreparedDexFile* prepared);
   bool WriteDexFile(OutputStream* out,
                     File* file,
                     OatDexFile* oat_dex_file,
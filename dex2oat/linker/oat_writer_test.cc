@@ -183,6 +183,7 @@ class OatTest : public CommonCompilerDriverTest {
         verify,
         /*update_input_vdex=*/ false,
         copy,
+        /*thread_count=*/ 2u,
         &opened_dex_files_maps,
         &opened_dex_files)) {
       return false;
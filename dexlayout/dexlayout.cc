@@ -1868,6 +1868,21 @@ bool DexLayout::OutputDexFile(const DexFile* input_dex_file,
   return true;
 }
 
+bool DexLayout::EagerlyAssignOffsets() const {
+  // Try to avoid eagerly assigning offsets to find bugs since Offset will abort if the offset
+  // is unassigned. The dumping options require the offsets.
+  return options_.visualize_pattern_ || options_.show_section_statistics_ || options_.dump_;
+}
+
+void DexLayout::PrepareDexFile(const DexFile* dex_file) {
+  prepared_header_.reset(dex_ir::DexIrBuilder(*dex_file, EagerlyAssignOffsets(), GetOptions()));
+  prepared_dex_file_ = dex_file;
+  SetHeader(prepared_header_.get());
+  if (info_ != nullptr) {
+    LayoutOutputFile(dex_file);
+  }
+}
+
 /*
  * Dumps the requested sections of the file.
  */
@@ -1879,16 +1894,12 @@ bool DexLayout::ProcessDexFile(const char* file_name,
   const bool has_output_container = dex_container != nullptr;
   const bool output = options_.output_dex_directory_ != nullptr || has_output_container;
 
-  // Try to avoid eagerly assigning offsets to find bugs since Offset will abort if the offset
-  // is unassigned.
-  bool eagerly_assign_offsets = false;
-  if (options_.visualize_pattern_ || options_.show_section_statistics_ || options_.dump_) {
-    // These options required the offsets for dumping purposes.
-    eagerly_assign_offsets = true;
-  }
-  std::unique_ptr<dex_ir::Header> header(dex_ir::DexIrBuilder(*dex_file,
-                                                               eagerly_assign_offsets,
-                                                               GetOptions()));
+  const bool eagerly_assign_offsets = EagerlyAssignOffsets();
+  const bool prepared = (prepared_dex_file_ == dex_file) && (prepared_header_ != nullptr);
+  std::unique_ptr<dex_ir::Header> header(
+      prepared ? prepared_header_.release()
+               : dex_ir::DexIrBuilder(*dex_file, eagerly_assign_offsets, GetOptions()));
+  prepared_dex_file_ = nullptr;
   SetHeader(header.get());
 
   if (options_.verbose_) {
@@ -1916,7 +1927,7 @@ bool DexLayout::ProcessDexFile(const char* file_name,
     // Layout information about what strings and code items are hot. Used by the writing process
     // to generate the sections that are stored in the oat file.
     bool do_layout = info_ != nullptr;
-    if (do_layout) {
+    if (do_layout && !prepared) {
       LayoutOutputFile(dex_file);
     }
     // The output needs a dex container, use a temporary one.
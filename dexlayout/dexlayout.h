@@ -118,6 +118,11 @@ class DexLayout {
                       std::unique_ptr<DexContainer>* dex_container,
                       std::string* error_msg);
 
+  // Builds the IR of `dex_file` and, with a profile, lays it out, so that a subsequent
+  // ProcessDexFile() for the same dex file only writes the output. Different DexLayout
+  // objects may prepare their dex files concurrently.
+  void PrepareDexFile(const DexFile* dex_file);
+
   dex_ir::Header* GetHeader() const { return header_; }
   void SetHeader(dex_ir::Header* header) { header_ = header; }
 
@@ -186,10 +191,15 @@ class DexLayout {
   void DumpCFG(const DexFile* dex_file, int idx);
   void DumpCFG(const DexFile* dex_file, uint32_t dex_method_idx, const dex::CodeItem* code);
 
+  bool EagerlyAssignOffsets() const;
+
   Options& options_;
   ProfileCompilationInfo* info_;
   FILE* out_file_;
   dex_ir::Header* header_;
+  // The IR built by PrepareDexFile(), if any, and the dex file it was built from.
+  std::unique_ptr<dex_ir::Header> prepared_header_;
+  const DexFile* prepared_dex_file_ = nullptr;
   DexLayoutSections dex_sections_;
   // Layout hotness information is only calculated when dexlayout is enabled.
   DexLayoutHotnessInfo layout_hotness_info_;
@@ -18,6 +18,13 @@
 #define ART_LIBARTBASE_BASE_HASH_SET_H_
 
 #include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
 
 #include <functional>
 #include <iterator>
@@ -152,8 +159,49 @@ using DefaultPred = typename std::conditional<std::is_same<T, std::string>::valu
                                               DefaultStringEquals,
                                               std::equal_to<T>>::type;
 
+namespace hash_set_detail {
+
+// Compares a group of kCtrlGroupSize control bytes against a value at once. Returns a mask
+// with kCtrlBitsPerSlot bits set for each matching byte, lowest address in the lowest bits.
+static constexpr size_t kCtrlGroupSize = 16u;
+#if defined(__SSE2__)
+static constexpr size_t kCtrlBitsPerSlot = 1u;
+
+ALWAYS_INLINE inline uint64_t MatchCtrlGroup(const uint8_t* ctrl, uint8_t value) {
+  __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+  __m128i matches = _mm_cmpeq_epi8(group, _mm_set1_epi8(static_cast<char>(value)));
+  return static_cast<uint32_t>(_mm_movemask_epi8(matches));
+}
+#elif defined(__aarch64__)
+static constexpr size_t kCtrlBitsPerSlot = 4u;
+
+ALWAYS_INLINE inline uint64_t MatchCtrlGroup(const uint8_t* ctrl, uint8_t value) {
+  uint8x16_t matches = vceqq_u8(vld1q_u8(ctrl), vdupq_n_u8(value));
+  // Narrow each 0x00/0xff byte to a nibble.
+  uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(matches), 4);
+  return vget_lane_u64(vreinterpret_u64_u8(nibbles), 0);
+}
+#else
+static constexpr size_t kCtrlBitsPerSlot = 1u;
+
+ALWAYS_INLINE inline uint64_t MatchCtrlGroup(const uint8_t* ctrl, uint8_t value) {
+  uint64_t mask = 0u;
+  for (size_t i = 0; i != kCtrlGroupSize; ++i) {
+    mask |= static_cast<uint64_t>(ctrl[i] == value) << i;
+  }
+  return mask;
+}
+#endif
+
+}  // namespace hash_set_detail
+
 // Low memory version of a hash set, uses less memory than std::unordered_multiset since elements
 // aren't boxed. Uses linear probing to resolve collisions.
+// When the set owns its storage, it also keeps one control byte per bucket holding 7 bits of the
+// element's hash, or zero for an empty bucket. Lookups compare 16 control bytes at a time and only
+// call Pred for the buckets with a matching hash fragment. The control bytes are rebuilt rather
+// than serialized, so the format written by WriteToMemory() is unchanged; sets using memory they
+// do not own, e.g. in an image, fall back to comparing every probed element.
 // EmptyFn needs to implement two functions MakeEmpty(T& item) and IsEmpty(const T& item).
 // TODO: We could get rid of this requirement by using a bitmap, though maybe this would be slower
 // and more complicated.
@@ -230,6 +278,11 @@ class HashSet {
     for (size_t i = 0; i < num_buckets_; ++i) {
       ElementForIndex(i) = other.data_[i];
     }
+    if (ctrl_ != nullptr && other.ctrl_ != nullptr) {
+      memcpy(ctrl_, other.ctrl_, CtrlSize(num_buckets_));
+    } else {
+      RebuildCtrl();
+    }
   }
 
   // noexcept required so that the move constructor is used instead of copy constructor.
@@ -244,6 +297,7 @@ class HashSet {
         elements_until_expand_(other.elements_until_expand_),
         owns_data_(other.owns_data_),
         data_(other.data_),
+        ctrl_(other.ctrl_),
         min_load_factor_(other.min_load_factor_),
         max_load_factor_(other.max_load_factor_) {
     other.num_elements_ = 0u;
@@ -251,6 +305,7 @@ class HashSet {
     other.elements_until_expand_ = 0u;
     other.owns_data_ = false;
     other.data_ = nullptr;
+    other.ctrl_ = nullptr;
   }
 
   // Construct from existing data.
@@ -279,6 +334,7 @@ class HashSet {
       for (size_t i = 0; i < num_buckets_; ++i) {
         offset = ReadFromBytes(ptr, offset, &data_[i]);
       }
+      RebuildCtrl();
     }
     // Caller responsible for aligning.
     *read_count = offset;
@@ -375,6 +431,7 @@ class HashSet {
       // If the next element is empty, we are done. Make sure to clear the current empty index.
       if (emptyfn_.IsEmpty(next_element)) {
         emptyfn_.MakeEmpty(ElementForIndex(empty_index));
+        SetCtrl(empty_index, kCtrlEmpty);
         break;
       }
       // Otherwise try to see if the next element can fill the current empty index.
@@ -397,6 +454,9 @@ class HashSet {
         // If the target index isn't within our current range it must have been probed from before
         // the empty index.
         ElementForIndex(empty_index) = std::move(next_element);
+        if (ctrl_ != nullptr) {
+          SetCtrl(empty_index, ctrl_[next_index]);
+        }
         filled = true;  // TODO: Optimize
         empty_index = next_index;
       }
@@ -460,6 +520,7 @@ class HashSet {
     }
     const size_t index = FirstAvailableSlot(IndexForHash(hash));
     data_[index] = std::forward<U>(element);
+    SetCtrl(index, CtrlForHash(hash));
     ++num_elements_;
     return iterator(this, index);
   }
@@ -472,6 +533,7 @@ class HashSet {
     swap(emptyfn_, other.emptyfn_);
     swap(pred_, other.pred_);
     std::swap(data_, other.data_);
+    std::swap(ctrl_, other.ctrl_);
     std::swap(num_buckets_, other.num_buckets_);
     std::swap(num_elements_, other.num_elements_);
     std::swap(elements_until_expand_, other.elements_until_expand_);
@@ -579,6 +641,10 @@ class HashSet {
   }
 
  private:
+  using CtrlAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<uint8_t>;
+
+  static constexpr uint8_t kCtrlEmpty = 0u;
+
   T& ElementForIndex(size_t index) {
     DCHECK_LT(index, NumBuckets());
     DCHECK(data_ != nullptr);
@@ -617,6 +683,9 @@ class HashSet {
     }
     DCHECK_EQ(hashfn_(element), hash);
     size_t index = IndexForHash(hash);
+    if (ctrl_ != nullptr) {
+      return FindIndexWithCtrl(element, hash, index);
+    }
     while (true) {
       const T& slot = ElementForIndex(index);
       if (emptyfn_.IsEmpty(slot)) {
@@ -629,10 +698,76 @@ class HashSet {
     }
   }
 
+  // Same as the probing loop of FindIndex(), but only compares the elements whose control
+  // byte matches the hash, a group of buckets at a time.
+  template <typename K>
+  size_t FindIndexWithCtrl(const K& element, size_t hash, size_t index) const {
+    using hash_set_detail::kCtrlBitsPerSlot;
+    using hash_set_detail::MatchCtrlGroup;
+    const uint8_t fragment = CtrlForHash(hash);
+    const size_t num_buckets = NumBuckets();
+    while (true) {
+      uint64_t matches = MatchCtrlGroup(ctrl_ + index, fragment);
+      const uint64_t empties = MatchCtrlGroup(ctrl_ + index, kCtrlEmpty);
+      if (empties != 0u) {
+        // Only the buckets before the first empty one are part of the probe sequence.
+        matches &= (empties & -empties) - 1u;
+      }
+      while (matches != 0u) {
+        const size_t bit = CTZ(matches);
+        size_t candidate = index + bit / kCtrlBitsPerSlot;
+        if (candidate >= num_buckets) {
+          candidate -= num_buckets;
+        }
+        if (pred_(ElementForIndex(candidate), element)) {
+          return candidate;
+        }
+        // Clear the bits of this bucket.
+        matches &= ~(((UINT64_C(1) << kCtrlBitsPerSlot) - 1u) << bit);
+      }
+      if (empties != 0u) {
+        return num_buckets;
+      }
+      index += hash_set_detail::kCtrlGroupSize;
+      if (index >= num_buckets) {
+        index -= num_buckets;
+      }
+    }
+  }
+
   bool IsFreeSlot(size_t index) const {
     return emptyfn_.IsEmpty(ElementForIndex(index));
   }
 
+  // Control byte of a bucket holding an element with the given hash. Uses hash bits which are
+  // mostly independent from the bucket index and is never kCtrlEmpty.
+  static uint8_t CtrlForHash(size_t hash) {
+    const uint64_t mixed = static_cast<uint64_t>(hash) * UINT64_C(0x9e3779b97f4a7c15);
+    return static_cast<uint8_t>(mixed >> 57) | 0x80u;
+  }
+
+  // The control bytes of the first buckets are repeated after the last bucket so that a group
+  // can be loaded from any bucket index.
+  static size_t CtrlSize(size_t num_buckets) {
+    return num_buckets + hash_set_detail::kCtrlGroupSize - 1u;
+  }
+
+  void SetCtrl(size_t index, uint8_t value) {
+    if (ctrl_ != nullptr) {
+      DCHECK_LT(index, NumBuckets());
+      ctrl_[index] = value;
+      if (index < hash_set_detail::kCtrlGroupSize - 1u) {
+        ctrl_[num_buckets_ + index] = value;
+      }
+    }
+  }
+
+  void RebuildCtrl() {
+    for (size_t i = 0; i < num_buckets_; ++i) {
+      SetCtrl(i, IsFreeSlot(i) ? kCtrlEmpty : CtrlForHash(hashfn_(data_[i])));
+    }
+  }
+
   // Allocate a number of buckets.
   void AllocateStorage(size_t num_buckets) {
     num_buckets_ = num_buckets;
@@ -642,6 +777,14 @@ class HashSet {
       allocfn_.construct(allocfn_.address(data_[i]));
       emptyfn_.MakeEmpty(data_[i]);
     }
+    // A group must not wrap around the table more than once.
+    if (num_buckets_ >= hash_set_detail::kCtrlGroupSize) {
+      CtrlAlloc ctrl_alloc(allocfn_);
+      ctrl_ = ctrl_alloc.allocate(CtrlSize(num_buckets_));
+      memset(ctrl_, kCtrlEmpty, CtrlSize(num_buckets_));
+    } else {
+      ctrl_ = nullptr;
+    }
   }
 
   void DeallocateStorage() {
@@ -652,9 +795,14 @@ class HashSet {
       if (data_ != nullptr) {
         allocfn_.deallocate(data_, NumBuckets());
       }
+      if (ctrl_ != nullptr) {
+        CtrlAlloc ctrl_alloc(allocfn_);
+        ctrl_alloc.deallocate(ctrl_, CtrlSize(NumBuckets()));
+      }
       owns_data_ = false;
     }
     data_ = nullptr;
+    ctrl_ = nullptr;
     num_buckets_ = 0;
   }
 
@@ -672,6 +820,7 @@ class HashSet {
     }
     DCHECK_GE(new_size, size());
     T* const old_data = data_;
+    uint8_t* const old_ctrl = ctrl_;
     size_t old_num_buckets = num_buckets_;
     // Reinsert all of the old elements.
     const bool owned_data = owns_data_;
@@ -679,7 +828,10 @@ class HashSet {
     for (size_t i = 0; i < old_num_buckets; ++i) {
       T& element = old_data[i];
       if (!emptyfn_.IsEmpty(element)) {
-        data_[FirstAvailableSlot(IndexForHash(hashfn_(element)))] = std::move(element);
+        const size_t hash = hashfn_(element);
+        const size_t index = FirstAvailableSlot(IndexForHash(hash));
+        data_[index] = std::move(element);
+        SetCtrl(index, CtrlForHash(hash));
       }
       if (owned_data) {
         allocfn_.destroy(allocfn_.address(element));
@@ -687,6 +839,10 @@ class HashSet {
     }
     if (owned_data) {
       allocfn_.deallocate(old_data, old_num_buckets);
+      if (old_ctrl != nullptr) {
+        CtrlAlloc ctrl_alloc(allocfn_);
+        ctrl_alloc.deallocate(old_ctrl, CtrlSize(old_num_buckets));
+      }
     }
 
     // When we hit elements_until_expand_, we are at the max load factor and must expand again.
@@ -740,6 +896,7 @@ class HashSet {
   size_t elements_until_expand_;  // Maximum number of elements until we expand the table.
   bool owns_data_;  // If we own data_ and are responsible for freeing it.
   T* data_;  // Backing storage.
+  uint8_t* ctrl_ = nullptr;  // Control bytes, only when we own data_.
   double min_load_factor_;
   double max_load_factor_;
 
@@ -373,4 +373,78 @@ TEST_F(HashSetTest, StringSearchyStringView) {
   ASSERT_TRUE(it == insert_pos);
 }
 
+// Hash which maps many strings to a few hash values so that probe sequences get long and the
+// control bytes of distinct elements match.
+struct CollidingStringHash {
+  size_t operator()(const std::string& s) const {
+    return std::hash<std::string>()(s) % 7u;
+  }
+};
+
+TEST_F(HashSetTest, ControlBytes) {
+  using StringSet =
+      HashSet<std::string, IsEmptyFnString, CollidingStringHash, std::equal_to<std::string>>;
+  StringSet hash_set;
+  std::unordered_multiset<std::string> std_set;
+  std::vector<std::string> strings;
+  for (size_t i = 0; i < 200; ++i) {
+    strings.push_back(RandomString(8));
+  }
+  auto check = [&](const StringSet& set) {
+    ASSERT_EQ(set.size(), std_set.size());
+    for (const std::string& s : strings) {
+      ASSERT_EQ(set.find(s) != set.end(), std_set.find(s) != std_set.end()) << s;
+    }
+  };
+  for (size_t i = 0; i < 5000; ++i) {
+    const std::string& s = strings[PRand() % strings.size()];
+    if (PRand() % 3 != 0u) {
+      hash_set.insert(s);
+      std_set.insert(s);
+    } else {
+      auto it = hash_set.find(s);
+      auto std_it = std_set.find(s);
+      ASSERT_EQ(it != hash_set.end(), std_it != std_set.end());
+      if (it != hash_set.end()) {
+        hash_set.erase(it);
+        std_set.erase(std_it);
+      }
+    }
+    if (i % 500 == 0u) {
+      check(hash_set);
+    }
+  }
+  check(hash_set);
+  check(StringSet(hash_set));
+  hash_set.ShrinkToMaximumLoad();
+  check(hash_set);
+}
+
+TEST_F(HashSetTest, ControlBytesAfterDeserialization) {
+  HashSet<uint64_t> hash_set;
+  for (uint64_t i = 1; i <= 1000; ++i) {
+    hash_set.insert(i * 17u);
+  }
+  std::vector<uint8_t> buffer(hash_set.WriteToMemory(nullptr));
+  hash_set.WriteToMemory(buffer.data());
+  for (bool make_copy_of_data : {false, true}) {
+    size_t read_count;
+    HashSet<uint64_t> read_set(buffer.data(), make_copy_of_data, &read_count);
+    EXPECT_EQ(read_count, buffer.size());
+    EXPECT_EQ(read_set.size(), hash_set.size());
+    for (uint64_t i = 1; i <= 1000; ++i) {
+      EXPECT_NE(read_set.find(i * 17u), read_set.end());
+      EXPECT_EQ(read_set.find(i * 17u + 1u), read_set.end());
+    }
+    if (make_copy_of_data) {
+      // The copy owns its storage and can be modified.
+      read_set.insert(7u);
+      EXPECT_NE(read_set.find(7u), read_set.end());
+      read_set.erase(read_set.find(17u));
+      EXPECT_EQ(read_set.find(17u), read_set.end());
+      EXPECT_NE(read_set.find(34u), read_set.end());
+    }
+  }
+}
+
 }  // namespace art
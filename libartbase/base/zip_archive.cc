@@ -267,6 +267,10 @@ ZipEntry* ZipArchive::Find(const char* name, std::string* error_msg) const {
   return new ZipEntry(handle_, zip_entry.release(), name);
 }
 
+int ZipArchive::GetFileDescriptor() const {
+  return ::GetFileDescriptor(handle_);
+}
+
 ZipArchive::~ZipArchive() {
   CloseArchive(handle_);
 }
@@ -90,6 +90,9 @@ class ZipArchive {
 
   ZipEntry* Find(const char* name, std::string* error_msg) const;
 
+  // Returns the file descriptor of the archive.
+  int GetFileDescriptor() const;
+
   ~ZipArchive();
 
  private:
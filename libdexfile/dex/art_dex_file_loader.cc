@@ -18,6 +18,12 @@
 
 #include <sys/stat.h>
 
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <tuple>
+
 #include "android-base/stringprintf.h"
 
 #include "base/file_magic.h"
@@ -77,8 +83,100 @@ class MemMapContainer : public DexFileContainer {
   DISALLOW_COPY_AND_ASSIGN(MemMapContainer);
 };
 
+// Identifies the contents of a dex file by the file it was read from and, for zip
+// files, the entry name.
+struct DexFileIdentity {
+  dev_t device;
+  ino_t inode;
+  off_t size;
+  int64_t mtime_ns;
+  std::string entry_name;
+
+  bool operator<(const DexFileIdentity& other) const {
+    return std::tie(device, inode, size, mtime_ns, entry_name) <
+        std::tie(other.device, other.inode, other.size, other.mtime_ns, other.entry_name);
+  }
+};
+
+// Checksums of dex files that have been verified to match the checksum in their header.
+class ChecksumCache {
+ public:
+  bool Contains(const DexFileIdentity& identity, uint32_t checksum) {
+    std::lock_guard<std::mutex> lock(lock_);
+    auto it = checksums_.find(identity);
+    bool found = it != checksums_.end() && it->second == checksum;
+    ++(found ? hits_ : misses_);
+    return found;
+  }
+
+  void Add(const DexFileIdentity& identity, uint32_t checksum) {
+    std::lock_guard<std::mutex> lock(lock_);
+    checksums_.insert_or_assign(identity, checksum);
+  }
+
+  size_t GetHits() {
+    std::lock_guard<std::mutex> lock(lock_);
+    return hits_;
+  }
+
+  size_t GetMisses() {
+    std::lock_guard<std::mutex> lock(lock_);
+    return misses_;
+  }
+
+ private:
+  std::mutex lock_;
+  std::map<DexFileIdentity, uint32_t> checksums_;
+  size_t hits_ = 0u;
+  size_t misses_ = 0u;
+};
+
+std::atomic<bool> gUseChecksumCache(false);
+
+ChecksumCache& GetChecksumCache() {
+  static ChecksumCache* cache = new ChecksumCache();
+  return *cache;
+}
+
+// Returns the identity under which the checksum of the dex file in `fd`, or in its
+// `entry_name` if it is a zip file, is cached, or no value if the cache is not used.
+std::optional<DexFileIdentity> GetChecksumCacheIdentity(int fd,
+                                                        const char* entry_name,
+                                                        bool verify,
+                                                        bool verify_checksum) {
+  if (!verify || !verify_checksum || !gUseChecksumCache.load(std::memory_order_relaxed)) {
+    return std::nullopt;
+  }
+  struct stat sbuf;
+  if (fd < 0 || fstat(fd, &sbuf) == -1 || !S_ISREG(sbuf.st_mode)) {
+    return std::nullopt;
+  }
+#if defined(__APPLE__)
+  const struct timespec& mtime = sbuf.st_mtimespec;
+#else
+  const struct timespec& mtime = sbuf.st_mtim;
+#endif
+  return DexFileIdentity{sbuf.st_dev,
+                         sbuf.st_ino,
+                         sbuf.st_size,
+                         static_cast<int64_t>(mtime.tv_sec) * 1000000000 + mtime.tv_nsec,
+                         entry_name};
+}
+
 }  // namespace
 
+void ArtDexFileLoader::SetUseChecksumCache(bool use_checksum_cache) {
+  gUseChecksumCache.store(use_checksum_cache, std::memory_order_relaxed);
+}
+
+size_t ArtDexFileLoader::GetChecksumCacheHits() {
+  return GetChecksumCache().GetHits();
+}
+
+size_t ArtDexFileLoader::GetChecksumCacheMisses() {
+  return GetChecksumCache().GetMisses();
+}
+
 using android::base::StringPrintf;
 
 static constexpr OatDexFile* kNoOatDexFile = nullptr;
@@ -315,6 +413,8 @@ std::unique_ptr<const DexFile> ArtDexFileLoader::OpenFile(int fd,
                                                           std::string* error_msg) const {
   ScopedTrace trace(std::string("Open dex file ") + std::string(location));
   CHECK(!location.empty());
+  std::optional<DexFileIdentity> identity =
+      GetChecksumCacheIdentity(fd, /*entry_name=*/ "", verify, verify_checksum);
   MemMap map;
   {
     File delayed_close(fd, /* check_usage= */ false);
@@ -354,19 +454,28 @@ std::unique_ptr<const DexFile> ArtDexFileLoader::OpenFile(int fd,
   }
 
   const DexFile::Header* dex_header = reinterpret_cast<const DexFile::Header*>(begin);
+  const uint32_t header_checksum = dex_header->checksum_;
+  const bool checksum_verified =
+      identity.has_value() && GetChecksumCache().Contains(*identity, header_checksum);
 
   std::unique_ptr<DexFile> dex_file = OpenCommon(begin,
                                                  size,
                                                  /*data_base=*/ nullptr,
                                                  /*data_size=*/ 0u,
                                                  location,
-                                                 dex_header->checksum_,
+                                                 header_checksum,
                                                  kNoOatDexFile,
                                                  verify,
-                                                 verify_checksum,
+                                                 verify_checksum && !checksum_verified,
                                                  error_msg,
                                                  std::make_unique<MemMapContainer>(std::move(map)),
                                                  /*verify_result=*/ nullptr);
+  if (dex_file != nullptr &&
+      !dex_file->IsCompactDexFile() &&
+      identity.has_value() &&
+      !checksum_verified) {
+    GetChecksumCache().Add(*identity, header_checksum);
+  }
 
   // Opening CompactDex is only supported from vdex files.
   if (dex_file != nullptr && dex_file->IsCompactDexFile()) {
@@ -432,6 +541,13 @@ std::unique_ptr<const DexFile> ArtDexFileLoader::OpenOneDexFileFromZip(
   VerifyResult verify_result;
   uint8_t* begin = map.Begin();
   size_t size = map.Size();
+  std::optional<DexFileIdentity> identity = GetChecksumCacheIdentity(
+      zip_archive.GetFileDescriptor(), entry_name, verify, verify_checksum);
+  const uint32_t header_checksum = (size >= sizeof(DexFile::Header))
+      ? reinterpret_cast<const DexFile::Header*>(begin)->checksum_
+      : 0u;
+  const bool checksum_verified =
+      identity.has_value() && GetChecksumCache().Contains(*identity, header_checksum);
   std::unique_ptr<DexFile> dex_file = OpenCommon(begin,
                                                  size,
                                                  /*data_base=*/ nullptr,
@@ -440,10 +556,16 @@ std::unique_ptr<const DexFile> ArtDexFileLoader::OpenOneDexFileFromZip(
                                                  zip_entry->GetCrc32(),
                                                  kNoOatDexFile,
                                                  verify,
-                                                 verify_checksum,
+                                                 verify_checksum && !checksum_verified,
                                                  error_msg,
                                                  std::make_unique<MemMapContainer>(std::move(map)),
                                                  &verify_result);
+  if (verify_result == VerifyResult::kVerifySucceeded &&
+      !dex_file->IsCompactDexFile() &&
+      identity.has_value() &&
+      !checksum_verified) {
+    GetChecksumCache().Add(*identity, header_checksum);
+  }
   if (dex_file != nullptr && dex_file->IsCompactDexFile()) {
     *error_msg = StringPrintf("Opening CompactDex file '%s' is only supported from vdex files",
                               location.c_str());
@@ -103,6 +103,17 @@ class ArtDexFileLoader : public DexFileLoader {
                std::string* error_msg,
                std::vector<std::unique_ptr<const DexFile>>* dex_files) const;
 
+  // Enables or disables the process-wide cache of verified dex file checksums. Entries are
+  // keyed by the device, inode, size and modification time of the file the dex data was
+  // read from, and by the zip entry name, so that opening an unchanged file again does not
+  // recompute the checksum.
+  static void SetUseChecksumCache(bool use_checksum_cache);
+
+  // Number of dex files whose checksum was found in, or missing from, the cache when they
+  // were opened with the cache enabled.
+  static size_t GetChecksumCacheHits();
+  static size_t GetChecksumCacheMisses();
+
  private:
   bool OpenWithMagic(uint32_t magic,
                      int fd,
@@ -17,6 +17,8 @@
 #include "art_dex_file_loader.h"
 
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <zlib.h>
 
 #include <memory>
 
@@ -94,6 +96,105 @@ TEST_F(ArtDexFileLoaderTest, GetMultiDexChecksums) {
   EXPECT_EQ(dexes[1]->GetLocationChecksum(), checksums[1]);
 }
 
+TEST_F(ArtDexFileLoaderTest, ChecksumMemoryRange) {
+  // Large enough to be checksummed in parallel chunks.
+  std::vector<uint8_t> data(40 * MB + 12345);
+  uint32_t state = 1u;
+  for (uint8_t& byte : data) {
+    state = state * 1103515245u + 12345u;
+    byte = static_cast<uint8_t>(state >> 24);
+  }
+  for (size_t size : {data.size(), 16 * MB, 16 * MB - 1u, kPageSize, size_t(1u), size_t(0u)}) {
+    uint32_t expected = adler32(adler32(0L, Z_NULL, 0), data.data(), size);
+    EXPECT_EQ(expected, DexFile::ChecksumMemoryRange(data.data(), size)) << size;
+    for (size_t num_threads : {2u, 3u, 4u, 16u}) {
+      EXPECT_EQ(expected, DexFile::ChecksumMemoryRange(data.data(), size, num_threads))
+          << size << " " << num_threads;
+    }
+  }
+}
+
+TEST_F(ArtDexFileLoaderTest, ChecksumCache) {
+  ArtDexFileLoader::SetUseChecksumCache(true);
+  std::string filename = GetTestDexFileName("MultiDex");
+  const ArtDexFileLoader dex_file_loader;
+  for (size_t i = 0; i != 2u; ++i) {
+    const size_t hits = ArtDexFileLoader::GetChecksumCacheHits();
+    const size_t misses = ArtDexFileLoader::GetChecksumCacheMisses();
+    std::string error_msg;
+    std::vector<std::unique_ptr<const DexFile>> dex_files;
+    ASSERT_TRUE(dex_file_loader.Open(filename.c_str(),
+                                     filename,
+                                     /*verify=*/ true,
+                                     /*verify_checksum=*/ true,
+                                     &error_msg,
+                                     &dex_files)) << error_msg;
+    ASSERT_EQ(2u, dex_files.size());
+    for (const std::unique_ptr<const DexFile>& dex_file : dex_files) {
+      EXPECT_EQ(dex_file->GetHeader().checksum_, dex_file->CalculateChecksum());
+    }
+    // Both entries of the zip file are looked up. The second time, both are found and
+    // their checksums are not computed again.
+    EXPECT_EQ(2u, ArtDexFileLoader::GetChecksumCacheHits() - hits +
+                  ArtDexFileLoader::GetChecksumCacheMisses() - misses);
+    if (i == 1u) {
+      EXPECT_EQ(hits + 2u, ArtDexFileLoader::GetChecksumCacheHits());
+      EXPECT_EQ(misses, ArtDexFileLoader::GetChecksumCacheMisses());
+    }
+  }
+  ArtDexFileLoader::SetUseChecksumCache(false);
+}
+
+TEST_F(ArtDexFileLoaderTest, ChecksumCacheInvalidatedOnChange) {
+  // Copy a dex file to a file this test can modify.
+  std::unique_ptr<const DexFile> original = OpenTestDexFile("Main");
+  ASSERT_TRUE(original != nullptr);
+  ScratchFile tmp;
+  ASSERT_TRUE(tmp.GetFile()->WriteFully(original->Begin(), original->Size()));
+  ASSERT_EQ(0, tmp.GetFile()->Flush());
+
+  ArtDexFileLoader::SetUseChecksumCache(true);
+  const ArtDexFileLoader dex_file_loader;
+  auto open = [&](std::string* error_msg) {
+    std::vector<std::unique_ptr<const DexFile>> dex_files;
+    return dex_file_loader.Open(tmp.GetFilename().c_str(),
+                                tmp.GetFilename(),
+                                /*verify=*/ true,
+                                /*verify_checksum=*/ true,
+                                error_msg,
+                                &dex_files);
+  };
+
+  std::string error_msg;
+  size_t misses = ArtDexFileLoader::GetChecksumCacheMisses();
+  ASSERT_TRUE(open(&error_msg)) << error_msg;
+  EXPECT_EQ(misses + 1u, ArtDexFileLoader::GetChecksumCacheMisses());
+
+  size_t hits = ArtDexFileLoader::GetChecksumCacheHits();
+  ASSERT_TRUE(open(&error_msg)) << error_msg;
+  EXPECT_EQ(hits + 1u, ArtDexFileLoader::GetChecksumCacheHits());
+
+  // Corrupt the last byte without changing the size or the checksum in the header, and
+  // move the modification time forward in case the write happens within the same tick.
+  struct stat sbuf;
+  ASSERT_EQ(0, fstat(tmp.GetFd(), &sbuf));
+  const uint8_t corrupted = original->Begin()[original->Size() - 1u] ^ 0xffu;
+  ASSERT_TRUE(tmp.GetFile()->PwriteFully(&corrupted, 1u, original->Size() - 1u));
+  ASSERT_EQ(0, tmp.GetFile()->Flush());
+  struct timespec times[2] = {{0, UTIME_OMIT}, {sbuf.st_mtime + 1, 0}};
+  ASSERT_EQ(0, futimens(tmp.GetFd(), times));
+
+  // The cached entry no longer matches the file, so the checksum is verified again.
+  hits = ArtDexFileLoader::GetChecksumCacheHits();
+  misses = ArtDexFileLoader::GetChecksumCacheMisses();
+  EXPECT_FALSE(open(&error_msg));
+  EXPECT_NE(std::string::npos, error_msg.find("checksum")) << error_msg;
+  EXPECT_EQ(hits, ArtDexFileLoader::GetChecksumCacheHits());
+  EXPECT_EQ(misses + 1u, ArtDexFileLoader::GetChecksumCacheMisses());
+
+  ArtDexFileLoader::SetUseChecksumCache(false);
+}
+
 TEST_F(ArtDexFileLoaderTest, ClassDefs) {
   std::unique_ptr<const DexFile> raw(OpenTestDexFile("Nested"));
   ASSERT_TRUE(raw.get() != nullptr);
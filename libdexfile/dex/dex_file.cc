@@ -22,13 +22,17 @@
 #include <string.h>
 #include <zlib.h>
 
+#include <algorithm>
 #include <memory>
 #include <ostream>
 #include <sstream>
+#include <thread>
 #include <type_traits>
+#include <vector>
 
 #include "android-base/stringprintf.h"
 
+#include "base/bit_utils.h"
 #include "base/enums.h"
 #include "base/leb128.h"
 #include "base/stl_util.h"
@@ -64,13 +68,63 @@ uint32_t DexFile::CalculateChecksum() const {
   return CalculateChecksum(Begin(), Size());
 }
 
-uint32_t DexFile::CalculateChecksum(const uint8_t* begin, size_t size) {
+uint32_t DexFile::CalculateChecksum(const uint8_t* begin, size_t size, size_t num_threads) {
   const uint32_t non_sum_bytes = OFFSETOF_MEMBER(DexFile::Header, signature_);
-  return ChecksumMemoryRange(begin + non_sum_bytes, size - non_sum_bytes);
+  return ChecksumMemoryRange(begin + non_sum_bytes, size - non_sum_bytes, num_threads);
 }
 
-uint32_t DexFile::ChecksumMemoryRange(const uint8_t* begin, size_t size) {
-  return adler32(adler32(0L, Z_NULL, 0), begin, size);
+// Ranges smaller than this are checksummed on the calling thread; for larger ones the
+// cost of starting threads is small compared to reading the data.
+static constexpr size_t kParallelChecksumMinSize = 16 * MB;
+// Minimum amount of data checksummed by each thread.
+static constexpr size_t kParallelChecksumMinChunkSize = 4 * MB;
+
+static uint32_t Adler32(uint32_t adler, const uint8_t* begin, size_t size) {
+  // zlib takes a `uInt` length, so feed it ranges of at most 1GiB at a time.
+  static constexpr size_t kMaxAdler32Size = 1 * GB;
+  while (size > kMaxAdler32Size) {
+    adler = adler32(adler, begin, kMaxAdler32Size);
+    begin += kMaxAdler32Size;
+    size -= kMaxAdler32Size;
+  }
+  return adler32(adler, begin, size);
+}
+
+uint32_t DexFile::ChecksumMemoryRange(const uint8_t* begin, size_t size, size_t num_threads) {
+  const uint32_t initial_adler = adler32(0L, Z_NULL, 0);
+  size_t num_chunks = 1u;
+  if (num_threads > 1u && size >= kParallelChecksumMinSize) {
+    num_chunks = std::min(num_threads, size / kParallelChecksumMinChunkSize);
+  }
+  if (num_chunks <= 1u) {
+    return Adler32(initial_adler, begin, size);
+  }
+
+  // Checksum equally sized chunks in parallel, the last one on this thread, and
+  // combine the results. adler32_combine() only needs the length of the second range.
+  const size_t chunk_size = RoundUp(size / num_chunks, kPageSize);
+  std::vector<uint32_t> chunk_checksums(num_chunks);
+  std::vector<std::thread> threads;
+  threads.reserve(num_chunks - 1u);
+  for (size_t i = 0; i != num_chunks - 1u; ++i) {
+    threads.emplace_back([=, &chunk_checksums]() {
+      chunk_checksums[i] = Adler32(initial_adler, begin + i * chunk_size, chunk_size);
+    });
+  }
+  const size_t last_chunk_offset = (num_chunks - 1u) * chunk_size;
+  const size_t last_chunk_size = size - last_chunk_offset;
+  chunk_checksums[num_chunks - 1u] =
+      Adler32(initial_adler, begin + last_chunk_offset, last_chunk_size);
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  uint32_t checksum = chunk_checksums[0];
+  for (size_t i = 1; i != num_chunks; ++i) {
+    size_t length = (i == num_chunks - 1u) ? last_chunk_size : chunk_size;
+    checksum = adler32_combine(checksum, chunk_checksums[i], static_cast<z_off_t>(length));
+  }
+  return checksum;
 }
 
 int DexFile::GetPermissions() const {
@@ -736,8 +736,10 @@ class DexFile {
 
   // Recalculates the checksum of the dex file. Does not use the current value in the header.
   virtual uint32_t CalculateChecksum() const;
-  static uint32_t CalculateChecksum(const uint8_t* begin, size_t size);
-  static uint32_t ChecksumMemoryRange(const uint8_t* begin, size_t size);
+  static uint32_t CalculateChecksum(const uint8_t* begin, size_t size, size_t num_threads = 1u);
+  // Returns the adler32 checksum of the range. Large ranges are split between up to
+  // `num_threads` threads, including the calling thread.
+  static uint32_t ChecksumMemoryRange(const uint8_t* begin, size_t size, size_t num_threads = 1u);
 
   // Number of bytes at the beginning of the dex file header which are skipped
   // when computing the adler32 checksum of the entire file.
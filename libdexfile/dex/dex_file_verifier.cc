@@ -310,15 +310,21 @@ bool DexFileVerifier::CheckHeader() {
     return false;
   }
 
-  uint32_t adler_checksum = dex_file_->CalculateChecksum();
-  // Compute and verify the checksum in the header.
-  if (adler_checksum != header_->checksum_) {
-    if (verify_checksum_) {
-      ErrorStringPrintf("Bad checksum (%08x, expected %08x)", adler_checksum, header_->checksum_);
-      return false;
-    } else {
-      LOG(WARNING) << StringPrintf(
-          "Ignoring bad checksum (%08x, expected %08x)", adler_checksum, header_->checksum_);
+  // Compute and verify the checksum in the header. Checksumming reads the whole file. When the
+  // caller does not ask for it, only debug builds compute it to warn about mismatches. Callers
+  // skip the check when the checksum is already known to match, as for dex files found in the
+  // checksum cache of ArtDexFileLoader, and computing it again just for the warning would undo
+  // that saving. Release builds therefore no longer print "Ignoring bad checksum".
+  if (verify_checksum_ || kIsDebugBuild) {
+    uint32_t adler_checksum = dex_file_->CalculateChecksum();
+    if (adler_checksum != header_->checksum_) {
+      if (verify_checksum_) {
+        ErrorStringPrintf("Bad checksum (%08x, expected %08x)", adler_checksum, header_->checksum_);
+        return false;
+      } else {
+        LOG(WARNING) << StringPrintf(
+            "Ignoring bad checksum (%08x, expected %08x)", adler_checksum, header_->checksum_);
+      }
     }
   }
 
@@ -16,10 +16,19 @@
 
 #include "utf.h"
 
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 #include <android-base/logging.h>
 #include <android-base/stringprintf.h>
 #include <android-base/strings.h>
 
+#include "base/bit_utils.h"
 #include "base/casts.h"
 #include "utf-inl.h"
 
@@ -27,6 +36,114 @@ namespace art {
 
 using android::base::StringAppendF;
 
+// Most strings processed by the runtime are ASCII. The helpers below handle runs of ASCII
+// characters 16 bytes or 8 UTF-16 chars at a time with SSE2 on x86 and NEON on arm64, and
+// fall back to scalar code for the remainder and on other architectures.
+
+// Returns the length of the longest prefix of the `length` bytes at `utf8`
+// consisting only of one-byte encodings.
+static inline size_t AsciiPrefixLength(const uint8_t* utf8, size_t length) {
+  size_t i = 0u;
+#if defined(__SSE2__)
+  for (; i + 16u <= length; i += 16u) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(utf8 + i));
+    uint32_t non_ascii = static_cast<uint32_t>(_mm_movemask_epi8(block));
+    if (non_ascii != 0u) {
+      return i + CTZ(non_ascii);
+    }
+  }
+#elif defined(__aarch64__)
+  for (; i + 16u <= length; i += 16u) {
+    if (vmaxvq_u8(vld1q_u8(utf8 + i)) >= 0x80u) {
+      break;
+    }
+  }
+#endif
+  while (i != length && utf8[i] < 0x80u) {
+    ++i;
+  }
+  return i;
+}
+
+// Returns the length of the longest prefix of the `length` chars at `utf16`
+// consisting only of characters encoded in one byte of modified UTF-8, i.e. U+0001 - U+007F.
+static inline size_t Utf16AsciiPrefixLength(const uint16_t* utf16, size_t length) {
+  size_t i = 0u;
+#if defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i non_ascii_bits = _mm_set1_epi16(static_cast<int16_t>(0xff80));
+  for (; i + 8u <= length; i += 8u) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(utf16 + i));
+    __m128i is_ascii = _mm_cmpeq_epi16(_mm_and_si128(block, non_ascii_bits), zero);
+    __m128i is_one_byte = _mm_andnot_si128(_mm_cmpeq_epi16(block, zero), is_ascii);
+    uint32_t multi_byte = static_cast<uint32_t>(_mm_movemask_epi8(is_one_byte)) ^ 0xffffu;
+    if (multi_byte != 0u) {
+      // Two mask bits per char.
+      return i + CTZ(multi_byte) / 2u;
+    }
+  }
+#elif defined(__aarch64__)
+  const uint16x8_t one = vdupq_n_u16(1u);
+  const uint16x8_t limit = vdupq_n_u16(0x7fu);
+  for (; i + 8u <= length; i += 8u) {
+    // U+0000 wraps around to 0xffff.
+    uint16x8_t is_one_byte = vcltq_u16(vsubq_u16(vld1q_u16(utf16 + i), one), limit);
+    if (vminvq_u16(is_one_byte) == 0u) {
+      break;
+    }
+  }
+#endif
+  while (i != length && static_cast<uint16_t>(utf16[i] - 1u) < 0x7fu) {
+    ++i;
+  }
+  return i;
+}
+
+// Converts `length` one-byte encodings at `utf8` to UTF-16.
+static inline void WidenAscii(uint16_t* utf16_out, const uint8_t* utf8, size_t length) {
+  size_t i = 0u;
+#if defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 16u <= length; i += 16u) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(utf8 + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(utf16_out + i), _mm_unpacklo_epi8(block, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(utf16_out + i + 8u),
+                     _mm_unpackhi_epi8(block, zero));
+  }
+#elif defined(__aarch64__)
+  for (; i + 16u <= length; i += 16u) {
+    uint8x16_t block = vld1q_u8(utf8 + i);
+    vst1q_u16(utf16_out + i, vmovl_u8(vget_low_u8(block)));
+    vst1q_u16(utf16_out + i + 8u, vmovl_high_u8(block));
+  }
+#endif
+  for (; i != length; ++i) {
+    utf16_out[i] = utf8[i];
+  }
+}
+
+// Converts `length` UTF-16 chars in the range U+0000 - U+007F at `utf16` to one byte each.
+static inline void NarrowAscii(char* utf8_out, const uint16_t* utf16, size_t length) {
+  size_t i = 0u;
+#if defined(__SSE2__)
+  for (; i + 16u <= length; i += 16u) {
+    __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(utf16 + i));
+    __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(utf16 + i + 8u));
+    // The values fit in a signed byte, so the saturating pack is exact.
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(utf8_out + i), _mm_packus_epi16(low, high));
+  }
+#elif defined(__aarch64__)
+  for (; i + 16u <= length; i += 16u) {
+    uint8x8_t low = vmovn_u16(vld1q_u16(utf16 + i));
+    uint8x16_t block = vmovn_high_u16(low, vld1q_u16(utf16 + i + 8u));
+    vst1q_u8(reinterpret_cast<uint8_t*>(utf8_out) + i, block);
+  }
+#endif
+  for (; i != length; ++i) {
+    utf8_out[i] = dchecked_integral_cast<char>(utf16[i]);
+  }
+}
+
 // This is used only from debugger and test code.
 size_t CountModifiedUtf8Chars(const char* utf8) {
   return CountModifiedUtf8Chars(utf8, strlen(utf8));
@@ -52,12 +169,17 @@ size_t CountModifiedUtf8Chars(const char* utf8, size_t byte_count) {
   size_t len = 0;
   const char* end = utf8 + byte_count;
   for (; utf8 < end; ++utf8) {
+    // Each one-byte encoding is one UTF-16 char.
+    size_t ascii_length =
+        AsciiPrefixLength(reinterpret_cast<const uint8_t*>(utf8), static_cast<size_t>(end - utf8));
+    len += ascii_length;
+    utf8 += ascii_length;
+    if (utf8 == end) {
+      break;
+    }
     int ic = *utf8;
     len++;
-    if (LIKELY((ic & 0x80) == 0)) {
-      // One-byte encoding.
-      continue;
-    }
+    DCHECK_NE(ic & 0x80, 0);
     // Two- or three-byte encoding.
     utf8++;
     if ((ic & 0x20) == 0) {
@@ -100,16 +222,20 @@ void ConvertModifiedUtf8ToUtf16(uint16_t* utf16_data_out, size_t out_chars,
 
   if (LIKELY(out_chars == in_bytes)) {
     // Common case where all characters are ASCII.
-    for (const char *p = in_start; p < in_end;) {
-      // Safe even if char is signed because ASCII characters always have
-      // the high bit cleared.
-      *out_p++ = dchecked_integral_cast<uint16_t>(*p++);
-    }
+    WidenAscii(out_p, reinterpret_cast<const uint8_t*>(in_start), in_bytes);
     return;
   }
 
   // String contains non-ASCII characters.
   for (const char *p = in_start; p < in_end;) {
+    size_t ascii_length =
+        AsciiPrefixLength(reinterpret_cast<const uint8_t*>(p), static_cast<size_t>(in_end - p));
+    WidenAscii(out_p, reinterpret_cast<const uint8_t*>(p), ascii_length);
+    out_p += ascii_length;
+    p += ascii_length;
+    if (p == in_end) {
+      break;
+    }
     const uint32_t ch = GetUtf16FromUtf8(&p);
     const uint16_t leading = GetLeadingUtf16Char(ch);
     const uint16_t trailing = GetTrailingUtf16Char(ch);
@@ -125,15 +251,21 @@ void ConvertUtf16ToModifiedUtf8(char* utf8_out, size_t byte_count,
                                 const uint16_t* utf16_in, size_t char_count) {
   if (LIKELY(byte_count == char_count)) {
     // Common case where all characters are ASCII.
-    const uint16_t *utf16_end = utf16_in + char_count;
-    for (const uint16_t *p = utf16_in; p < utf16_end;) {
-      *utf8_out++ = dchecked_integral_cast<char>(*p++);
-    }
+    NarrowAscii(utf8_out, utf16_in, char_count);
     return;
   }
 
   // String contains non-ASCII characters.
-  while (char_count--) {
+  while (char_count != 0u) {
+    size_t ascii_length = Utf16AsciiPrefixLength(utf16_in, char_count);
+    NarrowAscii(utf8_out, utf16_in, ascii_length);
+    utf8_out += ascii_length;
+    utf16_in += ascii_length;
+    char_count -= ascii_length;
+    if (char_count == 0u) {
+      break;
+    }
+    --char_count;
     const uint16_t ch = *utf16_in++;
     if (ch > 0 && ch <= 0x7f) {
       *utf8_out++ = ch;
@@ -192,10 +324,20 @@ int32_t ComputeUtf16HashFromModifiedUtf8(const char* utf8, size_t utf16_length)
 }
 
 uint32_t ComputeModifiedUtf8Hash(const char* chars) {
+  // Find the length with the vectorized strlen() and then hash four bytes per step,
+  // which shortens the chain of dependent multiplications four times. This yields
+  // the same result as `hash = hash * 31 + c` for each byte `c` in modular arithmetic.
+  static constexpr uint32_t k31Pow2 = 31u * 31u;
+  static constexpr uint32_t k31Pow3 = 31u * 31u * 31u;
+  static constexpr uint32_t k31Pow4 = 31u * 31u * 31u * 31u;
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(chars);
+  size_t length = strlen(chars);
   uint32_t hash = 0;
-  while (*chars != '\0') {
-    hash = hash * 31 + static_cast<uint8_t>(*chars);
-    ++chars;
+  for (; length >= 4u; length -= 4u, p += 4u) {
+    hash = hash * k31Pow4 + p[0] * k31Pow3 + p[1] * k31Pow2 + p[2] * 31u + p[3];
+  }
+  for (; length != 0u; --length, ++p) {
+    hash = hash * 31 + *p;
   }
   return hash;
 }
@@ -240,6 +382,13 @@ size_t CountUtf8Bytes(const uint16_t* chars, size_t char_count) {
   size_t result = 0;
   const uint16_t *end = chars + char_count;
   while (chars < end) {
+    // Each char in U+0001 - U+007F is encoded in one byte.
+    size_t ascii_length = Utf16AsciiPrefixLength(chars, static_cast<size_t>(end - chars));
+    result += ascii_length;
+    chars += ascii_length;
+    if (chars == end) {
+      break;
+    }
     const uint16_t ch = *chars++;
     if (LIKELY(ch != 0 && ch < 0x80)) {
       result++;
@@ -380,6 +380,49 @@ TEST_F(UtfTest, ExhaustiveBidirectionalCodePointCheck) {
   }
 }
 
+TEST_F(UtfTest, LongAsciiRuns) {
+  // Exercise the vectorized ASCII paths with a non-ASCII character at every position
+  // of strings spanning several 8- and 16-character blocks.
+  static const uint16_t kSpecialChars[] = { 0x0000, 0x0080, 0x07ff, 0x0800, 0xd800, 0xffff };
+  for (size_t length = 0; length <= 40; ++length) {
+    for (size_t pos = 0; pos <= length; ++pos) {
+      for (uint16_t special : kSpecialChars) {
+        std::vector<uint16_t> buf(length);
+        for (size_t i = 0; i != length; ++i) {
+          buf[i] = static_cast<uint16_t>('a' + i % 26);
+        }
+        if (pos != length) {
+          buf[pos] = special;
+        }
+        if (pos + 17 < length) {
+          buf[pos + 17] = 0x7f;  // Largest one-byte encoding.
+          buf[length - 1] = 0x0001;  // Smallest one-byte encoding.
+        }
+
+        size_t byte_count = CountUtf8Bytes(buf.data(), length);
+        ASSERT_EQ(CountUtf8Bytes_reference(buf.data(), length), byte_count);
+        std::vector<char> bytes(byte_count + 1u, '\0');
+        std::vector<char> bytes_reference(byte_count + 1u, '\0');
+        ConvertUtf16ToModifiedUtf8(bytes.data(), byte_count, buf.data(), length);
+        ConvertUtf16ToModifiedUtf8_reference(bytes_reference.data(), buf.data(), length);
+        ASSERT_EQ(bytes_reference, bytes);
+
+        ASSERT_EQ(length, CountModifiedUtf8Chars(bytes.data()));
+        ASSERT_EQ(length, CountModifiedUtf8Chars(bytes.data(), byte_count));
+        std::vector<uint16_t> out(length);
+        ConvertModifiedUtf8ToUtf16(out.data(), length, bytes.data(), byte_count);
+        ASSERT_EQ(buf, out);
+
+        uint32_t hash_reference = 0;
+        for (size_t i = 0; i != byte_count; ++i) {
+          hash_reference = hash_reference * 31 + static_cast<uint8_t>(bytes[i]);
+        }
+        ASSERT_EQ(hash_reference, ComputeModifiedUtf8Hash(bytes.data()));
+      }
+    }
+  }
+}
+
 TEST_F(UtfTest, NonAscii) {
   const char kNonAsciiCharacter = '\x80';
   const char input[] = { kNonAsciiCharacter, '\0' };
@@ -16,8 +16,11 @@
 
 #include "xz_utils.h"
 
-#include <vector>
+#include <algorithm>
+#include <atomic>
 #include <mutex>
+#include <thread>
+#include <vector>
 
 #include "base/array_ref.h"
 #include "base/bit_utils.h"
@@ -34,6 +37,17 @@ namespace art {
 
 constexpr size_t kChunkSize = 16 * KB;
 
+// Sizes of the fixed parts of an XZ stream, see https://tukaani.org/xz/xz-file-format.txt.
+constexpr size_t kStreamHeaderSize = 12;
+constexpr size_t kStreamFooterSize = 12;
+constexpr size_t kStreamFlagsOffset = 6;  // In the header.
+
+// A record of the index at the end of an XZ stream, describing one block.
+struct XzBlockRecord {
+  uint32_t unpadded_size;
+  uint32_t uncompressed_size;
+};
+
 static void XzInitCrc() {
   static std::once_flag crc_initialized;
   std::call_once(crc_initialized, []() {
@@ -42,7 +56,7 @@ static void XzInitCrc() {
   });
 }
 
-void XzCompress(ArrayRef<const uint8_t> src, std::vector<uint8_t>* dst, int level) {
+static void XzCompressStream(ArrayRef<const uint8_t> src, std::vector<uint8_t>* dst, int level) {
   // Configure the compression library.
   XzInitCrc();
   CLzma2EncProps lzma2Props;
@@ -86,6 +100,109 @@ void XzCompress(ArrayRef<const uint8_t> src, std::vector<uint8_t>* dst, int leve
   // Compress.
   SRes res = Xz_Encode(&callbacks, &callbacks, &props, &callbacks);
   CHECK_EQ(res, SZ_OK);
+}
+
+static void AppendUint32(std::vector<uint8_t>* dst, uint32_t value) {
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+  dst->insert(dst->end(), bytes, bytes + sizeof(value));
+}
+
+// Reads the index of the XZ stream `stream` into `records` and returns the data of its blocks.
+static ArrayRef<const uint8_t> ReadXzIndex(ArrayRef<const uint8_t> stream,
+                                           /*out*/ std::vector<XzBlockRecord>* records) {
+  CHECK_GE(stream.size(), kStreamHeaderSize + kStreamFooterSize);
+  const uint8_t* footer = stream.data() + stream.size() - kStreamFooterSize;
+  CHECK_EQ(footer[10], 'Y');
+  CHECK_EQ(footer[11], 'Z');
+  uint32_t backward_size;
+  memcpy(&backward_size, footer + 4, sizeof(backward_size));
+  size_t index_size = (static_cast<size_t>(backward_size) + 1u) * 4u;
+  CHECK_LE(kStreamHeaderSize + index_size + kStreamFooterSize, stream.size());
+  const uint8_t* index = footer - index_size;
+  CHECK_EQ(index[0], 0u);  // Index indicator.
+  const uint8_t* ptr = index + 1;
+  uint32_t num_records = DecodeUnsignedLeb128(&ptr);
+  size_t blocks_size = 0;
+  for (uint32_t i = 0; i != num_records; ++i) {
+    XzBlockRecord record;
+    record.unpadded_size = DecodeUnsignedLeb128(&ptr);
+    record.uncompressed_size = DecodeUnsignedLeb128(&ptr);
+    records->push_back(record);
+    blocks_size += RoundUp(record.unpadded_size, 4u);
+  }
+  CHECK_LE(ptr, footer);
+  CHECK_EQ(kStreamHeaderSize + blocks_size, static_cast<size_t>(index - stream.data()));
+  return stream.SubArray(kStreamHeaderSize, blocks_size);
+}
+
+// Appends the index describing `records` and the stream footer to `dst`.
+static void WriteXzIndexAndFooter(const std::vector<XzBlockRecord>& records,
+                                  const uint8_t* stream_flags,
+                                  std::vector<uint8_t>* dst) {
+  std::vector<uint8_t> index;
+  index.push_back(0u);  // Index indicator.
+  EncodeUnsignedLeb128(&index, records.size());
+  for (const XzBlockRecord& record : records) {
+    EncodeUnsignedLeb128(&index, record.unpadded_size);
+    EncodeUnsignedLeb128(&index, record.uncompressed_size);
+  }
+  index.resize(RoundUp(index.size(), 4u), 0u);
+  AppendUint32(&index, CrcCalc(index.data(), index.size()));
+  dst->insert(dst->end(), index.begin(), index.end());
+
+  std::vector<uint8_t> footer;
+  AppendUint32(&footer, 0u);  // CRC32, filled in below.
+  AppendUint32(&footer, index.size() / 4u - 1u);  // Backward size.
+  footer.push_back(stream_flags[0]);
+  footer.push_back(stream_flags[1]);
+  uint32_t crc = CrcCalc(footer.data() + 4, 6);
+  memcpy(footer.data(), &crc, sizeof(crc));
+  footer.push_back('Y');
+  footer.push_back('Z');
+  dst->insert(dst->end(), footer.begin(), footer.end());
+}
+
+void XzCompress(ArrayRef<const uint8_t> src,
+                std::vector<uint8_t>* dst,
+                int level,
+                size_t block_size,
+                size_t num_threads) {
+  size_t num_blocks = (block_size != 0u) ? RoundUp(src.size(), block_size) / block_size : 1u;
+  if (num_blocks <= 1u) {
+    XzCompressStream(src, dst, level);
+  } else {
+    // Compress each block as a separate stream in parallel, then merge the blocks
+    // of all the streams into one stream.
+    std::vector<std::vector<uint8_t>> streams(num_blocks);
+    std::atomic<size_t> next_block(0u);
+    auto compress_blocks = [&]() {
+      for (size_t i; (i = next_block.fetch_add(1u, std::memory_order_relaxed)) < num_blocks; ) {
+        size_t begin = i * block_size;
+        size_t size = std::min(block_size, src.size() - begin);
+        streams[i].reserve(size / 4);
+        XzCompressStream(src.SubArray(begin, size), &streams[i], level);
+      }
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1, end = std::min(num_blocks, num_threads); i < end; ++i) {
+      threads.emplace_back(compress_blocks);
+    }
+    compress_blocks();
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+
+    std::vector<XzBlockRecord> records;
+    const uint8_t* header = streams[0].data();
+    dst->insert(dst->end(), header, header + kStreamHeaderSize);
+    for (const std::vector<uint8_t>& stream : streams) {
+      // All streams were written with the same flags, so share the header of the first one.
+      DCHECK_EQ(memcmp(stream.data(), header, kStreamHeaderSize), 0);
+      ArrayRef<const uint8_t> blocks = ReadXzIndex(ArrayRef<const uint8_t>(stream), &records);
+      dst->insert(dst->end(), blocks.begin(), blocks.end());
+    }
+    WriteXzIndexAndFooter(records, header + kStreamFlagsOffset, dst);
+  }
 
   // Decompress the data back and check that we get the original.
   if (kIsDebugBuild) {
@@ -129,4 +246,41 @@ void XzDecompress(ArrayRef<const uint8_t> src, std::vector<uint8_t>* dst) {
   dst->resize(dst_offset);
 }
 
+size_t XzDecompressRange(ArrayRef<const uint8_t> src,
+                         size_t offset,
+                         size_t size,
+                         std::vector<uint8_t>* dst) {
+  XzInitCrc();
+  std::vector<XzBlockRecord> records;
+  ArrayRef<const uint8_t> blocks = ReadXzIndex(src, &records);
+
+  // Build a stream holding only the blocks which overlap the requested range.
+  std::vector<uint8_t> stream(src.begin(), src.begin() + kStreamHeaderSize);
+  std::vector<XzBlockRecord> selected_records;
+  size_t first_offset = 0u;
+  size_t compressed_offset = 0u;
+  size_t uncompressed_offset = 0u;
+  for (const XzBlockRecord& record : records) {
+    size_t compressed_size = RoundUp(record.unpadded_size, 4u);
+    if (uncompressed_offset < offset + size &&
+        offset < uncompressed_offset + record.uncompressed_size) {
+      if (selected_records.empty()) {
+        first_offset = uncompressed_offset;
+      }
+      const uint8_t* block = blocks.data() + compressed_offset;
+      stream.insert(stream.end(), block, block + compressed_size);
+      selected_records.push_back(record);
+    }
+    compressed_offset += compressed_size;
+    uncompressed_offset += record.uncompressed_size;
+  }
+  dst->clear();
+  if (selected_records.empty()) {
+    return std::min(offset, uncompressed_offset);
+  }
+  WriteXzIndexAndFooter(selected_records, src.data() + kStreamFlagsOffset, &stream);
+  XzDecompress(ArrayRef<const uint8_t>(stream), dst);
+  return first_offset;
+}
+
 }  // namespace art
@@ -23,9 +23,25 @@
 
 namespace art {
 
-void XzCompress(ArrayRef<const uint8_t> src, std::vector<uint8_t>* dst, int level = 1 /* speed */);
+// Compresses `src` as a single XZ stream. If `block_size` is non-zero, the data is split into
+// independent blocks of that size, which can be decompressed individually with
+// XzDecompressRange(). The blocks are compressed on up to `num_threads` threads, including the
+// calling thread.
+void XzCompress(ArrayRef<const uint8_t> src,
+                std::vector<uint8_t>* dst,
+                int level = 1 /* speed */,
+                size_t block_size = 0,
+                size_t num_threads = 1);
 void XzDecompress(ArrayRef<const uint8_t> src, std::vector<uint8_t>* dst);
 
+// Decompresses only the blocks of the stream covering the uncompressed range
+// [offset, offset + size) into `dst`, using the block index of the stream to find them.
+// Returns the uncompressed offset of the first byte stored in `dst`.
+size_t XzDecompressRange(ArrayRef<const uint8_t> src,
+                         size_t offset,
+                         size_t size,
+                         std::vector<uint8_t>* dst);
+
 }  // namespace art
 
 #endif  // ART_LIBELFFILE_ELF_XZ_UTILS_H_
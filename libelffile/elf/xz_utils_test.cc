@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "xz_utils.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "base/array_ref.h"
+#include "base/globals.h"
+#include "base/leb128.h"
+#include "gtest/gtest.h"
+
+namespace art {
+
+// Returns data which compresses reasonably well but does not repeat within a block.
+static std::vector<uint8_t> CreateData(size_t size) {
+  std::vector<uint8_t> data(size);
+  uint32_t state = 1u;
+  for (size_t i = 0; i != size; ++i) {
+    state = state * 1103515245u + 12345u;
+    data[i] = static_cast<uint8_t>((state >> 16) % 16u);
+  }
+  return data;
+}
+
+// Returns the number of blocks recorded in the index of the XZ stream `stream`.
+static uint32_t CountXzBlocks(const std::vector<uint8_t>& stream) {
+  constexpr size_t kStreamFooterSize = 12;
+  const uint8_t* footer = stream.data() + stream.size() - kStreamFooterSize;
+  uint32_t backward_size;
+  memcpy(&backward_size, footer + 4, sizeof(backward_size));
+  const uint8_t* index = footer - (static_cast<size_t>(backward_size) + 1u) * 4u;
+  EXPECT_EQ(0u, index[0]);  // Index indicator.
+  const uint8_t* ptr = index + 1;
+  return DecodeUnsignedLeb128(&ptr);
+}
+
+TEST(XzUtilsTest, SingleStream) {
+  std::vector<uint8_t> data = CreateData(100 * KB);
+  std::vector<uint8_t> compressed;
+  XzCompress(ArrayRef<const uint8_t>(data), &compressed);
+  std::vector<uint8_t> decompressed;
+  XzDecompress(ArrayRef<const uint8_t>(compressed), &decompressed);
+  EXPECT_EQ(data, decompressed);
+}
+
+TEST(XzUtilsTest, MultipleBlocks) {
+  constexpr size_t kBlockSize = 64 * KB;
+  // The last block is partial.
+  std::vector<uint8_t> data = CreateData(5 * kBlockSize + 123u);
+  std::vector<uint8_t> compressed;
+  XzCompress(ArrayRef<const uint8_t>(data),
+             &compressed,
+             /* level= */ 1,
+             kBlockSize,
+             /* num_threads= */ 4u);
+  // Each of the 6 parts is compressed as at least one block.
+  EXPECT_LE(6u, CountXzBlocks(compressed));
+  std::vector<uint8_t> decompressed;
+  XzDecompress(ArrayRef<const uint8_t>(compressed), &decompressed);
+  EXPECT_EQ(data, decompressed);
+
+  // The output does not depend on the number of threads.
+  for (size_t num_threads : { 1u, 2u, 16u }) {
+    std::vector<uint8_t> other_compressed;
+    XzCompress(ArrayRef<const uint8_t>(data),
+               &other_compressed,
+               /* level= */ 1,
+               kBlockSize,
+               num_threads);
+    EXPECT_EQ(compressed, other_compressed) << num_threads;
+  }
+}
+
+TEST(XzUtilsTest, DecompressRange) {
+  constexpr size_t kBlockSize = 16 * KB;
+  std::vector<uint8_t> data = CreateData(10 * kBlockSize + 123u);
+  std::vector<uint8_t> compressed;
+  XzCompress(ArrayRef<const uint8_t>(data),
+             &compressed,
+             /* level= */ 1,
+             kBlockSize,
+             /* num_threads= */ 4u);
+  std::vector<uint8_t> full;
+  XzDecompress(ArrayRef<const uint8_t>(compressed), &full);
+  ASSERT_EQ(data, full);
+
+  // A range in the middle of the data, starting and ending within a block.
+  const size_t offset = 3 * kBlockSize + 100u;
+  const size_t size = 2 * kBlockSize + 200u;
+  std::vector<uint8_t> part;
+  size_t part_offset = XzDecompressRange(ArrayRef<const uint8_t>(compressed), offset, size, &part);
+  ASSERT_LE(part_offset, offset);
+  ASSERT_GE(part_offset + part.size(), offset + size);
+  // Only the blocks covering the range are decompressed.
+  EXPECT_LT(part.size(), full.size() / 2u);
+  EXPECT_TRUE(std::equal(part.begin(), part.end(), full.begin() + part_offset));
+
+  // A range past the end of the data is empty.
+  part_offset = XzDecompressRange(ArrayRef<const uint8_t>(compressed), full.size(), 1u, &part);
+  EXPECT_EQ(full.size(), part_offset);
+  EXPECT_TRUE(part.empty());
+}
+
+TEST(XzUtilsTest, BlockSizeLargerThanData) {
+  std::vector<uint8_t> data = CreateData(10 * KB);
+  std::vector<uint8_t> compressed;
+  XzCompress(ArrayRef<const uint8_t>(data),
+             &compressed,
+             /* level= */ 1,
+             /* block_size= */ 64 * KB,
+             /* num_threads= */ 4u);
+  std::vector<uint8_t> decompressed;
+  XzDecompress(ArrayRef<const uint8_t>(compressed), &decompressed);
+  EXPECT_EQ(data, decompressed);
+  std::vector<uint8_t> single_stream;
+  XzCompress(ArrayRef<const uint8_t>(data), &single_stream);
+  EXPECT_EQ(single_stream, compressed);
+}
+
+}  // namespace art
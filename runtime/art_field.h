@@ -52,6 +52,10 @@ class ArtField final {
     return declaring_class_.AddressWithoutBarrier();
   }
 
+  static constexpr MemberOffset DeclaringClassOffset() {
+    return MemberOffset(OFFSETOF_MEMBER(ArtField, declaring_class_));
+  }
+
   uint32_t GetAccessFlags() REQUIRES_SHARED(Locks::mutator_lock_) {
     if (kIsDebugBuild) {
       GetAccessFlagsDCheck();
@@ -77,10 +77,15 @@ void MemMapArena::Release() {
   }
 }
 
-MemMapArenaPool::MemMapArenaPool(bool low_4gb, const char* name)
+MemMapArenaPool::MemMapArenaPool(bool low_4gb,
+                                 const char* name,
+                                 size_t max_retained_bytes)
     : low_4gb_(low_4gb),
       name_(name),
-      free_arenas_(nullptr) {
+      max_retained_bytes_(max_retained_bytes),
+      free_arenas_(nullptr),
+      bytes_in_use_(0u),
+      peak_bytes_in_use_(0u) {
   MemMap::Init();
 }
 
@@ -108,21 +113,53 @@ Arena* MemMapArenaPool::AllocArena(size_t size) {
     if (free_arenas_ != nullptr && LIKELY(free_arenas_->Size() >= size)) {
       ret = free_arenas_;
       free_arenas_ = free_arenas_->next_;
+      RecordArenaInUse(ret);
     }
   }
   if (ret == nullptr) {
     ret = new MemMapArena(size, low_4gb_, name_);
+    std::lock_guard<std::mutex> lock(lock_);
+    RecordArenaInUse(ret);
   }
   ret->Reset();
   return ret;
 }
 
+void MemMapArenaPool::RecordArenaInUse(Arena* arena) {
+  bytes_in_use_ += arena->Size();
+  peak_bytes_in_use_ = std::max(peak_bytes_in_use_, bytes_in_use_);
+}
+
 void MemMapArenaPool::TrimMaps() {
   ScopedTrace trace(__PRETTY_FUNCTION__);
   std::lock_guard<std::mutex> lock(lock_);
+  const size_t retained_limit = std::min(peak_bytes_in_use_, max_retained_bytes_);
+  size_t retained_bytes = 0u;
+  for (Arena* arena = free_arenas_; arena != nullptr; arena = arena->next_) {
+    if (retained_bytes + arena->Size() <= retained_limit) {
+      retained_bytes += arena->Size();
+    } else {
+      arena->Release();
+    }
+  }
+  peak_bytes_in_use_ = bytes_in_use_;
+}
+
+size_t MemMapArenaPool::GetRetainedBytes() const {
+  size_t total = 0;
+  std::lock_guard<std::mutex> lock(lock_);
   for (Arena* arena = free_arenas_; arena != nullptr; arena = arena->next_) {
-    arena->Release();
+    // Release() clears the count of bytes allocated along with the memory.
+    if (arena->GetBytesAllocated() != 0u) {
+      total += arena->Size();
+    }
   }
+  return total;
+}
+
+size_t MemMapArenaPool::GetPeakBytesInUse() const {
+  std::lock_guard<std::mutex> lock(lock_);
+  return peak_bytes_in_use_;
 }
 
 size_t MemMapArenaPool::GetBytesAllocated() const {
@@ -141,6 +178,16 @@ void MemMapArenaPool::FreeArenaChain(Arena* first) {
     }
   }
 
+  size_t freed_bytes = 0u;
+  for (Arena* arena = first; arena != nullptr; arena = arena->next_) {
+    freed_bytes += arena->Size();
+  }
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    DCHECK_GE(bytes_in_use_, freed_bytes);
+    bytes_in_use_ -= freed_bytes;
+  }
+
   if (arena_allocator::kArenaAllocatorPreciseTracking) {
     // Do not reuse arenas when tracking.
     while (first != nullptr) {
@@ -23,7 +23,11 @@ namespace art {
 
 class MemMapArenaPool final : public ArenaPool {
  public:
-  explicit MemMapArenaPool(bool low_4gb = false, const char* name = "LinearAlloc");
+  // `max_retained_bytes` bounds how much memory of free arenas TrimMaps() keeps mapped for
+  // reuse, see TrimMaps().
+  explicit MemMapArenaPool(bool low_4gb = false,
+                           const char* name = "LinearAlloc",
+                           size_t max_retained_bytes = 0u);
   virtual ~MemMapArenaPool();
   Arena* AllocArena(size_t size) override;
   void FreeArenaChain(Arena* first) override;
@@ -31,12 +35,26 @@ class MemMapArenaPool final : public ArenaPool {
   void ReclaimMemory() override;
   void LockReclaimMemory() override;
   // Trim the maps in arenas by madvising, used by JIT to reduce memory usage.
+  // The most recently freed arenas are kept as they are, up to the most memory that was in use
+  // since the previous trim and at most `max_retained_bytes_`, so that a workload which
+  // repeatedly needs the same amount of memory does not page fault it in again each time.
   void TrimMaps() override;
+  // Size of the free arenas whose memory is still mapped, as left by TrimMaps().
+  size_t GetRetainedBytes() const;
+  // Most memory that was in use in arenas at the same time since the last TrimMaps().
+  size_t GetPeakBytesInUse() const;
 
  private:
+  // Requires `lock_`.
+  void RecordArenaInUse(Arena* arena);
+
   const bool low_4gb_;
   const char* name_;
+  const size_t max_retained_bytes_;
   Arena* free_arenas_;
+  // Size of the arenas handed out and not freed yet, and its maximum since the last trim.
+  size_t bytes_in_use_;
+  size_t peak_bytes_in_use_;
   // Use a std::mutex here as Arenas are second-from-the-bottom when using MemMaps, and MemMap
   // itself uses std::mutex scoped to within an allocate/free only.
   mutable std::mutex lock_;
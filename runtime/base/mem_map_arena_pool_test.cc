@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "base/mem_map_arena_pool.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "base/arena_allocator-inl.h"
+#include "gtest/gtest.h"
+
+namespace art {
+
+class MemMapArenaPoolTest : public testing::Test {
+ protected:
+  // Allocates and touches `bytes` from arenas of `pool`, then frees them all.
+  void UseArenas(MemMapArenaPool* pool, size_t bytes) {
+    static constexpr size_t kAllocSize = 32 * KB;
+    ArenaAllocator allocator(pool);
+    for (size_t allocated = 0u; allocated < bytes; allocated += kAllocSize) {
+      memset(allocator.Alloc(kAllocSize), 0xff, kAllocSize);
+    }
+  }
+};
+
+TEST_F(MemMapArenaPoolTest, TrimMapsRetainsUpToPeak) {
+  if (arena_allocator::kArenaAllocatorPreciseTracking) {
+    // Arenas are deleted rather than reused when tracking allocations.
+    return;
+  }
+  static constexpr size_t kMaxRetainedBytes = 1 * MB;
+  MemMapArenaPool pool(/* low_4gb= */ false, "MemMapArenaPoolTest", kMaxRetainedBytes);
+
+  // A peak below the limit is kept.
+  UseArenas(&pool, 512 * KB);
+  size_t peak = pool.GetPeakBytesInUse();
+  EXPECT_GE(peak, 512 * KB);
+  pool.TrimMaps();
+  EXPECT_NE(0u, pool.GetRetainedBytes());
+  EXPECT_LE(pool.GetRetainedBytes(), std::min(peak, kMaxRetainedBytes));
+  // Nothing is in use anymore, so the peak starts over.
+  EXPECT_EQ(0u, pool.GetPeakBytesInUse());
+
+  // A peak above the limit is kept up to the limit.
+  UseArenas(&pool, 4 * MB);
+  peak = pool.GetPeakBytesInUse();
+  EXPECT_GT(peak, kMaxRetainedBytes);
+  pool.TrimMaps();
+  EXPECT_NE(0u, pool.GetRetainedBytes());
+  EXPECT_LE(pool.GetRetainedBytes(), std::min(peak, kMaxRetainedBytes));
+  EXPECT_EQ(0u, pool.GetPeakBytesInUse());
+
+  // Nothing was used since the last trim, so everything is released.
+  pool.TrimMaps();
+  EXPECT_EQ(0u, pool.GetRetainedBytes());
+}
+
+TEST_F(MemMapArenaPoolTest, TrimMapsWithoutRetention) {
+  MemMapArenaPool pool(/* low_4gb= */ false, "MemMapArenaPoolTest");
+  UseArenas(&pool, 512 * KB);
+  pool.TrimMaps();
+  EXPECT_EQ(0u, pool.GetRetainedBytes());
+}
+
+TEST_F(MemMapArenaPoolTest, RetainedArenasAreReused) {
+  if (arena_allocator::kArenaAllocatorPreciseTracking) {
+    // Arenas are deleted rather than reused when tracking allocations.
+    return;
+  }
+  MemMapArenaPool pool(/* low_4gb= */ false, "MemMapArenaPoolTest", 1 * MB);
+  uint8_t* first;
+  {
+    ArenaAllocator allocator(&pool);
+    first = allocator.AllocArray<uint8_t>(KB);
+    memset(first, 0xff, KB);
+  }
+  pool.TrimMaps();
+  EXPECT_NE(0u, pool.GetRetainedBytes());
+  {
+    // The retained arena is handed out again, cleared.
+    ArenaAllocator allocator(&pool);
+    uint8_t* second = allocator.AllocArray<uint8_t>(KB);
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(0u, second[0]);
+    EXPECT_EQ(0u, second[KB - 1u]);
+    EXPECT_EQ(0u, pool.GetRetainedBytes());
+  }
+}
+
+}  // namespace art
@@ -4005,6 +4005,11 @@ ObjPtr<mirror::DexCache> ClassLinker::RegisterDexFile(const DexFile& dex_file,
     // Since we added a strong root to the class table, do the write barrier as required for
     // remembered sets and generational GCs.
     WriteBarrier::ForEveryFieldWrite(h_class_loader.Get());
+    if (dex_file.GetOatDexFile() == nullptr) {
+      // The class loader is now using a dex file without verification results on disk.
+      Runtime::Current()->GetOatFileManager().MaybeRunBackgroundVerification(
+          dex_file, h_class_loader.Get());
+    }
   }
   return h_dex_cache.Get();
 }
@@ -582,6 +582,79 @@ class QuickArgumentVisitor {
     }
   }
 
+  // Whether each argument is in a single 64-bit GPR or FPR spill slot, or else in its stack
+  // slots, as on arm64 and x86-64. The arguments can then be located without VisitArguments().
+  static constexpr bool kSimpleArgumentLayout =
+      !kQuickSoftFloatAbi &&
+      !kQuickDoubleRegAlignedFloatBackFilled &&
+      !kQuickSkipOddFpRegisters &&
+      !kAlignPairRegister &&
+      !kGprFprLockstep &&
+      GetBytesPerGprSpillLocation(kRuntimeISA) == 8u &&
+      GetBytesPerFprSpillLocation(kRuntimeISA) == 8u;
+
+  // Copies the arguments to the vregs of `sf` starting at `first_arg_reg`, like VisitArguments()
+  // with a BuildQuickShadowFrameVisitor but without a virtual call per argument. This is on the
+  // path of every call from compiled code to the interpreter. Requires kSimpleArgumentLayout.
+  void CopyArgumentsToShadowFrame(ShadowFrame* sf, size_t first_arg_reg) const
+      REQUIRES_SHARED(Locks::mutator_lock_) {
+    DCHECK(kSimpleArgumentLayout);
+    uint32_t gpr_index = 0u;
+    uint32_t fpr_index = 0u;
+    uint32_t stack_index = 0u;
+    size_t reg = first_arg_reg;
+    auto gpr_or_stack_address = [&]() {
+      return (gpr_index < kNumQuickGprArgs)
+          ? gpr_args_ + GprIndexToGprOffset(gpr_index++)
+          : stack_args_ + stack_index * kBytesStackArgLocation;
+    };
+    auto fpr_or_stack_address = [&]() {
+      return (fpr_index < kNumQuickFprArgs)
+          ? fpr_args_ + (fpr_index++) * GetBytesPerFprSpillLocation(kRuntimeISA)
+          : stack_args_ + stack_index * kBytesStackArgLocation;
+    };
+    if (!is_static_) {
+      uint8_t* address = gpr_or_stack_address();
+      sf->SetVRegReference(
+          reg, reinterpret_cast<StackReference<mirror::Object>*>(address)->AsMirrorPtr());
+      ++reg;
+      ++stack_index;
+    }
+    for (uint32_t shorty_index = 1; shorty_index < shorty_len_; ++shorty_index) {
+      switch (shorty_[shorty_index]) {
+        case 'J':
+          sf->SetVRegLong(reg, *reinterpret_cast<jlong*>(gpr_or_stack_address()));
+          reg += 2u;
+          stack_index += 2u;
+          break;
+        case 'D':
+          sf->SetVRegLong(reg, *reinterpret_cast<jlong*>(fpr_or_stack_address()));
+          reg += 2u;
+          stack_index += 2u;
+          break;
+        case 'F':
+          sf->SetVReg(reg, *reinterpret_cast<jint*>(fpr_or_stack_address()));
+          ++reg;
+          ++stack_index;
+          break;
+        case 'L': {
+          uint8_t* address = gpr_or_stack_address();
+          sf->SetVRegReference(
+              reg, reinterpret_cast<StackReference<mirror::Object>*>(address)->AsMirrorPtr());
+          ++reg;
+          ++stack_index;
+          break;
+        }
+        default:
+          DCHECK(strchr("ZBCSI", shorty_[shorty_index]) != nullptr) << shorty_;
+          sf->SetVReg(reg, *reinterpret_cast<jint*>(gpr_or_stack_address()));
+          ++reg;
+          ++stack_index;
+          break;
+      }
+    }
+  }
+
  protected:
   const bool is_static_;
   const char* const shorty_;
@@ -768,7 +841,11 @@ extern "C" uint64_t artQuickToInterpreterBridge(ArtMethod* method, Thread* self,
     size_t first_arg_reg = accessor.RegistersSize() - accessor.InsSize();
     BuildQuickShadowFrameVisitor shadow_frame_builder(sp, method->IsStatic(), shorty, shorty_len,
                                                       shadow_frame, first_arg_reg);
-    shadow_frame_builder.VisitArguments();
+    if (QuickArgumentVisitor::kSimpleArgumentLayout) {
+      shadow_frame_builder.CopyArgumentsToShadowFrame(shadow_frame, first_arg_reg);
+    } else {
+      shadow_frame_builder.VisitArguments();
+    }
     const bool needs_initialization =
         method->IsStatic() && !method->GetDeclaringClass()->IsInitialized();
     // Push a transition back into managed code onto the linked list in thread.
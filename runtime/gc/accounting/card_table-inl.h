@@ -19,6 +19,12 @@
 
 #include "card_table.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 #include <android-base/logging.h>
 
 #include "base/atomic.h"
@@ -51,6 +57,33 @@ static inline bool byte_cas(uint8_t old_value, uint8_t new_value, uint8_t* addre
 #endif
 }
 
+// Compares a group of kCardGroupSize cards against `minimum_age` at once with SSE2 on x86 and
+// NEON on arm64. Returns a mask with kCardGroupBitsPerCard bits set for each card whose value is
+// at least `minimum_age`, lowest address in the lowest bits. Other architectures only use the
+// word at a time loops below.
+#if defined(__SSE2__) || defined(__aarch64__)
+static constexpr size_t kCardGroupSize = 16u;
+#if defined(__SSE2__)
+static constexpr size_t kCardGroupBitsPerCard = 1u;
+
+ALWAYS_INLINE inline uint64_t MatchCardGroup(const uint8_t* card, uint8_t minimum_age) {
+  __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(card));
+  // There is no unsigned byte comparison; `group` >= `minimum_age` iff max(group, age) == group.
+  __m128i max = _mm_max_epu8(group, _mm_set1_epi8(static_cast<char>(minimum_age)));
+  return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(max, group)));
+}
+#else
+static constexpr size_t kCardGroupBitsPerCard = 4u;
+
+ALWAYS_INLINE inline uint64_t MatchCardGroup(const uint8_t* card, uint8_t minimum_age) {
+  uint8x16_t matches = vcgeq_u8(vld1q_u8(card), vdupq_n_u8(minimum_age));
+  // Narrow each 0x00/0xff byte to a nibble.
+  uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(matches), 4);
+  return vget_lane_u64(vreinterpret_u64_u8(nibbles), 0);
+}
+#endif
+#endif  // defined(__SSE2__) || defined(__aarch64__)
+
 template <bool kClearCard, typename Visitor>
 inline size_t CardTable::Scan(ContinuousSpaceBitmap* bitmap,
                               uint8_t* const scan_begin,
@@ -67,6 +100,23 @@ inline size_t CardTable::Scan(ContinuousSpaceBitmap* bitmap,
   CheckCardValid(card_end);
   size_t cards_scanned = 0;
 
+#if defined(__SSE2__) || defined(__aarch64__)
+  // Skip groups without cards of at least `minimum_age` at vector width and visit the others in
+  // address order, as the loops below do. These handle the remaining cards.
+  for (; card_end - card_cur >= static_cast<ptrdiff_t>(kCardGroupSize);
+       card_cur += kCardGroupSize) {
+    uint64_t matches = MatchCardGroup(card_cur, minimum_age);
+    while (matches != 0u) {
+      size_t bit = CTZ(matches);
+      uintptr_t start = reinterpret_cast<uintptr_t>(
+          AddrFromCard(card_cur + bit / kCardGroupBitsPerCard));
+      bitmap->VisitMarkedRange(start, start + kCardSize, visitor);
+      ++cards_scanned;
+      matches &= ~(((UINT64_C(1) << kCardGroupBitsPerCard) - 1u) << bit);
+    }
+  }
+#endif
+
   // Handle any unaligned cards at the start.
   while (!IsAligned<sizeof(intptr_t)>(card_cur) && card_cur < card_end) {
     if (*card_cur >= minimum_age) {
@@ -179,6 +229,17 @@ inline void CardTable::ModifyCardsAtomic(uint8_t* scan_begin,
 
   // TODO: Parallelize.
   while (word_cur < word_end) {
+#if defined(__SSE2__) || defined(__aarch64__)
+    // Skip groups of clean cards at vector width.
+    constexpr size_t kWordsPerCardGroup = kCardGroupSize / sizeof(uintptr_t);
+    while (word_end - word_cur >= static_cast<ptrdiff_t>(kWordsPerCardGroup) &&
+           MatchCardGroup(reinterpret_cast<uint8_t*>(word_cur), kCardClean + 1) == 0u) {
+      word_cur += kWordsPerCardGroup;
+    }
+    if (word_cur == word_end) {
+      break;
+    }
+#endif
     while (true) {
       expected_word = *word_cur;
       static_assert(kCardClean == 0);
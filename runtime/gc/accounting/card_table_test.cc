@@ -16,7 +16,9 @@
 
 #include "card_table-inl.h"
 
+#include <algorithm>
 #include <string>
+#include <vector>
 
 #include "base/atomic.h"
 #include "base/utils.h"
@@ -25,6 +27,7 @@
 #include "mirror/class-inl.h"
 #include "mirror/string-inl.h"  // Strings are easiest to allocate
 #include "scoped_thread_state_change-inl.h"
+#include "space_bitmap-inl.h"
 #include "thread_pool.h"
 
 namespace art {
@@ -72,6 +75,18 @@ class CardTableTest : public CommonRuntimeTest {
       *card = PseudoRandomCard(addr);
     }
   }
+  // Makes a few cards dirty or aged, with runs of clean cards longer than a vector in between.
+  void FillSparse() {
+    for (const uint8_t* addr = HeapBegin(); addr != HeapLimit(); addr += CardTable::kCardSize) {
+      size_t index = (addr - HeapBegin()) / CardTable::kCardSize;
+      uint8_t* card = card_table_->CardFromAddr(addr);
+      if (index % 37 == 0 || index % 37 == 1) {
+        *card = CardTable::kCardDirty;
+      } else if (index % 53 == 5) {
+        *card = CardTable::kCardAged;
+      }
+    }
+  }
 
  private:
   uint8_t* const heap_begin_;
@@ -145,7 +160,77 @@ TEST_F(CardTableTest, TestModifyCardsAtomic) {
   }
 }
 
-// TODO: Add test for CardTable::Scan.
+TEST_F(CardTableTest, TestModifyCardsAtomicSparse) {
+  CommonSetup();
+  FillSparse();
+  std::vector<uint8_t> cards(card_table_->CardFromAddr(HeapBegin()),
+                             card_table_->CardFromAddr(HeapLimit()));
+  std::vector<uint8_t*> modified_cards;
+  card_table_->ModifyCardsAtomic(
+      HeapBegin() + CardTable::kCardSize,
+      HeapLimit() - CardTable::kCardSize,
+      AgeCardVisitor(),
+      [&](uint8_t* card, uint8_t expected_value, uint8_t new_value) {
+        EXPECT_EQ(AgeCardVisitor()(expected_value), new_value);
+        modified_cards.push_back(card);
+      });
+  std::vector<uint8_t*> expected_cards;
+  for (size_t i = 1; i + 1 < cards.size(); ++i) {
+    uint8_t* card = card_table_->CardFromAddr(HeapBegin()) + i;
+    if (cards[i] != CardTable::kCardClean) {
+      EXPECT_EQ(AgeCardVisitor()(cards[i]), *card);
+      expected_cards.push_back(card);
+    } else {
+      EXPECT_EQ(CardTable::kCardClean, *card);
+    }
+  }
+  std::sort(modified_cards.begin(), modified_cards.end());
+  EXPECT_EQ(expected_cards, modified_cards);
+  // Cards outside of the range are not modified.
+  EXPECT_EQ(cards.front(), *card_table_->CardFromAddr(HeapBegin()));
+  EXPECT_EQ(cards.back(), *card_table_->CardFromAddr(HeapLimit() - CardTable::kCardSize));
+}
+
+TEST_F(CardTableTest, TestScan) {
+  CommonSetup();
+  FillSparse();
+  std::unique_ptr<ContinuousSpaceBitmap> bitmap(
+      ContinuousSpaceBitmap::Create("card table test bitmap",
+                                    HeapBegin(),
+                                    HeapLimit() - HeapBegin()));
+  ASSERT_TRUE(bitmap != nullptr);
+  // Mark the first object on every card.
+  for (uint8_t* addr = HeapBegin(); addr != HeapLimit(); addr += CardTable::kCardSize) {
+    bitmap->Set(reinterpret_cast<mirror::Object*>(addr));
+  }
+  ScopedObjectAccess soa(Thread::Current());
+  WriterMutexLock mu(soa.Self(), *Locks::heap_bitmap_lock_);
+  for (uint8_t minimum_age : {CardTable::kCardDirty, CardTable::kCardAged}) {
+    // Scan ranges starting and ending at every card of a vector and of a word.
+    for (size_t start_card = 0; start_card != 17; ++start_card) {
+      for (size_t end_card = 0; end_card != 17; ++end_card) {
+        uint8_t* start = HeapBegin() + start_card * CardTable::kCardSize;
+        uint8_t* end = HeapLimit() - end_card * CardTable::kCardSize;
+        std::vector<uintptr_t> expected;
+        for (uint8_t* addr = start; addr != end; addr += CardTable::kCardSize) {
+          if (*card_table_->CardFromAddr(addr) >= minimum_age) {
+            expected.push_back(reinterpret_cast<uintptr_t>(addr));
+          }
+        }
+        std::vector<uintptr_t> visited;
+        size_t cards_scanned = card_table_->Scan</*kClearCard=*/ false>(
+            bitmap.get(),
+            start,
+            end,
+            [&](mirror::Object* obj) { visited.push_back(reinterpret_cast<uintptr_t>(obj)); },
+            minimum_age);
+        EXPECT_EQ(expected.size(), cards_scanned);
+        EXPECT_EQ(expected, visited);
+      }
+    }
+  }
+}
+
 }  // namespace accounting
 }  // namespace gc
 }  // namespace art
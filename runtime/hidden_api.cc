@@ -112,6 +112,54 @@ void InitializeDexFileDomain(const DexFile& dex_file, ObjPtr<mirror::ClassLoader
   }
 }
 
+ApiListCache::ApiListCache()
+    : lock_("hidden api list cache lock", kGenericBottomLock),
+      exemptions_generation_(1u) {}
+
+bool ApiListCache::LookupDexFlags(const void* member, /*out*/ uint32_t* dex_flags) {
+  ReaderMutexLock mu(Thread::Current(), lock_);
+  auto it = entries_.find(member);
+  if (it == entries_.end()) {
+    return false;
+  }
+  *dex_flags = it->second.dex_flags;
+  return true;
+}
+
+void ApiListCache::RecordDexFlags(const void* member, uint32_t dex_flags) {
+  WriterMutexLock mu(Thread::Current(), lock_);
+  entries_.emplace(member, Entry { dex_flags, /* not_exempted_generation= */ 0u });
+}
+
+uint32_t ApiListCache::GetExemptionsGeneration() {
+  ReaderMutexLock mu(Thread::Current(), lock_);
+  return exemptions_generation_;
+}
+
+bool ApiListCache::IsKnownNotExempted(const void* member, /*out*/ uint32_t* generation) {
+  ReaderMutexLock mu(Thread::Current(), lock_);
+  *generation = exemptions_generation_;
+  auto it = entries_.find(member);
+  return it != entries_.end() && it->second.not_exempted_generation == exemptions_generation_;
+}
+
+void ApiListCache::RecordNotExempted(const void* member, uint32_t generation) {
+  WriterMutexLock mu(Thread::Current(), lock_);
+  if (generation != exemptions_generation_) {
+    return;  // The member was checked against exemptions which are no longer current.
+  }
+  auto it = entries_.find(member);
+  // Only members with recorded dex flags can be cached.
+  if (it != entries_.end()) {
+    it->second.not_exempted_generation = generation;
+  }
+}
+
+void ApiListCache::ResetExemptionChecks() {
+  WriterMutexLock mu(Thread::Current(), lock_);
+  ++exemptions_generation_;
+}
+
 namespace detail {
 
 // Do not change the values of items in this enum, as they are written to the
@@ -406,6 +454,23 @@ uint32_t GetDexFlags(T* member) REQUIRES_SHARED(Locks::mutator_lock_) {
   return flags.GetDexFlags();
 }
 
+template<typename T>
+uint32_t GetCachedDexFlags(T* member) {
+  // Boot class path classes are never unloaded, so the address of `member`
+  // cannot be reused by another member while it is in the cache.
+  if (!member->GetDeclaringClass()->GetClassLoader().IsNull()) {
+    return GetDexFlags(member);
+  }
+
+  ApiListCache* cache = Runtime::Current()->GetHiddenApiCache();
+  uint32_t dex_flags;
+  if (!cache->LookupDexFlags(member, &dex_flags)) {
+    dex_flags = GetDexFlags(member);
+    cache->RecordDexFlags(member, dex_flags);
+  }
+  return dex_flags;
+}
+
 template<typename T>
 bool HandleCorePlatformApiViolation(T* member,
                                     const AccessContext& caller_context,
@@ -447,12 +512,21 @@ bool ShouldDenyAccessToMemberImpl(T* member, ApiList api_list, AccessMethod acce
   MemberSignature member_signature(member);
 
   // Check for an exemption first. Exempted APIs are treated as white list.
-  if (member_signature.IsExempted(runtime->GetHiddenApiExemptions())) {
-    // Avoid re-examining the exemption list next time.
-    // Note this results in no warning for the member, which seems like what one would expect.
-    // Exemptions effectively adds new members to the whitelist.
-    MaybeUpdateAccessFlags(runtime, member, kAccPublicApi);
-    return false;
+  // Matching the exemption prefixes is expensive, so skip it for members which
+  // have already been checked against the current exemptions.
+  // The generation is read before the exemptions, which are replaced before the generation
+  // is bumped, so a result is never recorded for exemptions newer than its generation.
+  ApiListCache* cache = runtime->GetHiddenApiCache();
+  uint32_t exemptions_generation;
+  if (!cache->IsKnownNotExempted(member, &exemptions_generation)) {
+    if (member_signature.IsExempted(runtime->GetHiddenApiExemptions())) {
+      // Avoid re-examining the exemption list next time.
+      // Note this results in no warning for the member, which seems like what one would expect.
+      // Exemptions effectively adds new members to the whitelist.
+      MaybeUpdateAccessFlags(runtime, member, kAccPublicApi);
+      return false;
+    }
+    cache->RecordNotExempted(member, exemptions_generation);
   }
 
   if (access_method != AccessMethod::kNone) {
@@ -491,6 +565,8 @@ bool ShouldDenyAccessToMemberImpl(T* member, ApiList api_list, AccessMethod acce
 // Need to instantiate these.
 template uint32_t GetDexFlags<ArtField>(ArtField* member);
 template uint32_t GetDexFlags<ArtMethod>(ArtMethod* member);
+template uint32_t GetCachedDexFlags<ArtField>(ArtField* member);
+template uint32_t GetCachedDexFlags<ArtMethod>(ArtMethod* member);
 template bool HandleCorePlatformApiViolation(ArtField* member,
                                              const AccessContext& caller_context,
                                              AccessMethod access_method,
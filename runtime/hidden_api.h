@@ -17,10 +17,13 @@
 #ifndef ART_RUNTIME_HIDDEN_API_H_
 #define ART_RUNTIME_HIDDEN_API_H_
 
+#include <unordered_map>
+
 #include "art_field.h"
 #include "art_method.h"
 #include "base/hiddenapi_flags.h"
 #include "base/locks.h"
+#include "base/mutex.h"
 #include "intrinsics_enum.h"
 #include "mirror/class-inl.h"
 #include "reflection.h"
@@ -155,6 +158,56 @@ class ScopedHiddenApiEnforcementPolicySetting {
   DISALLOW_COPY_AND_ASSIGN(ScopedHiddenApiEnforcementPolicySetting);
 };
 
+// Side table of hidden API flags of class members, keyed by the ArtField/ArtMethod.
+// Decoding the flags from the dex file is linear in the number of members of the class,
+// so the result is recorded on the first access check of a member and reused for the
+// subsequent ones. It also remembers which members did not match any of the runtime's
+// hidden API exemptions; these results are dropped when the exemptions change.
+// Only members of classes which cannot be unloaded may be recorded, as the table would
+// otherwise keep stale entries for addresses reused by other members.
+// Access decisions themselves are not cached: they depend on the enforcement policy and
+// target SDK version and the slow path must still log and notify listeners.
+class ApiListCache {
+ public:
+  ApiListCache();
+
+  // Returns true and sets `dex_flags` if the flags of `member` have been recorded.
+  bool LookupDexFlags(const void* member, /*out*/ uint32_t* dex_flags) REQUIRES(!lock_);
+  void RecordDexFlags(const void* member, uint32_t dex_flags) REQUIRES(!lock_);
+
+  // Returns the current generation of the exemptions.
+  uint32_t GetExemptionsGeneration() REQUIRES(!lock_);
+
+  // Returns true if `member` was found not to match the current exemptions. Also sets
+  // `generation` to the current generation of the exemptions, read together with the entry of
+  // `member`. Callers must read the exemptions they check a member against after this call and
+  // pass `generation` to RecordNotExempted(), so that a result computed with exemptions which
+  // changed in the meantime is never used.
+  bool IsKnownNotExempted(const void* member, /*out*/ uint32_t* generation) REQUIRES(!lock_);
+  // Records that `member` does not match the exemptions of `generation`. Does nothing if the
+  // exemptions have changed since.
+  void RecordNotExempted(const void* member, uint32_t generation) REQUIRES(!lock_);
+
+  // Forget all exemption checks. Must be called when the exemptions change.
+  void ResetExemptionChecks() REQUIRES(!lock_);
+
+ private:
+  struct Entry {
+    uint32_t dex_flags;
+    // Value of `exemptions_generation_` when the member was found not to be exempted,
+    // or zero if it was not checked.
+    uint32_t not_exempted_generation;
+  };
+
+  // Lookups only take the lock shared, so that concurrent access checks do not block each
+  // other. Entries are only written the first time a member is checked.
+  ReaderWriterMutex lock_;
+  uint32_t exemptions_generation_ GUARDED_BY(lock_);
+  std::unordered_map<const void*, Entry> entries_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(ApiListCache);
+};
+
 // Implementation details. DO NOT ACCESS DIRECTLY.
 namespace detail {
 
@@ -209,6 +262,11 @@ class MemberSignature {
 template<typename T>
 uint32_t GetDexFlags(T* member) REQUIRES_SHARED(Locks::mutator_lock_);
 
+// Same as GetDexFlags() but uses the runtime's ApiListCache for members
+// of boot class path classes.
+template<typename T>
+uint32_t GetCachedDexFlags(T* member) REQUIRES_SHARED(Locks::mutator_lock_);
+
 // Handler of detected core platform API violations. Returns true if access to
 // `member` should be denied.
 template<typename T>
@@ -426,8 +484,8 @@ inline bool ShouldDenyAccessToMember(T* member,
 
       // Decode hidden API access flags from the dex file.
       // This is an O(N) operation scaling with the number of fields/methods
-      // in the class. Only do this on slow path and only do it once.
-      ApiList api_list(detail::GetDexFlags(member));
+      // in the class. Only do this on slow path and only do it once per member.
+      ApiList api_list(detail::GetCachedDexFlags(member));
       DCHECK(api_list.IsValid());
 
       // Member is hidden and caller is not exempted. Enter slow path.
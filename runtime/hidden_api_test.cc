@@ -329,6 +329,66 @@ TEST_F(HiddenApiTest, CheckFieldTrailingCharsNoMatch) {
   ASSERT_FALSE(MemberSignature(class1_field1_).DoesPrefixMatch(prefix));
 }
 
+TEST_F(HiddenApiTest, CheckApiListCache) {
+  hiddenapi::ApiListCache cache;
+  uint32_t dex_flags = 0u;
+  uint32_t generation = 0u;
+  ASSERT_FALSE(cache.LookupDexFlags(class1_field1_, &dex_flags));
+  ASSERT_FALSE(cache.IsKnownNotExempted(class1_field1_, &generation));
+  ASSERT_EQ(cache.GetExemptionsGeneration(), generation);
+
+  // Exemption checks are only recorded for members with cached flags.
+  cache.RecordNotExempted(class1_field1_, generation);
+  ASSERT_FALSE(cache.IsKnownNotExempted(class1_field1_, &generation));
+
+  cache.RecordDexFlags(class1_field1_, hiddenapi::ApiList::Blacklist().GetDexFlags());
+  ASSERT_TRUE(cache.LookupDexFlags(class1_field1_, &dex_flags));
+  ASSERT_EQ(hiddenapi::ApiList(dex_flags), hiddenapi::ApiList::Blacklist());
+  ASSERT_FALSE(cache.LookupDexFlags(class1_method1_, &dex_flags));
+
+  cache.RecordNotExempted(class1_field1_, generation);
+  uint32_t current_generation = 0u;
+  ASSERT_TRUE(cache.IsKnownNotExempted(class1_field1_, &current_generation));
+  ASSERT_EQ(generation, current_generation);
+
+  // Changing the exemptions drops the exemption checks but keeps the flags.
+  cache.ResetExemptionChecks();
+  uint32_t new_generation = 0u;
+  ASSERT_FALSE(cache.IsKnownNotExempted(class1_field1_, &new_generation));
+  ASSERT_NE(generation, new_generation);
+  ASSERT_EQ(cache.GetExemptionsGeneration(), new_generation);
+  ASSERT_TRUE(cache.LookupDexFlags(class1_field1_, &dex_flags));
+  ASSERT_EQ(hiddenapi::ApiList(dex_flags), hiddenapi::ApiList::Blacklist());
+
+  // A check against the old exemptions which completes after they changed is not recorded.
+  cache.RecordNotExempted(class1_field1_, generation);
+  ASSERT_FALSE(cache.IsKnownNotExempted(class1_field1_, &current_generation));
+  cache.RecordNotExempted(class1_field1_, new_generation);
+  ASSERT_TRUE(cache.IsKnownNotExempted(class1_field1_, &current_generation));
+  ASSERT_EQ(new_generation, current_generation);
+}
+
+TEST_F(HiddenApiTest, CheckExemptionsChangeAfterCachedLookup) {
+  ScopedObjectAccess soa(self_);
+  runtime_->SetHiddenApiEnforcementPolicy(hiddenapi::EnforcementPolicy::kEnabled);
+  runtime_->SetTargetSdkVersion(
+      static_cast<uint32_t>(hiddenapi::ApiList::GreylistMaxO().GetMaxAllowedSdkVersion()) + 1);
+  hiddenapi::ApiListCache* cache = runtime_->GetHiddenApiCache();
+  cache->RecordDexFlags(class1_field1_, hiddenapi::ApiList::Blacklist().GetDexFlags());
+  uint32_t generation;
+
+  // The first lookup records that the member is not exempted, the second one uses that.
+  ASSERT_TRUE(ShouldDenyAccess(hiddenapi::ApiList::Blacklist()));
+  ASSERT_TRUE(cache->IsKnownNotExempted(class1_field1_, &generation));
+  ASSERT_TRUE(ShouldDenyAccess(hiddenapi::ApiList::Blacklist()));
+
+  // New exemptions matching the member must not be hidden by the cached result.
+  runtime_->SetHiddenApiExemptions({"Lmypackage/packagea/Class1;->field1:"});
+  ASSERT_FALSE(cache->IsKnownNotExempted(class1_field1_, &generation));
+  ASSERT_FALSE(ShouldDenyAccess(hiddenapi::ApiList::Blacklist()));
+  runtime_->SetHiddenApiExemptions({});
+}
+
 TEST_F(HiddenApiTest, CheckMemberSignatureForProxyClass) {
   ScopedObjectAccess soa(self_);
   StackHandleScope<4> hs(soa.Self());
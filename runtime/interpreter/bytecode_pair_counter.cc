@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bytecode_pair_counter.h"
+
+#include <algorithm>
+#include <ostream>
+#include <tuple>
+#include <vector>
+
+#include "art_method-inl.h"
+#include "base/casts.h"
+#include "dex/code_item_accessors-inl.h"
+#include "runtime.h"
+#include "thread-current-inl.h"
+
+namespace art {
+namespace interpreter {
+
+static constexpr const char* kFramesTLSKey = "BytecodePairCounter";
+
+// Marks a frame which has not interpreted an instruction yet.
+static constexpr uint16_t kNoOpcode = Instruction::kNumPackedOpcodes;
+
+// The last instruction interpreted in each frame of a thread entered while counting. Frames
+// entered before are added when they interpret their next instruction and no newer frame is
+// known.
+class BytecodePairCounter::Frames : public TLSData {
+ public:
+  explicit Frames(uint32_t generation) : generation_(generation) {}
+
+  uint32_t generation_;
+  std::vector<uint16_t> last_opcodes_;
+};
+
+BytecodePairCounter* BytecodePairCounter::the_counter_ = nullptr;
+uint32_t BytecodePairCounter::generation_ = 0u;
+
+BytecodePairCounter::BytecodePairCounter() {
+  for (auto& counts : counts_) {
+    for (std::atomic<uint32_t>& count : counts) {
+      count.store(0u, std::memory_order_relaxed);
+    }
+  }
+}
+
+void BytecodePairCounter::Start() {
+  Locks::mutator_lock_->AssertExclusiveHeld(Thread::Current());
+  CHECK(the_counter_ == nullptr);
+  the_counter_ = new BytecodePairCounter();
+  // Frames recorded by threads while counting previously are stale.
+  ++generation_;
+  Runtime::Current()->GetInstrumentation()->AddListener(the_counter_, kEvents);
+}
+
+void BytecodePairCounter::Stop() {
+  Locks::mutator_lock_->AssertExclusiveHeld(Thread::Current());
+  CHECK(the_counter_ != nullptr);
+  Runtime::Current()->GetInstrumentation()->RemoveListener(the_counter_, kEvents);
+  delete the_counter_;
+  the_counter_ = nullptr;
+}
+
+uint32_t BytecodePairCounter::GetCount(Instruction::Code first, Instruction::Code second) {
+  if (the_counter_ == nullptr) {
+    return 0u;
+  }
+  return the_counter_->counts_[first][second].load(std::memory_order_relaxed);
+}
+
+void BytecodePairCounter::Dump(std::ostream& os) {
+  if (the_counter_ == nullptr) {
+    return;
+  }
+  static constexpr size_t kMaxDumpedPairs = 64u;
+  std::vector<std::tuple<uint32_t, size_t, size_t>> pairs;
+  for (size_t first = 0; first != Instruction::kNumPackedOpcodes; ++first) {
+    for (size_t second = 0; second != Instruction::kNumPackedOpcodes; ++second) {
+      uint32_t count = the_counter_->counts_[first][second].load(std::memory_order_relaxed);
+      if (count != 0u) {
+        pairs.emplace_back(count, first, second);
+      }
+    }
+  }
+  std::sort(pairs.rbegin(), pairs.rend());
+  os << "Interpreter bytecode pairs:\n";
+  for (size_t i = 0, size = std::min(pairs.size(), kMaxDumpedPairs); i != size; ++i) {
+    os << "  " << std::get<0>(pairs[i]) << " "
+       << Instruction::Name(static_cast<Instruction::Code>(std::get<1>(pairs[i]))) << " -> "
+       << Instruction::Name(static_cast<Instruction::Code>(std::get<2>(pairs[i]))) << "\n";
+  }
+}
+
+BytecodePairCounter::Frames* BytecodePairCounter::GetFrames(Thread* thread) {
+  Frames* frames = down_cast<Frames*>(thread->GetCustomTLS(kFramesTLSKey));
+  if (UNLIKELY(frames == nullptr)) {
+    frames = new Frames(generation_);
+    thread->SetCustomTLS(kFramesTLSKey, frames);
+  } else if (UNLIKELY(frames->generation_ != generation_)) {
+    frames->generation_ = generation_;
+    frames->last_opcodes_.clear();
+  }
+  return frames;
+}
+
+void BytecodePairCounter::DexPcMoved(Thread* thread,
+                                     Handle<mirror::Object> this_object ATTRIBUTE_UNUSED,
+                                     ArtMethod* method,
+                                     uint32_t new_dex_pc) {
+  // Pair the instruction with the one interpreted before it in the same frame. This follows
+  // branches and the return to the caller of an invoke, and never sees switch and array data
+  // payloads, unlike the instruction which follows in the code item.
+  Instruction::Code opcode = method->DexInstructions().InstructionAt(new_dex_pc).Opcode();
+  std::vector<uint16_t>& last_opcodes = GetFrames(thread)->last_opcodes_;
+  if (last_opcodes.empty()) {
+    last_opcodes.push_back(kNoOpcode);
+  }
+  if (last_opcodes.back() != kNoOpcode) {
+    counts_[last_opcodes.back()][opcode].fetch_add(1u, std::memory_order_relaxed);
+  }
+  last_opcodes.back() = opcode;
+}
+
+void BytecodePairCounter::MethodEntered(Thread* thread,
+                                        Handle<mirror::Object> this_object ATTRIBUTE_UNUSED,
+                                        ArtMethod* method ATTRIBUTE_UNUSED,
+                                        uint32_t dex_pc ATTRIBUTE_UNUSED) {
+  GetFrames(thread)->last_opcodes_.push_back(kNoOpcode);
+}
+
+void BytecodePairCounter::MethodExited(Thread* thread,
+                                       Handle<mirror::Object> this_object ATTRIBUTE_UNUSED,
+                                       ArtMethod* method ATTRIBUTE_UNUSED,
+                                       uint32_t dex_pc ATTRIBUTE_UNUSED,
+                                       const JValue& return_value ATTRIBUTE_UNUSED) {
+  PopFrame(thread);
+}
+
+void BytecodePairCounter::MethodUnwind(Thread* thread,
+                                       Handle<mirror::Object> this_object ATTRIBUTE_UNUSED,
+                                       ArtMethod* method ATTRIBUTE_UNUSED,
+                                       uint32_t dex_pc ATTRIBUTE_UNUSED) {
+  PopFrame(thread);
+}
+
+void BytecodePairCounter::PopFrame(Thread* thread) {
+  std::vector<uint16_t>& last_opcodes = GetFrames(thread)->last_opcodes_;
+  // The frames entered before counting started may not be known.
+  if (!last_opcodes.empty()) {
+    last_opcodes.pop_back();
+  }
+}
+
+void BytecodePairCounter::FieldRead(Thread* thread ATTRIBUTE_UNUSED,
+                                    Handle<mirror::Object> this_object ATTRIBUTE_UNUSED,
+                                    ArtMethod* method ATTRIBUTE_UNUSED,
+                                    uint32_t dex_pc ATTRIBUTE_UNUSED,
+                                    ArtField* field ATTRIBUTE_UNUSED) {
+  LOG(FATAL) << "Unexpected event in bytecode pair counting";
+  UNREACHABLE();
+}
+
+void BytecodePairCounter::FieldWritten(Thread* thread ATTRIBUTE_UNUSED,
+                                       Handle<mirror::Object> this_object ATTRIBUTE_UNUSED,
+                                       ArtMethod* method ATTRIBUTE_UNUSED,
+                                       uint32_t dex_pc ATTRIBUTE_UNUSED,
+                                       ArtField* field ATTRIBUTE_UNUSED,
+                                       const JValue& field_value ATTRIBUTE_UNUSED) {
+  LOG(FATAL) << "Unexpected event in bytecode pair counting";
+  UNREACHABLE();
+}
+
+void BytecodePairCounter::ExceptionThrown(
+    Thread* thread ATTRIBUTE_UNUSED,
+    Handle<mirror::Throwable> exception_object ATTRIBUTE_UNUSED) {
+  LOG(FATAL) << "Unexpected event in bytecode pair counting";
+  UNREACHABLE();
+}
+
+void BytecodePairCounter::ExceptionHandled(
+    Thread* thread ATTRIBUTE_UNUSED,
+    Handle<mirror::Throwable> exception_object ATTRIBUTE_UNUSED) {
+  LOG(FATAL) << "Unexpected event in bytecode pair counting";
+  UNREACHABLE();
+}
+
+void BytecodePairCounter::Branch(Thread* thread ATTRIBUTE_UNUSED,
+                                 ArtMethod* method ATTRIBUTE_UNUSED,
+                                 uint32_t dex_pc ATTRIBUTE_UNUSED,
+                                 int32_t dex_pc_offset ATTRIBUTE_UNUSED) {
+  LOG(FATAL) << "Unexpected event in bytecode pair counting";
+  UNREACHABLE();
+}
+
+void BytecodePairCounter::WatchedFramePop(Thread* thread ATTRIBUTE_UNUSED,
+                                          const ShadowFrame& frame ATTRIBUTE_UNUSED) {
+  LOG(FATAL) << "Unexpected event in bytecode pair counting";
+  UNREACHABLE();
+}
+
+}  // namespace interpreter
+}  // namespace art
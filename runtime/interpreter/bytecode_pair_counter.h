@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_INTERPRETER_BYTECODE_PAIR_COUNTER_H_
+#define ART_RUNTIME_INTERPRETER_BYTECODE_PAIR_COUNTER_H_
+
+#include <atomic>
+#include <iosfwd>
+
+#include "base/locks.h"
+#include "base/macros.h"
+#include "dex/dex_instruction.h"
+#include "instrumentation.h"
+
+namespace art {
+namespace interpreter {
+
+// Profiling tool which counts, for each interpreted instruction, the opcode of the instruction
+// interpreted next in the same frame. These are the pairs a fused interpreter handler would run
+// back to back, so the most frequent ones are the candidates for fusing.
+//
+// Enabled with the runtime option -Xcount-bytecode-pairs, and printed in the SIGQUIT dump.
+// The counter is a dex pc and method entry and exit listener, so it costs nothing when
+// disabled. When enabled, mterp is replaced by the switch interpreter and only interpreted
+// code is counted, so it is meant to be used together with -Xint.
+class BytecodePairCounter final : public instrumentation::InstrumentationListener {
+ public:
+  // Starts counting. Requires all other threads to be suspended.
+  static void Start() REQUIRES(Locks::mutator_lock_, !Locks::thread_list_lock_);
+
+  // Stops counting and discards the counts. Requires all other threads to be suspended.
+  static void Stop() REQUIRES(Locks::mutator_lock_, !Locks::thread_list_lock_);
+
+  // Returns how many times an instruction `first` followed by `second` was interpreted.
+  static uint32_t GetCount(Instruction::Code first, Instruction::Code second);
+
+  // Prints the most frequent pairs, if counting.
+  static void Dump(std::ostream& os);
+
+  void MethodEntered(Thread* thread,
+                     Handle<mirror::Object> this_object,
+                     ArtMethod* method,
+                     uint32_t dex_pc) override REQUIRES_SHARED(Locks::mutator_lock_);
+
+  void MethodExited(Thread* thread,
+                    Handle<mirror::Object> this_object,
+                    ArtMethod* method,
+                    uint32_t dex_pc,
+                    const JValue& return_value)
+      override REQUIRES_SHARED(Locks::mutator_lock_);
+
+  void MethodUnwind(Thread* thread,
+                    Handle<mirror::Object> this_object,
+                    ArtMethod* method,
+                    uint32_t dex_pc)
+      override REQUIRES_SHARED(Locks::mutator_lock_);
+
+  void DexPcMoved(Thread* thread,
+                  Handle<mirror::Object> this_object,
+                  ArtMethod* method,
+                  uint32_t new_dex_pc)
+      override REQUIRES_SHARED(Locks::mutator_lock_);
+
+  void FieldRead(Thread* thread,
+                 Handle<mirror::Object> this_object,
+                 ArtMethod* method,
+                 uint32_t dex_pc,
+                 ArtField* field)
+      override REQUIRES_SHARED(Locks::mutator_lock_);
+
+  void FieldWritten(Thread* thread,
+                    Handle<mirror::Object> this_object,
+                    ArtMethod* method,
+                    uint32_t dex_pc,
+                    ArtField* field,
+                    const JValue& field_value)
+      override REQUIRES_SHARED(Locks::mutator_lock_);
+
+  void ExceptionThrown(Thread* thread,
+                       Handle<mirror::Throwable> exception_object)
+      override REQUIRES_SHARED(Locks::mutator_lock_);
+
+  void ExceptionHandled(Thread* thread, Handle<mirror::Throwable> exception_object)
+      override REQUIRES_SHARED(Locks::mutator_lock_);
+
+  void Branch(Thread* thread,
+              ArtMethod* method,
+              uint32_t dex_pc,
+              int32_t dex_pc_offset)
+      override REQUIRES_SHARED(Locks::mutator_lock_);
+
+  void WatchedFramePop(Thread* thread, const ShadowFrame& frame)
+      override REQUIRES_SHARED(Locks::mutator_lock_);
+
+ private:
+  class Frames;
+
+  static constexpr uint32_t kEvents = instrumentation::Instrumentation::kMethodEntered |
+                                      instrumentation::Instrumentation::kMethodExited |
+                                      instrumentation::Instrumentation::kMethodUnwind |
+                                      instrumentation::Instrumentation::kDexPcMoved;
+
+  BytecodePairCounter();
+
+  // Returns the frames of `thread`, which must be the current thread.
+  static Frames* GetFrames(Thread* thread);
+  static void PopFrame(Thread* thread);
+
+  // The counter while counting, null otherwise.
+  static BytecodePairCounter* the_counter_;
+
+  // Incremented by Start(), to discard the frames recorded while counting previously.
+  static uint32_t generation_;
+
+  std::atomic<uint32_t> counts_[Instruction::kNumPackedOpcodes][Instruction::kNumPackedOpcodes];
+
+  DISALLOW_COPY_AND_ASSIGN(BytecodePairCounter);
+};
+
+}  // namespace interpreter
+}  // namespace art
+
+#endif  // ART_RUNTIME_INTERPRETER_BYTECODE_PAIR_COUNTER_H_
@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bytecode_pair_counter.h"
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <utility>
+
+#include "art_method-inl.h"
+#include "class_linker-inl.h"
+#include "common_runtime_test.h"
+#include "dex/code_item_accessors-inl.h"
+#include "handle_scope-inl.h"
+#include "interpreter.h"
+#include "jvalue.h"
+#include "runtime.h"
+#include "scoped_thread_state_change-inl.h"
+#include "thread-inl.h"
+#include "thread_list.h"
+
+namespace art {
+namespace interpreter {
+
+class BytecodePairCounterTest : public CommonRuntimeTest {};
+
+TEST_F(BytecodePairCounterTest, CountsInterpretedPairs) {
+  Thread* self = Thread::Current();
+  {
+    ScopedSuspendAll ssa("Start bytecode pair counting");
+    BytecodePairCounter::Start();
+  }
+
+  {
+    ScopedObjectAccess soa(self);
+    jobject jclass_loader = LoadDex("StaticLeafMethods");
+    StackHandleScope<1> hs(soa.Self());
+    Handle<mirror::ClassLoader> class_loader(
+        hs.NewHandle(soa.Decode<mirror::ClassLoader>(jclass_loader)));
+    ObjPtr<mirror::Class> klass = class_linker_->FindClass(
+        soa.Self(), "LStaticLeafMethods;", class_loader);
+    ASSERT_TRUE(klass != nullptr);
+    ArtMethod* method = klass->FindClassMethod("sum", "(III)I", kRuntimePointerSize);
+    ASSERT_TRUE(method != nullptr);
+
+    // The method is straight-line code, so each call runs every pair of adjacent instructions.
+    std::map<std::pair<Instruction::Code, Instruction::Code>, uint32_t> expected;
+    CodeItemInstructionAccessor accessor = method->DexInstructions();
+    for (auto it = accessor.begin(), next = it; it != accessor.end(); it = next) {
+      ++next;
+      if (next != accessor.end()) {
+        ++expected[std::make_pair(it->Opcode(), next->Opcode())];
+      }
+    }
+    ASSERT_FALSE(expected.empty());
+    std::map<std::pair<Instruction::Code, Instruction::Code>, uint32_t> before;
+    for (const auto& entry : expected) {
+      before[entry.first] = BytecodePairCounter::GetCount(entry.first.first, entry.first.second);
+    }
+
+    static constexpr uint32_t kNumCalls = 10u;
+    for (uint32_t i = 0; i != kNumCalls; ++i) {
+      uint32_t args[] = { 1, 2, 3 };
+      JValue result;
+      EnterInterpreterFromInvoke(soa.Self(), method, /* receiver= */ nullptr, args, &result);
+      ASSERT_FALSE(soa.Self()->IsExceptionPending());
+      EXPECT_EQ(6, result.GetI());
+    }
+
+    for (const auto& entry : expected) {
+      uint32_t count = BytecodePairCounter::GetCount(entry.first.first, entry.first.second);
+      EXPECT_EQ(kNumCalls * entry.second, count - before[entry.first])
+          << Instruction::Name(entry.first.first) << " -> "
+          << Instruction::Name(entry.first.second);
+    }
+
+    std::ostringstream oss;
+    BytecodePairCounter::Dump(oss);
+    EXPECT_NE(std::string::npos, oss.str().find("Interpreter bytecode pairs:")) << oss.str();
+    EXPECT_NE(std::string::npos, oss.str().find(" -> ")) << oss.str();
+  }
+
+  {
+    ScopedSuspendAll ssa("Stop bytecode pair counting");
+    BytecodePairCounter::Stop();
+  }
+  // Nothing is counted or dumped after stopping.
+  EXPECT_EQ(0u, BytecodePairCounter::GetCount(Instruction::ADD_INT, Instruction::RETURN));
+  std::ostringstream oss;
+  BytecodePairCounter::Dump(oss);
+  EXPECT_TRUE(oss.str().empty());
+}
+
+// Invokes, branches and switches are followed by the instruction actually interpreted next in
+// the same frame, not by the one following them in the code item.
+TEST_F(BytecodePairCounterTest, CountsExecutedPairs) {
+  Thread* self = Thread::Current();
+  {
+    ScopedSuspendAll ssa("Start bytecode pair counting");
+    BytecodePairCounter::Start();
+  }
+
+  {
+    ScopedObjectAccess soa(self);
+    jobject jclass_loader = LoadDex("BytecodePairs");
+    StackHandleScope<1> hs(soa.Self());
+    Handle<mirror::ClassLoader> class_loader(
+        hs.NewHandle(soa.Decode<mirror::ClassLoader>(jclass_loader)));
+    ObjPtr<mirror::Class> klass =
+        class_linker_->FindClass(soa.Self(), "LBytecodePairs;", class_loader);
+    ASSERT_TRUE(klass != nullptr);
+    ArtMethod* callee = klass->FindClassMethod("callee", "(I)I", kRuntimePointerSize);
+    ArtMethod* caller = klass->FindClassMethod("caller", "(I)I", kRuntimePointerSize);
+    ArtMethod* select = klass->FindClassMethod("select", "(I)I", kRuntimePointerSize);
+    ASSERT_TRUE(callee != nullptr);
+    ASSERT_TRUE(caller != nullptr);
+    ASSERT_TRUE(select != nullptr);
+    auto call = [&](ArtMethod* method, uint32_t arg) REQUIRES_SHARED(Locks::mutator_lock_) {
+      uint32_t args[] = { arg };
+      JValue result;
+      EnterInterpreterFromInvoke(soa.Self(), method, /* receiver= */ nullptr, args, &result);
+      EXPECT_FALSE(soa.Self()->IsExceptionPending());
+      return result.GetI();
+    };
+    auto count_followers = [](Instruction::Code first) {
+      uint32_t total = 0u;
+      for (size_t second = 0; second != Instruction::kNumPackedOpcodes; ++second) {
+        total += BytecodePairCounter::GetCount(first, static_cast<Instruction::Code>(second));
+      }
+      return total;
+    };
+    auto count_leaders = [](Instruction::Code second) {
+      uint32_t total = 0u;
+      for (size_t first = 0; first != Instruction::kNumPackedOpcodes; ++first) {
+        total += BytecodePairCounter::GetCount(static_cast<Instruction::Code>(first), second);
+      }
+      return total;
+    };
+    static constexpr uint32_t kNumCalls = 10u;
+
+    // The invoke is followed by the move-result of the caller, not by the first instruction
+    // of the callee.
+    Instruction::Code callee_first = callee->DexInstructions().begin()->Opcode();
+    ASSERT_NE(Instruction::MOVE_RESULT, callee_first);
+    uint32_t invoke_move_result =
+        BytecodePairCounter::GetCount(Instruction::INVOKE_STATIC, Instruction::MOVE_RESULT);
+    uint32_t invoke_callee_first =
+        BytecodePairCounter::GetCount(Instruction::INVOKE_STATIC, callee_first);
+    uint32_t invoke_followers = count_followers(Instruction::INVOKE_STATIC);
+    for (uint32_t i = 0; i != kNumCalls; ++i) {
+      EXPECT_EQ(static_cast<int32_t>(i + 1u) * 3, call(caller, i));
+    }
+    EXPECT_EQ(kNumCalls,
+              BytecodePairCounter::GetCount(Instruction::INVOKE_STATIC, Instruction::MOVE_RESULT) -
+                  invoke_move_result);
+    EXPECT_EQ(invoke_callee_first,
+              BytecodePairCounter::GetCount(Instruction::INVOKE_STATIC, callee_first));
+    EXPECT_EQ(kNumCalls, count_followers(Instruction::INVOKE_STATIC) - invoke_followers);
+
+    // Each switch is followed by exactly one instruction, and the payload is never counted.
+    uint32_t switch_followers = count_followers(Instruction::PACKED_SWITCH);
+    uint32_t nop_leaders = count_leaders(Instruction::NOP);
+    CodeItemInstructionAccessor select_accessor = select->DexInstructions();
+    ASSERT_TRUE(std::any_of(select_accessor.begin(),
+                            select_accessor.end(),
+                            [](const DexInstructionPcPair& inst) {
+                              return inst->Opcode() == Instruction::PACKED_SWITCH;
+                            }));
+    static constexpr int32_t kSelected[] = { 10, 21, 32, 43, 54, 65, 76, 87, 98, 98 };
+    for (uint32_t i = 0; i != arraysize(kSelected); ++i) {
+      EXPECT_EQ(kSelected[i], call(select, i));
+    }
+    EXPECT_EQ(arraysize(kSelected), count_followers(Instruction::PACKED_SWITCH) - switch_followers);
+    EXPECT_EQ(nop_leaders, count_leaders(Instruction::NOP));
+  }
+
+  {
+    ScopedSuspendAll ssa("Stop bytecode pair counting");
+    BytecodePairCounter::Stop();
+  }
+}
+
+}  // namespace interpreter
+}  // namespace art
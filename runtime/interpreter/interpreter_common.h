@@ -205,7 +205,7 @@ static ALWAYS_INLINE bool DoInvoke(Thread* self,
     jit->InvokeVirtualOrInterface(receiver, sf_method, shadow_frame.GetDexPC(), called_method);
   }
 
-  if (is_mterp && !is_range && called_method->IsIntrinsic()) {
+  if (is_mterp && called_method->IsIntrinsic()) {
     if (MterpHandleIntrinsic(&shadow_frame, called_method, inst, inst_data,
                              shadow_frame.GetResultRegister())) {
       if (jit != nullptr && sf_method != nullptr) {
@@ -17,12 +17,40 @@
 #include "interpreter/interpreter_intrinsics.h"
 
 #include "dex/dex_instruction.h"
+#include "gc/heap.h"
+#include "gc/reference_processor.h"
 #include "intrinsics_enum.h"
 #include "interpreter/interpreter_common.h"
+#include "mirror/array-inl.h"
+#include "mirror/reference-inl.h"
+#include "read_barrier-inl.h"
+#include "runtime.h"
 
 namespace art {
 namespace interpreter {
 
+// Enough for the longest intrinsic signature, sun.misc.Unsafe.compareAndSwapLong(Object, long,
+// long, long) including the receiver.
+static constexpr size_t kMaxIntrinsicArgRegs = 8u;
+
+// Fills `arg` with the argument registers of an invoke in either the 35c or the 3rc format.
+// Intrinsics taking more than five registers, such as the Unsafe CAS, are always invoked
+// through the range variants. MterpHandleIntrinsic() rejects range invokes with more than
+// kMaxIntrinsicArgRegs registers before getting here.
+static ALWAYS_INLINE void GetIntrinsicArgs(const Instruction* inst,
+                                           uint16_t inst_data,
+                                           uint32_t arg[kMaxIntrinsicArgRegs]) {
+  if (Instruction::FormatOf(inst->Opcode()) == Instruction::k3rc) {
+    uint32_t first = inst->VRegC_3rc();
+    uint32_t count = inst->VRegA_3rc(inst_data);
+    DCHECK_LE(count, kMaxIntrinsicArgRegs);
+    for (uint32_t i = 0; i != count; ++i) {
+      arg[i] = first + i;
+    }
+  } else {
+    inst->GetVarArgs(arg, inst_data);
+  }
+}
 
 #define BINARY_INTRINSIC(name, op, get1, get2, set)                 \
 static ALWAYS_INLINE bool name(ShadowFrame* shadow_frame,           \
@@ -30,8 +58,8 @@ static ALWAYS_INLINE bool name(ShadowFrame* shadow_frame,           \
                                uint16_t inst_data,                  \
                                JValue* result_register)             \
     REQUIRES_SHARED(Locks::mutator_lock_) {                         \
-  uint32_t arg[Instruction::kMaxVarArgRegs] = {};                   \
-  inst->GetVarArgs(arg, inst_data);                                 \
+  uint32_t arg[kMaxIntrinsicArgRegs] = {};                          \
+  GetIntrinsicArgs(inst, inst_data, arg);                           \
   result_register->set(op(shadow_frame->get1, shadow_frame->get2)); \
   return true;                                                      \
 }
@@ -51,8 +79,8 @@ static ALWAYS_INLINE bool name(ShadowFrame* shadow_frame,    \
                                uint16_t inst_data,           \
                                JValue* result_register)      \
     REQUIRES_SHARED(Locks::mutator_lock_) {                  \
-  uint32_t arg[Instruction::kMaxVarArgRegs] = {};            \
-  inst->GetVarArgs(arg, inst_data);                          \
+  uint32_t arg[kMaxIntrinsicArgRegs] = {};                   \
+  GetIntrinsicArgs(inst, inst_data, arg);                    \
   result_register->set(op(shadow_frame->get(arg[0])));       \
   return true;                                               \
 }
@@ -184,8 +212,8 @@ static ALWAYS_INLINE bool MterpStringCharAt(ShadowFrame* shadow_frame,
                                             uint16_t inst_data,
                                             JValue* result_register)
     REQUIRES_SHARED(Locks::mutator_lock_) {
-  uint32_t arg[Instruction::kMaxVarArgRegs] = {};
-  inst->GetVarArgs(arg, inst_data);
+  uint32_t arg[kMaxIntrinsicArgRegs] = {};
+  GetIntrinsicArgs(inst, inst_data, arg);
   ObjPtr<mirror::String> str = shadow_frame->GetVRegReference(arg[0])->AsString();
   int length = str->GetLength();
   int index = shadow_frame->GetVReg(arg[1]);
@@ -208,8 +236,8 @@ static ALWAYS_INLINE bool MterpStringCompareTo(ShadowFrame* shadow_frame,
                                                uint16_t inst_data,
                                                JValue* result_register)
     REQUIRES_SHARED(Locks::mutator_lock_) {
-  uint32_t arg[Instruction::kMaxVarArgRegs] = {};
-  inst->GetVarArgs(arg, inst_data);
+  uint32_t arg[kMaxIntrinsicArgRegs] = {};
+  GetIntrinsicArgs(inst, inst_data, arg);
   ObjPtr<mirror::String> str = shadow_frame->GetVRegReference(arg[0])->AsString();
   ObjPtr<mirror::Object> arg1 = shadow_frame->GetVRegReference(arg[1]);
   if (arg1 == nullptr) {
@@ -225,8 +253,8 @@ static ALWAYS_INLINE bool Mterp##name(ShadowFrame* shadow_frame, \
                                       uint16_t inst_data,        \
                                       JValue* result_register)   \
     REQUIRES_SHARED(Locks::mutator_lock_) {                      \
-  uint32_t arg[Instruction::kMaxVarArgRegs] = {};                \
-  inst->GetVarArgs(arg, inst_data);                              \
+  uint32_t arg[kMaxIntrinsicArgRegs] = {};                       \
+  GetIntrinsicArgs(inst, inst_data, arg);                        \
   ObjPtr<mirror::String> str = shadow_frame->GetVRegReference(arg[0])->AsString(); \
   int ch = shadow_frame->GetVReg(arg[1]);                        \
   if (ch >= 0x10000) {                                           \
@@ -249,8 +277,8 @@ static ALWAYS_INLINE bool Mterp##name(ShadowFrame* shadow_frame, \
                                       uint16_t inst_data,        \
                                       JValue* result_register)   \
     REQUIRES_SHARED(Locks::mutator_lock_) {                      \
-  uint32_t arg[Instruction::kMaxVarArgRegs] = {};                \
-  inst->GetVarArgs(arg, inst_data);                              \
+  uint32_t arg[kMaxIntrinsicArgRegs] = {};                       \
+  GetIntrinsicArgs(inst, inst_data, arg);                        \
   ObjPtr<mirror::String> str = shadow_frame->GetVRegReference(arg[0])->AsString(); \
   result_register->operation;                                    \
   return true;                                                   \
@@ -269,8 +297,8 @@ static ALWAYS_INLINE bool MterpStringGetCharsNoCheck(ShadowFrame* shadow_frame,
                                                      JValue* result_register ATTRIBUTE_UNUSED)
     REQUIRES_SHARED(Locks::mutator_lock_) {
   // Start, end & index already checked by caller - won't throw.  Destination is uncompressed.
-  uint32_t arg[Instruction::kMaxVarArgRegs] = {};
-  inst->GetVarArgs(arg, inst_data);
+  uint32_t arg[kMaxIntrinsicArgRegs] = {};
+  GetIntrinsicArgs(inst, inst_data, arg);
   ObjPtr<mirror::String> str = shadow_frame->GetVRegReference(arg[0])->AsString();
   int32_t start = shadow_frame->GetVReg(arg[1]);
   int32_t end = shadow_frame->GetVReg(arg[2]);
@@ -296,8 +324,8 @@ static ALWAYS_INLINE bool MterpStringEquals(ShadowFrame* shadow_frame,
                                             uint16_t inst_data,
                                             JValue* result_register)
     REQUIRES_SHARED(Locks::mutator_lock_) {
-  uint32_t arg[Instruction::kMaxVarArgRegs] = {};
-  inst->GetVarArgs(arg, inst_data);
+  uint32_t arg[kMaxIntrinsicArgRegs] = {};
+  GetIntrinsicArgs(inst, inst_data, arg);
   ObjPtr<mirror::String> str = shadow_frame->GetVRegReference(arg[0])->AsString();
   ObjPtr<mirror::Object> obj = shadow_frame->GetVRegReference(arg[1]);
   bool res = false;  // Assume not equal.
@@ -323,6 +351,169 @@ static ALWAYS_INLINE bool MterpStringEquals(ShadowFrame* shadow_frame,
   return true;
 }
 
+// Copies between two arrays of the same class. Returns false without copying anything if the
+// arguments are null, not arrays of the same class or out of bounds; the native method then
+// throws the appropriate exception or does the checked copy between different classes.
+static ALWAYS_INLINE bool ArrayCopySameClass(ShadowFrame* shadow_frame, const uint32_t* arg)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  ObjPtr<mirror::Object> src_obj = shadow_frame->GetVRegReference(arg[0]);
+  int32_t src_pos = shadow_frame->GetVReg(arg[1]);
+  ObjPtr<mirror::Object> dst_obj = shadow_frame->GetVRegReference(arg[2]);
+  int32_t dst_pos = shadow_frame->GetVReg(arg[3]);
+  int32_t count = shadow_frame->GetVReg(arg[4]);
+  if (src_obj == nullptr || dst_obj == nullptr || src_obj->GetClass() != dst_obj->GetClass() ||
+      !src_obj->IsArrayInstance()) {
+    return false;
+  }
+  ObjPtr<mirror::Array> src = src_obj->AsArray();
+  ObjPtr<mirror::Array> dst = dst_obj->AsArray();
+  if (UNLIKELY(src_pos < 0) || UNLIKELY(dst_pos < 0) || UNLIKELY(count < 0) ||
+      UNLIKELY(src_pos > src->GetLength() - count) ||
+      UNLIKELY(dst_pos > dst->GetLength() - count)) {
+    return false;  // Punt and let non-intrinsic version deal with the throw.
+  }
+  switch (src->GetClass()->GetComponentType()->GetPrimitiveType()) {
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte:
+      ObjPtr<mirror::ByteArray>::DownCast(dst)->Memmove(
+          dst_pos, ObjPtr<mirror::ByteArray>::DownCast(src), src_pos, count);
+      return true;
+    case Primitive::kPrimChar:
+    case Primitive::kPrimShort:
+      ObjPtr<mirror::ShortArray>::DownCast(dst)->Memmove(
+          dst_pos, ObjPtr<mirror::ShortArray>::DownCast(src), src_pos, count);
+      return true;
+    case Primitive::kPrimInt:
+    case Primitive::kPrimFloat:
+      ObjPtr<mirror::IntArray>::DownCast(dst)->Memmove(
+          dst_pos, ObjPtr<mirror::IntArray>::DownCast(src), src_pos, count);
+      return true;
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble:
+      ObjPtr<mirror::LongArray>::DownCast(dst)->Memmove(
+          dst_pos, ObjPtr<mirror::LongArray>::DownCast(src), src_pos, count);
+      return true;
+    case Primitive::kPrimNot:
+      dst->AsObjectArray<mirror::Object>()->AssignableMemmove(
+          dst_pos, src->AsObjectArray<mirror::Object>(), src_pos, count);
+      return true;
+    case Primitive::kPrimVoid:
+      break;
+  }
+  LOG(FATAL) << "Unreachable, cannot have arrays of type void";
+  UNREACHABLE();
+}
+
+// java.lang.System.arraycopy([CI[CII)V
+static ALWAYS_INLINE bool MterpSystemArrayCopyChar(ShadowFrame* shadow_frame,
+                                                   const Instruction* inst,
+                                                   uint16_t inst_data,
+                                                   JValue* result_register ATTRIBUTE_UNUSED)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  uint32_t arg[kMaxIntrinsicArgRegs] = {};
+  GetIntrinsicArgs(inst, inst_data, arg);
+  return ArrayCopySameClass(shadow_frame, arg);
+}
+
+// java.lang.System.arraycopy(Ljava/lang/Object;ILjava/lang/Object;II)V
+static ALWAYS_INLINE bool MterpSystemArrayCopy(ShadowFrame* shadow_frame,
+                                               const Instruction* inst,
+                                               uint16_t inst_data,
+                                               JValue* result_register ATTRIBUTE_UNUSED)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  uint32_t arg[kMaxIntrinsicArgRegs] = {};
+  GetIntrinsicArgs(inst, inst_data, arg);
+  return ArrayCopySameClass(shadow_frame, arg);
+}
+
+// sun.misc.Unsafe.compareAndSwapInt(Ljava/lang/Object;JII)Z
+static ALWAYS_INLINE bool MterpUnsafeCASInt(ShadowFrame* shadow_frame,
+                                            const Instruction* inst,
+                                            uint16_t inst_data,
+                                            JValue* result_register)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  uint32_t arg[kMaxIntrinsicArgRegs] = {};
+  GetIntrinsicArgs(inst, inst_data, arg);
+  ObjPtr<mirror::Object> obj = shadow_frame->GetVRegReference(arg[1]);
+  if (obj == nullptr) {
+    return false;
+  }
+  MemberOffset offset(shadow_frame->GetVRegLong(arg[2]));
+  bool success = obj->CasField32</*kTransactionActive=*/ false>(offset,
+                                                                shadow_frame->GetVReg(arg[4]),
+                                                                shadow_frame->GetVReg(arg[5]),
+                                                                CASMode::kStrong,
+                                                                std::memory_order_seq_cst);
+  result_register->SetZ(success);
+  return true;
+}
+
+// sun.misc.Unsafe.compareAndSwapLong(Ljava/lang/Object;JJJ)Z
+static ALWAYS_INLINE bool MterpUnsafeCASLong(ShadowFrame* shadow_frame,
+                                             const Instruction* inst,
+                                             uint16_t inst_data,
+                                             JValue* result_register)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  uint32_t arg[kMaxIntrinsicArgRegs] = {};
+  GetIntrinsicArgs(inst, inst_data, arg);
+  ObjPtr<mirror::Object> obj = shadow_frame->GetVRegReference(arg[1]);
+  if (obj == nullptr) {
+    return false;
+  }
+  MemberOffset offset(shadow_frame->GetVRegLong(arg[2]));
+  bool success = obj->CasFieldStrongSequentiallyConsistent64</*kTransactionActive=*/ false>(
+      offset, shadow_frame->GetVRegLong(arg[4]), shadow_frame->GetVRegLong(arg[6]));
+  result_register->SetZ(success);
+  return true;
+}
+
+// sun.misc.Unsafe.compareAndSwapObject(Ljava/lang/Object;JLjava/lang/Object;Ljava/lang/Object;)Z
+static ALWAYS_INLINE bool MterpUnsafeCASObject(ShadowFrame* shadow_frame,
+                                               const Instruction* inst,
+                                               uint16_t inst_data,
+                                               JValue* result_register)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  uint32_t arg[kMaxIntrinsicArgRegs] = {};
+  GetIntrinsicArgs(inst, inst_data, arg);
+  ObjPtr<mirror::Object> obj = shadow_frame->GetVRegReference(arg[1]);
+  if (obj == nullptr) {
+    return false;
+  }
+  MemberOffset offset(shadow_frame->GetVRegLong(arg[2]));
+  if (kUseReadBarrier) {
+    // Make sure the field holds a to-space reference or the CAS could fail incorrectly,
+    // as in Unsafe_compareAndSwapObject().
+    mirror::HeapReference<mirror::Object>* field_addr =
+        reinterpret_cast<mirror::HeapReference<mirror::Object>*>(
+            reinterpret_cast<uint8_t*>(obj.Ptr()) + offset.SizeValue());
+    ReadBarrier::Barrier<mirror::Object, /* kIsVolatile= */ false, kWithReadBarrier,
+        /* kAlwaysUpdateField= */ true>(obj.Ptr(), offset, field_addr);
+  }
+  bool success = obj->CasFieldObject</*kTransactionActive=*/ false>(
+      offset,
+      shadow_frame->GetVRegReference(arg[4]),
+      shadow_frame->GetVRegReference(arg[5]),
+      CASMode::kStrong,
+      std::memory_order_seq_cst);
+  result_register->SetZ(success);
+  return true;
+}
+
+// java.lang.ref.Reference.getReferent()Ljava/lang/Object;
+static ALWAYS_INLINE bool MterpReferenceGetReferent(ShadowFrame* shadow_frame,
+                                                    const Instruction* inst,
+                                                    uint16_t inst_data,
+                                                    JValue* result_register)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  uint32_t arg[kMaxIntrinsicArgRegs] = {};
+  GetIntrinsicArgs(inst, inst_data, arg);
+  ObjPtr<mirror::Reference> ref = shadow_frame->GetVRegReference(arg[0])->AsReference();
+  // May wait for the GC to finish processing references, like the native method.
+  result_register->SetL(
+      Runtime::Current()->GetHeap()->GetReferenceProcessor()->GetReferent(Thread::Current(), ref));
+  return true;
+}
+
 #define VARHANDLE_FENCE_INTRINSIC(name, std_memory_operation)              \
 static ALWAYS_INLINE bool name(ShadowFrame* shadow_frame ATTRIBUTE_UNUSED, \
                                const Instruction* inst ATTRIBUTE_UNUSED,   \
@@ -426,6 +617,11 @@ bool MterpHandleIntrinsic(ShadowFrame* shadow_frame,
                           uint16_t inst_data,
                           JValue* result_register)
     REQUIRES_SHARED(Locks::mutator_lock_) {
+  if (Instruction::FormatOf(inst->Opcode()) == Instruction::k3rc &&
+      inst->VRegA_3rc(inst_data) > kMaxIntrinsicArgRegs) {
+    // No intrinsic takes that many registers. Let the normal invoke path handle the call.
+    return false;
+  }
   Intrinsics intrinsic = static_cast<Intrinsics>(called_method->GetIntrinsic());
   bool res = false;  // Assume failure
   switch (intrinsic) {
@@ -498,8 +694,8 @@ bool MterpHandleIntrinsic(ShadowFrame* shadow_frame,
     UNIMPLEMENTED_CASE(MathRint /* (D)D */)
     UNIMPLEMENTED_CASE(MathRoundDouble /* (D)J */)
     UNIMPLEMENTED_CASE(MathRoundFloat /* (F)I */)
-    UNIMPLEMENTED_CASE(SystemArrayCopyChar /* ([CI[CII)V */)
-    UNIMPLEMENTED_CASE(SystemArrayCopy /* (Ljava/lang/Object;ILjava/lang/Object;II)V */)
+    INTRINSIC_CASE(SystemArrayCopyChar)
+    INTRINSIC_CASE(SystemArrayCopy)
     UNIMPLEMENTED_CASE(ThreadCurrentThread /* ()Ljava/lang/Thread; */)
     UNIMPLEMENTED_CASE(MemoryPeekByte /* (J)B */)
     UNIMPLEMENTED_CASE(MemoryPeekIntNative /* (J)I */)
@@ -529,9 +725,9 @@ bool MterpHandleIntrinsic(ShadowFrame* shadow_frame,
     UNIMPLEMENTED_CASE(StringBuilderAppend /* (Ljava/lang/String;)Ljava/lang/StringBuilder; */)
     UNIMPLEMENTED_CASE(StringBuilderLength /* ()I */)
     UNIMPLEMENTED_CASE(StringBuilderToString /* ()Ljava/lang/String; */)
-    UNIMPLEMENTED_CASE(UnsafeCASInt /* (Ljava/lang/Object;JII)Z */)
-    UNIMPLEMENTED_CASE(UnsafeCASLong /* (Ljava/lang/Object;JJJ)Z */)
-    UNIMPLEMENTED_CASE(UnsafeCASObject /* (Ljava/lang/Object;JLjava/lang/Object;Ljava/lang/Object;)Z */)
+    INTRINSIC_CASE(UnsafeCASInt)
+    INTRINSIC_CASE(UnsafeCASLong)
+    INTRINSIC_CASE(UnsafeCASObject)
     UNIMPLEMENTED_CASE(UnsafeGet /* (Ljava/lang/Object;J)I */)
     UNIMPLEMENTED_CASE(UnsafeGetVolatile /* (Ljava/lang/Object;J)I */)
     UNIMPLEMENTED_CASE(UnsafeGetObject /* (Ljava/lang/Object;J)Ljava/lang/Object; */)
@@ -555,7 +751,7 @@ bool MterpHandleIntrinsic(ShadowFrame* shadow_frame,
     UNIMPLEMENTED_CASE(UnsafeLoadFence /* ()V */)
     UNIMPLEMENTED_CASE(UnsafeStoreFence /* ()V */)
     UNIMPLEMENTED_CASE(UnsafeFullFence /* ()V */)
-    UNIMPLEMENTED_CASE(ReferenceGetReferent /* ()Ljava/lang/Object; */)
+    INTRINSIC_CASE(ReferenceGetReferent)
     UNIMPLEMENTED_CASE(IntegerValueOf /* (I)Ljava/lang/Integer; */)
     UNIMPLEMENTED_CASE(ThreadInterrupted /* ()Z */)
     UNIMPLEMENTED_CASE(CRC32Update /* (II)I */)
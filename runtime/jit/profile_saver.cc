@@ -26,6 +26,7 @@
 #include "art_method-inl.h"
 #include "base/enums.h"
 #include "base/logging.h"  // For VLOG.
+#include "base/os.h"
 #include "base/scoped_arena_containers.h"
 #include "base/stl_util.h"
 #include "base/systrace.h"
@@ -38,6 +39,7 @@
 #include "gc/gc_cause.h"
 #include "gc/scoped_gc_critical_section.h"
 #include "jit/profiling_info.h"
+#include "jit/startup_pages.h"
 #include "oat_file_manager.h"
 #include "profile/profile_compilation_info.h"
 #include "scoped_thread_state_change-inl.h"
@@ -98,7 +100,8 @@ ProfileSaver::ProfileSaver(const ProfileSaverOptions& options,
       max_number_of_profile_entries_cached_(0),
       total_number_of_hot_spikes_(0),
       total_number_of_wake_ups_(0),
-      options_(options) {
+      options_(options),
+      startup_pages_filename_(output_filename + StartupPages::kFileSuffix) {
   DCHECK(options_.IsEnabled());
   AddTrackedLocations(output_filename, code_paths);
 }
@@ -122,6 +125,15 @@ void ProfileSaver::NotifyStartupCompleted() {
 void ProfileSaver::Run() {
   Thread* self = Thread::Current();
 
+  if (options_.GetPrefetchStartupPages() &&
+      OS::FileExists(startup_pages_filename_.c_str(), /*check_file_type=*/ false)) {
+    // Start reading the pages used during the previous startup into the page cache.
+    std::string error_msg;
+    if (StartupPages::Prefetch(startup_pages_filename_, &error_msg) < 0) {
+      LOG(WARNING) << "Failed to prefetch startup pages: " << error_msg;
+    }
+  }
+
   // Fetch the resolved classes for the app images after sleeping for
   // options_.GetSaveResolvedClassesDelayMs().
   // TODO(calin) This only considers the case of the primary profile file.
@@ -143,6 +155,13 @@ void ProfileSaver::Run() {
   // TODO: We should use another thread to do this in case the profile saver is not running.
   Runtime::Current()->NotifyStartupCompleted();
 
+  if (options_.GetPrefetchStartupPages()) {
+    std::string error_msg;
+    if (!StartupPages::Record(startup_pages_filename_, &error_msg)) {
+      LOG(WARNING) << "Failed to record startup pages: " << error_msg;
+    }
+  }
+
   FetchAndCacheResolvedClassesAndMethods(/*startup=*/ true);
 
   // When we save without waiting for JIT notifications we use a simple
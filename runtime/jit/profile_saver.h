@@ -153,6 +153,8 @@ class ProfileSaver {
   uint64_t total_number_of_wake_ups_;
 
   const ProfileSaverOptions options_;
+  // Where the pages used during startup are recorded, next to the primary profile.
+  const std::string startup_pages_filename_;
   DISALLOW_COPY_AND_ASSIGN(ProfileSaver);
 };
 
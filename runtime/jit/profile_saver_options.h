@@ -43,7 +43,8 @@ struct ProfileSaverOptions {
     profile_path_(""),
     profile_boot_class_path_(false),
     profile_aot_code_(false),
-    wait_for_jit_notifications_to_save_(true) {}
+    wait_for_jit_notifications_to_save_(true),
+    prefetch_startup_pages_(false) {}
 
   ProfileSaverOptions(
       bool enabled,
@@ -69,7 +70,8 @@ struct ProfileSaverOptions {
     profile_path_(profile_path),
     profile_boot_class_path_(profile_boot_class_path),
     profile_aot_code_(profile_aot_code),
-    wait_for_jit_notifications_to_save_(wait_for_jit_notifications_to_save) {}
+    wait_for_jit_notifications_to_save_(wait_for_jit_notifications_to_save),
+    prefetch_startup_pages_(false) {}
 
   bool IsEnabled() const {
     return enabled_;
@@ -121,6 +123,9 @@ struct ProfileSaverOptions {
   void SetWaitForJitNotificationsToSave(bool value) {
     wait_for_jit_notifications_to_save_ = value;
   }
+  bool GetPrefetchStartupPages() const {
+    return prefetch_startup_pages_;
+  }
 
   friend std::ostream & operator<<(std::ostream &os, const ProfileSaverOptions& pso) {
     os << "enabled_" << pso.enabled_
@@ -133,7 +138,8 @@ struct ProfileSaverOptions {
         << ", max_notification_before_wake_" << pso.max_notification_before_wake_
         << ", profile_boot_class_path_" << pso.profile_boot_class_path_
         << ", profile_aot_code_" << pso.profile_aot_code_
-        << ", wait_for_jit_notifications_to_save_" << pso.wait_for_jit_notifications_to_save_;
+        << ", wait_for_jit_notifications_to_save_" << pso.wait_for_jit_notifications_to_save_
+        << ", prefetch_startup_pages_" << pso.prefetch_startup_pages_;
     return os;
   }
 
@@ -151,6 +157,9 @@ struct ProfileSaverOptions {
   bool profile_boot_class_path_;
   bool profile_aot_code_;
   bool wait_for_jit_notifications_to_save_;
+  // Record the pages of compiled code and image files used during startup, and prefetch
+  // them on the next start.
+  bool prefetch_startup_pages_;
 };
 
 }  // namespace art
@@ -0,0 +1,267 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "startup_pages.h"
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "android-base/file.h"
+#include "android-base/stringprintf.h"
+#include "android-base/strings.h"
+#include "android-base/unique_fd.h"
+
+#include "base/bit_utils.h"
+#include "base/globals.h"
+#include "base/logging.h"  // For VLOG.
+#include "base/systrace.h"
+
+namespace art {
+
+using android::base::StringPrintf;
+
+// Upper bound on the amount of data prefetched, in case the record is stale or was
+// written by a process which had most of its files resident.
+static constexpr uint64_t kMaxPrefetchBytes = 128 * MB;
+
+// A range of a file, in bytes.
+using FileRange = std::pair<uint64_t, uint64_t>;
+
+struct FileIdentity {
+  uint64_t size;
+  int64_t mtime_ns;
+};
+
+static bool IsRecordedFile(const std::string& path) {
+  return android::base::EndsWith(path, ".oat") ||
+      android::base::EndsWith(path, ".odex") ||
+      android::base::EndsWith(path, ".vdex") ||
+      android::base::EndsWith(path, ".art");
+}
+
+static bool GetFileIdentity(int fd, /*out*/ FileIdentity* identity) {
+  struct stat sbuf;
+  if (fstat(fd, &sbuf) != 0 || !S_ISREG(sbuf.st_mode)) {
+    return false;
+  }
+  identity->size = static_cast<uint64_t>(sbuf.st_size);
+  identity->mtime_ns =
+      static_cast<int64_t>(sbuf.st_mtim.tv_sec) * 1000000000 + sbuf.st_mtim.tv_nsec;
+  return true;
+}
+
+// Returns whether a /proc/self/pagemap entry describes a page cache page mapped by this
+// process. Only a fault in this process (or fault-around next to one) maps a page of a
+// read-only file mapping; fork() does not copy such entries from the zygote. Anonymous
+// pages, such as the relocated parts of an image, cannot be prefetched from the file.
+static bool IsMappedFilePage(uint64_t entry) {
+  static constexpr uint64_t kPageMapPresent = UINT64_C(1) << 63;
+  static constexpr uint64_t kPageMapFileOrSharedAnon = UINT64_C(1) << 61;
+  return (entry & (kPageMapPresent | kPageMapFileOrSharedAnon)) ==
+      (kPageMapPresent | kPageMapFileOrSharedAnon);
+}
+
+// Sorts `ranges` and merges overlapping and adjacent ones.
+static void MergeRanges(std::vector<FileRange>* ranges) {
+  std::sort(ranges->begin(), ranges->end());
+  std::vector<FileRange> merged;
+  for (const FileRange& range : *ranges) {
+    if (!merged.empty() && merged.back().first + merged.back().second >= range.first) {
+      uint64_t end = std::max(merged.back().first + merged.back().second,
+                              range.first + range.second);
+      merged.back().second = end - merged.back().first;
+    } else {
+      merged.push_back(range);
+    }
+  }
+  ranges->swap(merged);
+}
+
+bool StartupPages::Record(const std::string& filename, std::string* error_msg) {
+  ScopedTrace trace("StartupPages::Record");
+  std::string maps;
+  if (!android::base::ReadFileToString("/proc/self/maps", &maps)) {
+    *error_msg = StringPrintf("Failed to read /proc/self/maps: %s", strerror(errno));
+    return false;
+  }
+
+  // Use the page tables of this process rather than mincore(), which reports page cache
+  // residency: pages read by other processes, or read into the cache by Prefetch() and
+  // never used, would otherwise be recorded and prefetched again on every start.
+  android::base::unique_fd pagemap_fd(open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC));
+  if (pagemap_fd.get() < 0) {
+    *error_msg = StringPrintf("Failed to open /proc/self/pagemap: %s", strerror(errno));
+    return false;
+  }
+
+  std::map<std::string, std::vector<FileRange>> resident_ranges;
+  std::vector<uint64_t> entries;
+  for (const std::string& line : android::base::Split(maps, "\n")) {
+    // Format: <begin>-<end> <perms> <offset> <dev> <inode> <path>
+    uintptr_t begin;
+    uintptr_t end;
+    uint64_t offset;
+    int path_index = 0;
+    if (sscanf(line.c_str(),
+               "%" SCNxPTR "-%" SCNxPTR " %*s %" SCNx64 " %*s %*u %n",
+               &begin,
+               &end,
+               &offset,
+               &path_index) != 3 ||
+        path_index == 0) {
+      continue;
+    }
+    std::string path = line.substr(path_index);
+    if (!IsRecordedFile(path) || !IsAligned<kPageSize>(begin) || end <= begin) {
+      // Not a file we prefetch, or the file has been deleted since it was mapped.
+      continue;
+    }
+    size_t num_pages = (end - begin) / kPageSize;
+    entries.resize(num_pages);
+    if (!android::base::ReadFullyAtOffset(pagemap_fd.get(),
+                                          entries.data(),
+                                          num_pages * sizeof(uint64_t),
+                                          (begin / kPageSize) * sizeof(uint64_t))) {
+      continue;
+    }
+    std::vector<FileRange>& ranges = resident_ranges[path];
+    for (size_t i = 0; i != num_pages;) {
+      if (!IsMappedFilePage(entries[i])) {
+        ++i;
+        continue;
+      }
+      size_t first = i;
+      while (i != num_pages && IsMappedFilePage(entries[i])) {
+        ++i;
+      }
+      ranges.emplace_back(offset + first * kPageSize, (i - first) * kPageSize);
+    }
+  }
+
+  std::string record;
+  for (auto& entry : resident_ranges) {
+    const std::string& path = entry.first;
+    std::vector<FileRange>& ranges = entry.second;
+    if (ranges.empty()) {
+      continue;
+    }
+    android::base::unique_fd fd(open(path.c_str(), O_RDONLY | O_CLOEXEC));
+    FileIdentity identity;
+    if (fd.get() < 0 || !GetFileIdentity(fd.get(), &identity)) {
+      continue;
+    }
+    MergeRanges(&ranges);
+    record += StringPrintf("F %" PRIu64 " %" PRId64 " %s\n",
+                           identity.size,
+                           identity.mtime_ns,
+                           path.c_str());
+    for (const FileRange& range : ranges) {
+      record += StringPrintf("R %" PRIu64 " %" PRIu64 "\n", range.first, range.second);
+    }
+  }
+
+  // Write to a temporary file first so that a concurrent Prefetch() never sees a
+  // partial record.
+  std::string temp_filename = filename + ".tmp";
+  if (!android::base::WriteStringToFile(record, temp_filename)) {
+    *error_msg = StringPrintf("Failed to write %s: %s", temp_filename.c_str(), strerror(errno));
+    unlink(temp_filename.c_str());
+    return false;
+  }
+  if (rename(temp_filename.c_str(), filename.c_str()) != 0) {
+    *error_msg = StringPrintf("Failed to rename %s to %s: %s",
+                              temp_filename.c_str(),
+                              filename.c_str(),
+                              strerror(errno));
+    unlink(temp_filename.c_str());
+    return false;
+  }
+  VLOG(profiler) << "Recorded startup pages of " << resident_ranges.size() << " files in "
+                 << filename;
+  return true;
+}
+
+int64_t StartupPages::Prefetch(const std::string& filename, std::string* error_msg) {
+  ScopedTrace trace("StartupPages::Prefetch");
+  std::string record;
+  if (!android::base::ReadFileToString(filename, &record)) {
+    *error_msg = StringPrintf("Failed to read %s: %s", filename.c_str(), strerror(errno));
+    return -1;
+  }
+
+  uint64_t total_bytes = 0u;
+  android::base::unique_fd fd;
+  for (const std::string& line : android::base::Split(record, "\n")) {
+    if (android::base::StartsWith(line, "F ")) {
+      FileIdentity expected;
+      int path_index = 0;
+      fd.reset();
+      if (sscanf(line.c_str(),
+                 "F %" SCNu64 " %" SCNd64 " %n",
+                 &expected.size,
+                 &expected.mtime_ns,
+                 &path_index) != 2 ||
+          path_index == 0) {
+        *error_msg = StringPrintf("Malformed line in %s: '%s'", filename.c_str(), line.c_str());
+        return -1;
+      }
+      std::string path = line.substr(path_index);
+      fd.reset(open(path.c_str(), O_RDONLY | O_CLOEXEC));
+      FileIdentity actual;
+      if (fd.get() >= 0 &&
+          (!GetFileIdentity(fd.get(), &actual) ||
+           actual.size != expected.size ||
+           actual.mtime_ns != expected.mtime_ns)) {
+        VLOG(profiler) << "Not prefetching " << path << " which changed since it was recorded";
+        fd.reset();
+      }
+    } else if (android::base::StartsWith(line, "R ")) {
+      uint64_t offset;
+      uint64_t length;
+      if (sscanf(line.c_str(), "R %" SCNu64 " %" SCNu64, &offset, &length) != 2) {
+        *error_msg = StringPrintf("Malformed line in %s: '%s'", filename.c_str(), line.c_str());
+        return -1;
+      }
+      length = std::min(length, kMaxPrefetchBytes - total_bytes);
+      if (fd.get() < 0 || length == 0u) {
+        // A length of zero would make posix_fadvise() apply to the rest of the file.
+        continue;
+      }
+      // This only starts the reads; the kernel fills the page cache asynchronously.
+      if (posix_fadvise(fd.get(), offset, length, POSIX_FADV_WILLNEED) == 0) {
+        total_bytes += length;
+      }
+      if (total_bytes == kMaxPrefetchBytes) {
+        break;
+      }
+    } else if (!line.empty()) {
+      *error_msg = StringPrintf("Malformed line in %s: '%s'", filename.c_str(), line.c_str());
+      return -1;
+    }
+  }
+  VLOG(profiler) << "Prefetched " << total_bytes << " bytes of startup pages from " << filename;
+  return static_cast<int64_t>(total_bytes);
+}
+
+}  // namespace art
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_JIT_STARTUP_PAGES_H_
+#define ART_RUNTIME_JIT_STARTUP_PAGES_H_
+
+#include <string>
+
+#include "base/macros.h"
+
+namespace art {
+
+// Records which pages of the oat, odex, vdex and art files mapped by the process have been
+// accessed by the process once startup has completed, so that the next start can read exactly those
+// ranges into the page cache ahead of use instead of taking major page faults on them.
+//
+// The record is a text file. Each mapped file is described by a line
+//   F <size> <mtime in ns> <path>
+// followed by one line per accessed range of the file
+//   R <offset> <length>
+class StartupPages {
+ public:
+  // Suffix appended to the profile file name to get the file holding the record.
+  static constexpr const char* kFileSuffix = ".pages";
+
+  // Writes the ranges of the files currently mapped by the process which are present in
+  // its page tables to `filename`. Pages which are merely in the page cache, including
+  // those read ahead by Prefetch() but never used, are not recorded.
+  static bool Record(const std::string& filename, std::string* error_msg);
+
+  // Asks the kernel to read the ranges recorded in `filename` into the page cache. Files
+  // which changed since the record was written are skipped. Returns the number of bytes
+  // requested, or -1 on error.
+  static int64_t Prefetch(const std::string& filename, std::string* error_msg);
+
+ private:
+  DISALLOW_IMPLICIT_CONSTRUCTORS(StartupPages);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_JIT_STARTUP_PAGES_H_
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "startup_pages.h"
+
+#include <inttypes.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <utility>
+#include <vector>
+
+#include "android-base/file.h"
+#include "android-base/stringprintf.h"
+#include "android-base/strings.h"
+
+#include "base/globals.h"
+#include "common_runtime_test.h"
+
+namespace art {
+
+class StartupPagesTest : public CommonRuntimeTest {};
+
+TEST_F(StartupPagesTest, RecordAndPrefetch) {
+  ScratchFile record_file;
+  std::string error_msg;
+  // The runtime has the boot image and its oat files mapped.
+  ASSERT_TRUE(StartupPages::Record(record_file.GetFilename(), &error_msg)) << error_msg;
+  std::string record;
+  ASSERT_TRUE(android::base::ReadFileToString(record_file.GetFilename(), &record));
+  EXPECT_TRUE(android::base::StartsWith(record, "F ")) << record;
+  EXPECT_GT(StartupPages::Prefetch(record_file.GetFilename(), &error_msg), 0) << error_msg;
+}
+
+TEST_F(StartupPagesTest, RecordsOnlyAccessedPages) {
+  static constexpr size_t kNumPages = 256u;
+  ScratchFile base_file;
+  ScratchFile data_file(base_file, ".vdex");
+  // Writing the file leaves all of its pages in the page cache.
+  std::vector<uint8_t> data(kNumPages * kPageSize, 1u);
+  ASSERT_TRUE(data_file.GetFile()->WriteFully(data.data(), data.size()));
+  ASSERT_EQ(0, data_file.GetFile()->Flush());
+  void* map = mmap(nullptr, data.size(), PROT_READ, MAP_PRIVATE, data_file.GetFd(), 0);
+  ASSERT_NE(MAP_FAILED, map);
+  const volatile uint8_t* pages = reinterpret_cast<const volatile uint8_t*>(map);
+  EXPECT_EQ(1u, pages[0]);
+  EXPECT_EQ(1u, pages[(kNumPages - 1u) * kPageSize]);
+
+  ScratchFile record_file;
+  std::string error_msg;
+  ASSERT_TRUE(StartupPages::Record(record_file.GetFilename(), &error_msg)) << error_msg;
+  munmap(map, data.size());
+  std::string record;
+  ASSERT_TRUE(android::base::ReadFileToString(record_file.GetFilename(), &record));
+
+  std::vector<std::pair<uint64_t, uint64_t>> ranges;
+  bool in_data_file = false;
+  for (const std::string& line : android::base::Split(record, "\n")) {
+    if (android::base::StartsWith(line, "F ")) {
+      in_data_file = android::base::EndsWith(line, " " + data_file.GetFilename());
+    } else if (in_data_file && android::base::StartsWith(line, "R ")) {
+      uint64_t offset;
+      uint64_t length;
+      ASSERT_EQ(2, sscanf(line.c_str(), "R %" SCNu64 " %" SCNu64, &offset, &length));
+      ranges.emplace_back(offset, length);
+    }
+  }
+  auto is_recorded = [&](uint64_t page) {
+    uint64_t offset = page * kPageSize;
+    for (const auto& range : ranges) {
+      if (offset >= range.first && offset - range.first < range.second) {
+        return true;
+      }
+    }
+    return false;
+  };
+  EXPECT_TRUE(is_recorded(0u)) << record;
+  EXPECT_TRUE(is_recorded(kNumPages - 1u)) << record;
+  // The middle of the file is resident but was not accessed, and is further from the
+  // accessed pages than the kernel maps around a fault.
+  for (uint64_t page = kNumPages / 2u - 32u; page != kNumPages / 2u + 32u; ++page) {
+    EXPECT_FALSE(is_recorded(page)) << page << "\n" << record;
+  }
+}
+
+TEST_F(StartupPagesTest, SkipsEmptyRanges) {
+  ScratchFile data_file;
+  std::vector<uint8_t> data(4u * kPageSize, 1u);
+  ASSERT_TRUE(data_file.GetFile()->WriteFully(data.data(), data.size()));
+  ASSERT_EQ(0, data_file.GetFile()->Flush());
+  struct stat sbuf;
+  ASSERT_EQ(0, fstat(data_file.GetFd(), &sbuf));
+  int64_t mtime_ns =
+      static_cast<int64_t>(sbuf.st_mtim.tv_sec) * 1000000000 + sbuf.st_mtim.tv_nsec;
+  ScratchFile record_file;
+  std::string record = android::base::StringPrintf(
+      "F %zu %" PRId64 " %s\nR 0 0\nR %zu %zu\n",
+      data.size(),
+      mtime_ns,
+      data_file.GetFilename().c_str(),
+      kPageSize,
+      kPageSize);
+  ASSERT_TRUE(android::base::WriteStringToFile(record, record_file.GetFilename()));
+  std::string error_msg;
+  // Only the non-empty range is requested, not the whole file.
+  EXPECT_EQ(static_cast<int64_t>(kPageSize),
+            StartupPages::Prefetch(record_file.GetFilename(), &error_msg)) << error_msg;
+}
+
+TEST_F(StartupPagesTest, SkipsChangedFiles) {
+  ScratchFile data_file;
+  ScratchFile record_file;
+  std::string record = android::base::StringPrintf(
+      "F 1 0 %s\nR 0 4096\n", data_file.GetFilename().c_str());
+  ASSERT_TRUE(android::base::WriteStringToFile(record, record_file.GetFilename()));
+  std::string error_msg;
+  EXPECT_EQ(0, StartupPages::Prefetch(record_file.GetFilename(), &error_msg)) << error_msg;
+}
+
+TEST_F(StartupPagesTest, RejectsMalformedRecord) {
+  ScratchFile record_file;
+  ASSERT_TRUE(android::base::WriteStringToFile("X 1 2\n", record_file.GetFilename()));
+  std::string error_msg;
+  EXPECT_EQ(-1, StartupPages::Prefetch(record_file.GetFilename(), &error_msg));
+  EXPECT_FALSE(error_msg.empty());
+}
+
+}  // namespace art
@@ -16,11 +16,21 @@
 
 #include "linear_alloc.h"
 
+#include <algorithm>
+#include <atomic>
+
+#include "base/bit_utils.h"
+#include "base/memory_tool.h"
 #include "thread-current-inl.h"
 
 namespace art {
 
-LinearAlloc::LinearAlloc(ArenaPool* pool) : lock_("linear alloc"), allocator_(pool) {
+static std::atomic<uint64_t> gNextLinearAllocId(1u);
+
+LinearAlloc::LinearAlloc(ArenaPool* pool)
+    : lock_("linear alloc"),
+      allocator_(pool),
+      id_(gNextLinearAllocId.fetch_add(1u, std::memory_order_relaxed)) {
 }
 
 void* LinearAlloc::Realloc(Thread* self, void* ptr, size_t old_size, size_t new_size) {
@@ -29,15 +39,61 @@ void* LinearAlloc::Realloc(Thread* self, void* ptr, size_t old_size, size_t new_
 }
 
 void* LinearAlloc::Alloc(Thread* self, size_t size) {
+  // Keep the red zones the arena allocator adds between allocations when running on a
+  // memory tool.
+  if (self != nullptr && size <= kMaxThreadLocalAllocSize && !kRunningOnMemoryTool) {
+    return AllocThreadLocal(self, size, ArenaAllocator::kAlignment);
+  }
   MutexLock mu(self, lock_);
   return allocator_.Alloc(size);
 }
 
 void* LinearAlloc::AllocAlign16(Thread* self, size_t size) {
+  if (self != nullptr && size <= kMaxThreadLocalAllocSize && !kRunningOnMemoryTool) {
+    return AllocThreadLocal(self, size, 16u);
+  }
   MutexLock mu(self, lock_);
   return allocator_.AllocAlign16(size);
 }
 
+void* LinearAlloc::AllocThreadLocal(Thread* self, size_t size, size_t alignment) {
+  DCHECK_LE(size, kMaxThreadLocalAllocSize);
+  size = RoundUp(size, ArenaAllocator::kAlignment);
+  Thread::LinearAllocChunk* const chunks = self->linear_alloc_chunks_;
+  constexpr size_t kNumChunks = Thread::kNumLinearAllocChunks;
+  if (UNLIKELY(chunks[0].owner_id != id_)) {
+    // Move this allocator's chunk to the front. If the thread has none, reuse the least
+    // recently used entry. Its tail is abandoned, which only happens when the thread
+    // alternates between more allocators than it keeps chunks for.
+    size_t index = 1u;
+    while (index != kNumChunks && chunks[index].owner_id != id_) {
+      ++index;
+    }
+    index = std::min(index, kNumChunks - 1u);
+    std::rotate(chunks, chunks + index, chunks + index + 1u);
+  }
+  Thread::LinearAllocChunk& current = chunks[0];
+  if (LIKELY(current.owner_id == id_)) {
+    uint8_t* pos = AlignUp(current.pos, alignment);
+    if (pos <= current.end && static_cast<size_t>(current.end - pos) >= size) {
+      current.pos = pos + size;
+      return pos;
+    }
+  }
+  // Start a new chunk. What is left of this allocator's previous chunk, if any, is too
+  // small for this request, so less than kMaxThreadLocalAllocSize is wasted.
+  uint8_t* chunk;
+  {
+    MutexLock mu(self, lock_);
+    chunk = reinterpret_cast<uint8_t*>(allocator_.AllocAlign16(kThreadLocalChunkSize));
+  }
+  DCHECK_ALIGNED_PARAM(reinterpret_cast<uintptr_t>(chunk), alignment);
+  current.owner_id = id_;
+  current.pos = chunk + size;
+  current.end = chunk + kThreadLocalChunkSize;
+  return chunk;
+}
+
 size_t LinearAlloc::GetUsedMemory() const {
   MutexLock mu(Thread::Current(), lock_);
   return allocator_.BytesUsed();
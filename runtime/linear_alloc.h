@@ -25,6 +25,12 @@ namespace art {
 class ArenaPool;
 
 // TODO: Support freeing if we add poor man's class unloading.
+//
+// Small allocations are bump-allocated without locking from a chunk that the allocating
+// thread carved out of the shared ArenaAllocator, so threads linking classes in parallel
+// do not serialize on `lock_`. The chunks are arena memory, so Contains() covers them.
+// Each thread keeps a chunk for each of the last few allocators it used, so switching
+// between class loaders does not abandon the rest of a chunk.
 class LinearAlloc {
  public:
   explicit LinearAlloc(ArenaPool* pool);
@@ -41,7 +47,8 @@ class LinearAlloc {
     return reinterpret_cast<T*>(Alloc(self, elements * sizeof(T)));
   }
 
-  // Return the number of bytes used in the allocator.
+  // Return the number of bytes used in the allocator, including the unused parts of the
+  // chunks handed out to threads.
   size_t GetUsedMemory() const REQUIRES(!lock_);
 
   ArenaPool* GetArenaPool() REQUIRES(!lock_);
@@ -54,9 +61,21 @@ class LinearAlloc {
   bool ContainsUnsafe(void* ptr) const NO_THREAD_SAFETY_ANALYSIS;
 
  private:
+  // Size of the chunks from which threads allocate without locking.
+  static constexpr size_t kThreadLocalChunkSize = 4 * KB;
+  // Larger allocations are made directly from `allocator_`, so that a chunk is never
+  // abandoned with a large unused tail.
+  static constexpr size_t kMaxThreadLocalAllocSize = 256;
+
+  void* AllocThreadLocal(Thread* self, size_t size, size_t alignment) REQUIRES(!lock_);
+
   mutable Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
   ArenaAllocator allocator_ GUARDED_BY(lock_);
 
+  // Identifies the owner of a thread's chunk. Unlike the address of the LinearAlloc, this
+  // is never reused, so a chunk of a deleted allocator cannot be taken for one of this.
+  const uint64_t id_;
+
   DISALLOW_IMPLICIT_CONSTRUCTORS(LinearAlloc);
 };
 
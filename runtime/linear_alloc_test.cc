@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "linear_alloc.h"
+
+#include <memory>
+
+#include "base/bit_utils.h"
+#include "common_runtime_test.h"
+#include "thread-current-inl.h"
+
+namespace art {
+
+class LinearAllocTest : public CommonRuntimeTest {};
+
+TEST_F(LinearAllocTest, InterleavedAllocators) {
+  Thread* self = Thread::Current();
+  Runtime* runtime = Runtime::Current();
+  std::unique_ptr<LinearAlloc> first(runtime->CreateLinearAlloc());
+  std::unique_ptr<LinearAlloc> second(runtime->CreateLinearAlloc());
+  uint8_t* last_first = nullptr;
+  for (size_t i = 0; i != 1000u; ++i) {
+    size_t size = 1u + (i * 37u) % 300u;
+    uint8_t* a = reinterpret_cast<uint8_t*>(first->Alloc(self, size));
+    uint8_t* b = reinterpret_cast<uint8_t*>(second->AllocAlign16(self, RoundUp(size, 16u)));
+    EXPECT_TRUE(IsAligned<ArenaAllocator::kAlignment>(a));
+    EXPECT_TRUE(IsAligned<16u>(b));
+    EXPECT_TRUE(first->Contains(a));
+    EXPECT_FALSE(first->Contains(b));
+    EXPECT_TRUE(second->Contains(b));
+    EXPECT_FALSE(second->Contains(a));
+    // Memory is zeroed and not handed out twice.
+    for (size_t j = 0; j != size; ++j) {
+      ASSERT_EQ(0u, a[j]);
+      a[j] = 0xffu;
+    }
+    EXPECT_NE(a, last_first);
+    last_first = a;
+  }
+  // A new allocator, possibly at the address of a deleted one, does not reuse its chunk.
+  first.reset(runtime->CreateLinearAlloc());
+  void* c = first->Alloc(self, 8u);
+  EXPECT_TRUE(first->Contains(c));
+  EXPECT_EQ(0u, *reinterpret_cast<uint64_t*>(c));
+}
+
+TEST_F(LinearAllocTest, InterleavedAllocatorsUsedMemory) {
+  // On memory tools, allocations are not made from thread-local chunks and have red zones.
+  TEST_DISABLED_FOR_MEMORY_TOOL();
+  Thread* self = Thread::Current();
+  Runtime* runtime = Runtime::Current();
+  // A thread keeps a chunk for each of up to four allocators.
+  constexpr size_t kNumAllocators = 4u;
+  std::unique_ptr<LinearAlloc> allocators[kNumAllocators];
+  size_t initial_used[kNumAllocators];
+  for (size_t i = 0; i != kNumAllocators; ++i) {
+    allocators[i].reset(runtime->CreateLinearAlloc());
+    initial_used[i] = allocators[i]->GetUsedMemory();
+  }
+  size_t requested = 0u;
+  for (size_t i = 0; i != 1000u; ++i) {
+    size_t size = 8u + (i * 37u) % 100u;
+    requested += RoundUp(size, ArenaAllocator::kAlignment);
+    for (std::unique_ptr<LinearAlloc>& allocator : allocators) {
+      EXPECT_TRUE(allocator->Contains(allocator->Alloc(self, size)));
+    }
+  }
+  for (size_t i = 0; i != kNumAllocators; ++i) {
+    // Each allocator carved out just enough 4KiB chunks for its allocations, less the
+    // small tails left when a request did not fit. Abandoning a chunk on every switch
+    // between allocators would have used 4KiB per allocation.
+    size_t used = allocators[i]->GetUsedMemory() - initial_used[i];
+    EXPECT_GE(used, requested);
+    EXPECT_LE(used, requested + requested / 16u + 4 * KB) << i;
+  }
+}
+
+}  // namespace art
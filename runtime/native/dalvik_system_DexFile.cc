@@ -379,6 +379,8 @@ static jboolean DexFile_closeDexFile(JNIEnv* env, jclass, jobject cookie) {
   }
   Runtime* const runtime = Runtime::Current();
   bool all_deleted = true;
+  // Do not verify dex files in the background if they may be deleted below.
+  runtime->GetOatFileManager().CancelBackgroundVerification(dex_files);
   // We need to clear the caches since they may contain pointers to the dex instructions.
   // Different dex file can be loaded at the same memory location later by chance.
   Thread::ClearAllInterpreterCaches();
@@ -16,6 +16,8 @@
 
 #include "oat_file_manager.h"
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
 #include <queue>
 #include <vector>
@@ -23,6 +25,7 @@
 
 #include "android-base/stringprintf.h"
 #include "android-base/strings.h"
+#include "nativehelper/scoped_local_ref.h"
 
 #include "art_field-inl.h"
 #include "base/bit_vector-inl.h"
@@ -151,7 +154,9 @@ const OatFile* OatFileManager::GetPrimaryOatFile() const {
 }
 
 OatFileManager::OatFileManager()
-    : only_use_system_oat_files_(false) {}
+    : only_use_system_oat_files_(false),
+      verification_thread_pool_lock_("Verification thread pool lock", kRuntimeThreadPoolLock),
+      num_pending_background_verifications_(0u) {}
 
 OatFileManager::~OatFileManager() {
   // Explicitly clear oat_files_ since the OatFile destructor calls back into OatFileManager for
@@ -644,6 +649,28 @@ std::vector<std::unique_ptr<const DexFile>> OatFileManager::OpenDexFilesFromOat(
       error_msgs->push_back("No original dex files found for dex location "
           + std::string(dex_location));
     }
+
+    // Without an oat or vdex file, all classes would be verified at runtime on first use.
+    // Reuse the verification results of a previous run if a background verification left
+    // an anonymous vdex for these dex files, otherwise schedule such a verification for
+    // when the class loader starts using them.
+    if (!dex_files.empty() &&
+        context != nullptr &&
+        !runtime->IsAotCompiler() &&
+        !only_use_system_oat_files_ &&
+        context->OpenDexFiles(kRuntimeISA, /* classpath_dir= */ "")) {
+      std::vector<const DexFile*> opened_dex_files = MakeNonOwningPointerVector(dex_files);
+      const OatFile* vdex_oat_file = OpenAnonymousVdexForDexFiles(opened_dex_files, *context);
+      if (vdex_oat_file != nullptr) {
+        *out_oat_file = vdex_oat_file;
+      } else {
+        WriterMutexLock mu(self, *Locks::oat_file_manager_lock_);
+        pending_background_verifications_.push_back(PendingBackgroundVerification {
+            opened_dex_files, context->EncodeContextForOatFile(/* base_dir= */ "") });
+        num_pending_background_verifications_.store(pending_background_verifications_.size(),
+                                                    std::memory_order_release);
+      }
+    }
   }
 
   if (Runtime::Current()->GetJit() != nullptr) {
@@ -675,6 +702,54 @@ static std::vector<const DexFile::Header*> GetDexFileHeaders(
   return headers;
 }
 
+const OatFile* OatFileManager::OpenAnonymousVdexForDexFiles(
+    const std::vector<const DexFile*>& dex_files,
+    const ClassLoaderContext& context) {
+  const std::vector<const DexFile::Header*> dex_headers = GetDexFileHeaders(dex_files);
+
+  uint32_t location_checksum;
+  std::string dex_location;
+  std::string vdex_path;
+  if (!OatFileAssistant::AnonymousDexVdexLocation(dex_headers,
+                                                  kRuntimeISA,
+                                                  &location_checksum,
+                                                  &dex_location,
+                                                  &vdex_path) ||
+      !OS::FileExists(vdex_path.c_str())) {
+    return nullptr;
+  }
+
+  std::string error_msg;
+  std::unique_ptr<VdexFile> vdex_file = VdexFile::Open(vdex_path,
+                                                       /* writable= */ false,
+                                                       /* low_4gb= */ false,
+                                                       /* unquicken= */ false,
+                                                       &error_msg);
+  if (vdex_file == nullptr) {
+    LOG(WARNING) << "Failed to open vdex " << vdex_path << ": " << error_msg;
+    return nullptr;
+  }
+  if (!vdex_file->MatchesDexFileChecksums(dex_headers)) {
+    LOG(WARNING) << "Failed to open vdex " << vdex_path << ": dex file checksum mismatch";
+    return nullptr;
+  }
+
+  // The vdex only records which classes were verified, so it is only valid against
+  // the boot class path and class loader context it was created with.
+  if (!vdex_file->MatchesBootClassPathChecksums() ||
+      !vdex_file->MatchesClassLoaderContext(context)) {
+    return nullptr;
+  }
+
+  std::unique_ptr<OatFile> oat_file(OatFile::OpenFromVdex(dex_files,
+                                                          std::move(vdex_file),
+                                                          dex_location));
+  DCHECK(oat_file != nullptr);
+  VLOG(class_linker) << "Registering " << oat_file->GetLocation()
+                     << " for " << dex_files[0]->GetLocation();
+  return RegisterOatFile(std::move(oat_file));
+}
+
 std::vector<std::unique_ptr<const DexFile>> OatFileManager::OpenDexFilesFromOat(
     std::vector<MemMap>&& dex_mem_maps,
     jobject class_loader,
@@ -868,77 +943,65 @@ static bool UnlinkLeastRecentlyUsedVdexIfNeeded(const std::string& vdex_path_to_
   return true;
 }
 
-class BackgroundVerificationTask final : public Task {
+// State shared by the tasks verifying a set of dex files in the background. Classes are
+// handed out to the tasks one at a time so that the work is spread evenly across the
+// verification threads, and the last task to finish writes the vdex file.
+class BackgroundVerificationJob {
  public:
-  BackgroundVerificationTask(const std::vector<const DexFile*>& dex_files,
-                             jobject class_loader,
-                             const char* class_loader_context,
-                             const std::string& vdex_path)
+  BackgroundVerificationJob(const std::vector<const DexFile*>& dex_files,
+                            jobject class_loader,
+                            const char* class_loader_context,
+                            const std::string& vdex_path,
+                            size_t num_tasks)
       : dex_files_(dex_files),
         class_loader_context_(class_loader_context),
-        vdex_path_(vdex_path) {
+        vdex_path_(vdex_path),
+        next_class_index_(0u),
+        remaining_tasks_(num_tasks),
+        verifier_deps_lock_("background verifier deps lock", kGenericBottomLock),
+        verifier_deps_(dex_files) {
     Thread* const self = Thread::Current();
     ScopedObjectAccess soa(self);
     // Create a global ref for `class_loader` because it will be accessed from a different thread.
     class_loader_ = soa.Vm()->AddGlobalRef(self, soa.Decode<mirror::ClassLoader>(class_loader));
     CHECK(class_loader_ != nullptr);
+
+    size_t num_classes = 0u;
+    for (const DexFile* dex_file : dex_files_) {
+      num_classes += dex_file->NumClassDefs();
+      class_index_ends_.push_back(num_classes);
+    }
   }
 
-  ~BackgroundVerificationTask() {
+  ~BackgroundVerificationJob() {
     Thread* const self = Thread::Current();
     ScopedObjectAccess soa(self);
     soa.Vm()->DeleteGlobalRef(self, class_loader_);
   }
 
-  void Run(Thread* self) override {
-    std::string error_msg;
-    ClassLinker* const class_linker = Runtime::Current()->GetClassLinker();
-    verifier::VerifierDeps verifier_deps(dex_files_);
-
-    // Iterate over all classes and verify them.
-    for (const DexFile* dex_file : dex_files_) {
-      for (uint32_t cdef_idx = 0; cdef_idx < dex_file->NumClassDefs(); cdef_idx++) {
-        const dex::ClassDef& class_def = dex_file->GetClassDef(cdef_idx);
-
-        // Take handles inside the loop. The background verification is low priority
-        // and we want to minimize the risk of blocking anyone else.
-        ScopedObjectAccess soa(self);
-        StackHandleScope<2> hs(self);
-        Handle<mirror::ClassLoader> h_loader(hs.NewHandle(
-            soa.Decode<mirror::ClassLoader>(class_loader_)));
-        Handle<mirror::Class> h_class(hs.NewHandle<mirror::Class>(class_linker->FindClass(
-            self,
-            dex_file->GetClassDescriptor(class_def),
-            h_loader)));
-
-        if (h_class == nullptr) {
-          CHECK(self->IsExceptionPending());
-          self->ClearException();
-          continue;
-        }
-
-        if (&h_class->GetDexFile() != dex_file) {
-          // There is a different class in the class path or a parent class loader
-          // with the same descriptor. This `h_class` is not resolvable, skip it.
-          continue;
-        }
-
-        CHECK(h_class->IsResolved()) << h_class->PrettyDescriptor();
-        class_linker->VerifyClass(self, h_class);
-        if (h_class->IsErroneous()) {
-          // ClassLinker::VerifyClass throws, which isn't useful here.
-          CHECK(soa.Self()->IsExceptionPending());
-          soa.Self()->ClearException();
-        }
-
-        CHECK(h_class->IsVerified() || h_class->IsErroneous())
-            << h_class->PrettyDescriptor() << ": state=" << h_class->GetStatus();
+  size_t GetNumberOfClasses() const {
+    return class_index_ends_.empty() ? 0u : class_index_ends_.back();
+  }
 
-        if (h_class->IsVerified()) {
-          verifier_deps.RecordClassVerified(*dex_file, class_def);
-        }
-      }
+  // Verify classes until all of them have been handed out. Returns true if this
+  // was the last of the job's tasks to finish.
+  bool VerifyClasses(Thread* self) {
+    const size_t num_classes = GetNumberOfClasses();
+    for (size_t index = next_class_index_.fetch_add(1u, std::memory_order_relaxed);
+         index < num_classes;
+         index = next_class_index_.fetch_add(1u, std::memory_order_relaxed)) {
+      auto it = std::upper_bound(class_index_ends_.begin(), class_index_ends_.end(), index);
+      DCHECK(it != class_index_ends_.end());
+      size_t dex_file_index = std::distance(class_index_ends_.begin(), it);
+      const DexFile* dex_file = dex_files_[dex_file_index];
+      size_t cdef_idx = index - (*it - dex_file->NumClassDefs());
+      VerifyClass(self, dex_file, dex_file->GetClassDef(cdef_idx));
     }
+    return remaining_tasks_.fetch_sub(1u, std::memory_order_acq_rel) == 1u;
+  }
+
+  void WriteVdex() {
+    std::string error_msg;
 
     // Delete old vdex files if there are too many in the folder.
     if (!UnlinkLeastRecentlyUsedVdexIfNeeded(vdex_path_, &error_msg)) {
@@ -946,10 +1009,11 @@ class BackgroundVerificationTask final : public Task {
       return;
     }
 
-    // Construct a vdex file and write `verifier_deps` into it.
+    // Construct a vdex file and write `verifier_deps` into it. All tasks have finished
+    // recording verified classes, so `verifier_deps_lock_` is not needed anymore.
     if (!VdexFile::WriteToDisk(vdex_path_,
                                dex_files_,
-                               verifier_deps,
+                               verifier_deps_,
                                class_loader_context_,
                                &error_msg)) {
       LOG(ERROR) << "Could not write anonymous vdex " << vdex_path_ << ": " << error_msg;
@@ -957,34 +1021,112 @@ class BackgroundVerificationTask final : public Task {
     }
   }
 
-  void Finalize() override {
-    delete this;
+ private:
+  void VerifyClass(Thread* self, const DexFile* dex_file, const dex::ClassDef& class_def) {
+    ClassLinker* const class_linker = Runtime::Current()->GetClassLinker();
+
+    // Take handles for each class. The background verification is low priority
+    // and we want to minimize the risk of blocking anyone else.
+    ScopedObjectAccess soa(self);
+    StackHandleScope<2> hs(self);
+    Handle<mirror::ClassLoader> h_loader(hs.NewHandle(
+        soa.Decode<mirror::ClassLoader>(class_loader_)));
+    Handle<mirror::Class> h_class(hs.NewHandle<mirror::Class>(class_linker->FindClass(
+        self,
+        dex_file->GetClassDescriptor(class_def),
+        h_loader)));
+
+    if (h_class == nullptr) {
+      CHECK(self->IsExceptionPending());
+      self->ClearException();
+      return;
+    }
+
+    if (&h_class->GetDexFile() != dex_file) {
+      // There is a different class in the class path or a parent class loader
+      // with the same descriptor. This `h_class` is not resolvable, skip it.
+      return;
+    }
+
+    CHECK(h_class->IsResolved()) << h_class->PrettyDescriptor();
+    class_linker->VerifyClass(self, h_class);
+    if (h_class->IsErroneous()) {
+      // ClassLinker::VerifyClass throws, which isn't useful here.
+      CHECK(soa.Self()->IsExceptionPending());
+      soa.Self()->ClearException();
+    }
+
+    CHECK(h_class->IsVerified() || h_class->IsErroneous())
+        << h_class->PrettyDescriptor() << ": state=" << h_class->GetStatus();
+
+    if (h_class->IsVerified()) {
+      MutexLock mu(self, verifier_deps_lock_);
+      verifier_deps_.RecordClassVerified(*dex_file, class_def);
+    }
   }
 
- private:
   const std::vector<const DexFile*> dex_files_;
   jobject class_loader_;
   const std::string class_loader_context_;
   const std::string vdex_path_;
 
-  DISALLOW_COPY_AND_ASSIGN(BackgroundVerificationTask);
+  // Exclusive end of the range of class indexes of each dex file, in `dex_files_` order.
+  std::vector<size_t> class_index_ends_;
+  std::atomic<size_t> next_class_index_;
+  std::atomic<size_t> remaining_tasks_;
+
+  // Serializes the recording of verified classes by the tasks.
+  Mutex verifier_deps_lock_;
+  verifier::VerifierDeps verifier_deps_;
+
+  DISALLOW_COPY_AND_ASSIGN(BackgroundVerificationJob);
 };
 
-void OatFileManager::RunBackgroundVerification(const std::vector<const DexFile*>& dex_files,
-                                               jobject class_loader,
-                                               const char* class_loader_context) {
-  Runtime* const runtime = Runtime::Current();
-  Thread* const self = Thread::Current();
+class BackgroundVerificationTask final : public Task {
+ public:
+  explicit BackgroundVerificationTask(const std::shared_ptr<BackgroundVerificationJob>& job)
+      : job_(job) {}
+
+  void Run(Thread* self) override {
+    if (job_->VerifyClasses(self)) {
+      job_->WriteVdex();
+    }
+  }
+
+  void Finalize() override {
+    delete this;
+  }
+
+ private:
+  // The job is deleted with its last task, releasing the class loader.
+  const std::shared_ptr<BackgroundVerificationJob> job_;
+
+  DISALLOW_COPY_AND_ASSIGN(BackgroundVerificationTask);
+};
 
+static bool CanRunBackgroundVerification(Runtime* runtime) {
   if (runtime->IsJavaDebuggable()) {
     // Threads created by ThreadPool ("runtime threads") are not allowed to load
     // classes when debuggable to match class-initialization semantics
     // expectations. Do not verify in the background.
-    return;
+    return false;
   }
 
   if (!IsSdkVersionSetAndAtLeast(runtime->GetTargetSdkVersion(), SdkVersion::kQ)) {
     // Do not run for legacy apps as they may depend on the previous class loader behaviour.
+    return false;
+  }
+
+  return true;
+}
+
+void OatFileManager::RunBackgroundVerification(const std::vector<const DexFile*>& dex_files,
+                                               jobject class_loader,
+                                               const char* class_loader_context) {
+  Runtime* const runtime = Runtime::Current();
+  Thread* const self = Thread::Current();
+
+  if (!CanRunBackgroundVerification(runtime)) {
     return;
   }
 
@@ -1001,36 +1143,116 @@ void OatFileManager::RunBackgroundVerification(const std::vector<const DexFile*>
                                                  &location_checksum,
                                                  &dex_location,
                                                  &vdex_path)) {
-    if (verification_thread_pool_ == nullptr) {
-      verification_thread_pool_.reset(
-          new ThreadPool("Verification thread pool", /* num_threads= */ 1));
-      verification_thread_pool_->StartWorkers(self);
+    // Split the work between as many tasks as there are verification threads. Each task
+    // verifies classes until none are left, so a slow class does not hold up the others.
+    size_t num_classes = 0u;
+    for (const DexFile* dex_file : dex_files) {
+      num_classes += dex_file->NumClassDefs();
     }
-    verification_thread_pool_->AddTask(self, new BackgroundVerificationTask(
+    const size_t num_threads = runtime->GetBackgroundVerificationThreads();
+    size_t num_tasks = std::max<size_t>(1u, std::min(num_threads, num_classes));
+    std::shared_ptr<BackgroundVerificationJob> job = std::make_shared<BackgroundVerificationJob>(
         dex_files,
         class_loader,
         class_loader_context,
-        vdex_path));
+        vdex_path,
+        num_tasks);
+
+    // Any thread registering a dex file may get here, so the pool is created and used
+    // under its lock. DeleteThreadPool() cannot free it while tasks are being added.
+    MutexLock mu(self, verification_thread_pool_lock_);
+    if (verification_thread_pool_ == nullptr) {
+      verification_thread_pool_.reset(new ThreadPool("Verification thread pool", num_threads));
+      verification_thread_pool_->StartWorkers(self);
+    }
+    for (size_t i = 0; i != num_tasks; ++i) {
+      verification_thread_pool_->AddTask(self, new BackgroundVerificationTask(job));
+    }
   }
 }
 
+void OatFileManager::MaybeRunBackgroundVerification(const DexFile& dex_file,
+                                                    ObjPtr<mirror::ClassLoader> class_loader) {
+  // This is called for every dex file registered without an oat file. Avoid the lock
+  // when nothing is pending or background verification is disabled in this process.
+  if (num_pending_background_verifications_.load(std::memory_order_acquire) == 0u ||
+      !CanRunBackgroundVerification(Runtime::Current())) {
+    return;
+  }
+
+  Thread* const self = Thread::Current();
+  PendingBackgroundVerification pending;
+  {
+    WriterMutexLock mu(self, *Locks::oat_file_manager_lock_);
+    auto it = std::find_if(pending_background_verifications_.begin(),
+                           pending_background_verifications_.end(),
+                           [&](const PendingBackgroundVerification& p) {
+                             return ContainsElement(p.dex_files, &dex_file);
+                           });
+    if (it == pending_background_verifications_.end()) {
+      return;
+    }
+    pending = std::move(*it);
+    pending_background_verifications_.erase(it);
+    num_pending_background_verifications_.store(pending_background_verifications_.size(),
+                                                 std::memory_order_release);
+  }
+
+  ScopedObjectAccess soa(self);
+  ScopedLocalRef<jobject> jclass_loader(soa.Env(), soa.AddLocalReference<jobject>(class_loader));
+  RunBackgroundVerification(pending.dex_files,
+                            jclass_loader.get(),
+                            pending.class_loader_context.c_str());
+}
+
+void OatFileManager::CancelBackgroundVerification(const std::vector<const DexFile*>& dex_files) {
+  WriterMutexLock mu(Thread::Current(), *Locks::oat_file_manager_lock_);
+  auto end = std::remove_if(pending_background_verifications_.begin(),
+                            pending_background_verifications_.end(),
+                            [&](const PendingBackgroundVerification& p) {
+                              return std::any_of(dex_files.begin(),
+                                                 dex_files.end(),
+                                                 [&](const DexFile* dex_file) {
+                                                   return ContainsElement(p.dex_files, dex_file);
+                                                 });
+                            });
+  pending_background_verifications_.erase(end, pending_background_verifications_.end());
+  num_pending_background_verifications_.store(pending_background_verifications_.size(),
+                                               std::memory_order_release);
+}
+
 void OatFileManager::WaitForWorkersToBeCreated() {
-  DCHECK(!Runtime::Current()->IsShuttingDown(Thread::Current()))
+  Thread* const self = Thread::Current();
+  DCHECK(!Runtime::Current()->IsShuttingDown(self))
       << "Cannot create new threads during runtime shutdown";
+  MutexLock mu(self, verification_thread_pool_lock_);
   if (verification_thread_pool_ != nullptr) {
     verification_thread_pool_->WaitForWorkersToBeCreated();
   }
 }
 
 void OatFileManager::DeleteThreadPool() {
-  verification_thread_pool_.reset(nullptr);
+  std::unique_ptr<ThreadPool> thread_pool;
+  {
+    MutexLock mu(Thread::Current(), verification_thread_pool_lock_);
+    thread_pool = std::move(verification_thread_pool_);
+  }
+  // Joining the workers can take a while, do it without holding the lock.
+  thread_pool.reset(nullptr);
 }
 
 void OatFileManager::WaitForBackgroundVerificationTasks() {
-  if (verification_thread_pool_ != nullptr) {
-    Thread* const self = Thread::Current();
-    verification_thread_pool_->WaitForWorkersToBeCreated();
-    verification_thread_pool_->Wait(self, /* do_work= */ true, /* may_hold_locks= */ false);
+  Thread* const self = Thread::Current();
+  ThreadPool* thread_pool;
+  {
+    MutexLock mu(self, verification_thread_pool_lock_);
+    thread_pool = verification_thread_pool_.get();
+  }
+  // The pool is only deleted on shutdown or before forking, neither of which can happen
+  // while a test waits for it. Tasks may take other locks, so wait without holding ours.
+  if (thread_pool != nullptr) {
+    thread_pool->WaitForWorkersToBeCreated();
+    thread_pool->Wait(self, /* do_work= */ true, /* may_hold_locks= */ false);
   }
 }
 
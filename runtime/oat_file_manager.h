@@ -17,6 +17,7 @@
 #ifndef ART_RUNTIME_OAT_FILE_MANAGER_H_
 #define ART_RUNTIME_OAT_FILE_MANAGER_H_
 
+#include <atomic>
 #include <memory>
 #include <set>
 #include <string>
@@ -25,7 +26,9 @@
 
 #include "base/locks.h"
 #include "base/macros.h"
+#include "base/mutex.h"
 #include "jni.h"
+#include "obj_ptr.h"
 
 namespace art {
 
@@ -35,6 +38,10 @@ class ImageSpace;
 }  // namespace space
 }  // namespace gc
 
+namespace mirror {
+class ClassLoader;
+}  // namespace mirror
+
 class ClassLoaderContext;
 class DexFile;
 class MemMap;
@@ -122,20 +129,37 @@ class OatFileManager {
 
   void SetOnlyUseSystemOatFiles(bool enforce, bool assert_no_files_loaded);
 
-  // Spawn a background thread which verifies all classes in the given dex files.
+  // Verify all classes in the given dex files on background threads. The number of threads
+  // is set by -Xbackground-verification-threads and defaults to one.
   void RunBackgroundVerification(const std::vector<const DexFile*>& dex_files,
                                  jobject class_loader,
-                                 const char* class_loader_context);
+                                 const char* class_loader_context)
+      REQUIRES(!verification_thread_pool_lock_);
+
+  // Called by the class linker when `dex_file` is registered with `class_loader`. If the
+  // dex file was opened from disk without an oat or vdex file, runs the background
+  // verification of all dex files opened with it, now that the class loader can resolve
+  // their classes. The resulting anonymous vdex is used by OpenDexFilesFromOat() the next
+  // time the same dex files are loaded in the same class loader context.
+  void MaybeRunBackgroundVerification(const DexFile& dex_file,
+                                      ObjPtr<mirror::ClassLoader> class_loader)
+      REQUIRES(!Locks::oat_file_manager_lock_, !verification_thread_pool_lock_)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
+  // Forget about a pending background verification involving any of `dex_files`.
+  // Must be called before the dex files are deleted.
+  void CancelBackgroundVerification(const std::vector<const DexFile*>& dex_files)
+      REQUIRES(!Locks::oat_file_manager_lock_);
 
   // Wait for thread pool workers to be created. This is used during shutdown as
   // threads are not allowed to attach while runtime is in shutdown lock.
-  void WaitForWorkersToBeCreated();
+  void WaitForWorkersToBeCreated() REQUIRES(!verification_thread_pool_lock_);
 
   // If allocated, delete a thread pool of background verification threads.
-  void DeleteThreadPool();
+  void DeleteThreadPool() REQUIRES(!verification_thread_pool_lock_);
 
   // Wait for all background verification tasks to finish. This is only used by tests.
-  void WaitForBackgroundVerificationTasks();
+  void WaitForBackgroundVerificationTasks() REQUIRES(!verification_thread_pool_lock_);
 
   // Maximum number of anonymous vdex files kept in the process' data folder.
   static constexpr size_t kAnonymousVdexCacheSize = 8u;
@@ -156,6 +180,13 @@ class OatFileManager {
       /*out*/ std::vector<std::string>* error_msgs)
       REQUIRES(!Locks::oat_file_manager_lock_, !Locks::mutator_lock_);
 
+  // Attempts to back `dex_files`, opened from disk without an oat or vdex file, with the
+  // anonymous vdex written by a background verification in a previous run. Returns the
+  // registered oat file, or null if there is no such vdex or it cannot be used.
+  const OatFile* OpenAnonymousVdexForDexFiles(const std::vector<const DexFile*>& dex_files,
+                                              const ClassLoaderContext& context)
+      REQUIRES(!Locks::oat_file_manager_lock_, !Locks::mutator_lock_);
+
   // Check that the class loader context of the given oat file matches the given context.
   // This will perform a check that all class loaders in the chain have the same type and
   // classpath.
@@ -188,8 +219,26 @@ class OatFileManager {
   // is not on /system, don't load it "executable".
   bool only_use_system_oat_files_;
 
-  // Single-thread pool used to run the verifier in the background.
-  std::unique_ptr<ThreadPool> verification_thread_pool_;
+  // Guards the creation and deletion of `verification_thread_pool_`, which is created on
+  // demand by whichever thread first registers a dex file that needs verifying.
+  Mutex verification_thread_pool_lock_;
+
+  // Thread pool used to run the verifier in the background.
+  std::unique_ptr<ThreadPool> verification_thread_pool_
+      GUARDED_BY(verification_thread_pool_lock_);
+
+  // Dex files opened from disk without an oat or vdex file, waiting to be registered
+  // with their class loader before they are verified in the background.
+  struct PendingBackgroundVerification {
+    std::vector<const DexFile*> dex_files;
+    std::string class_loader_context;
+  };
+  std::vector<PendingBackgroundVerification> pending_background_verifications_
+      GUARDED_BY(Locks::oat_file_manager_lock_);
+
+  // Number of entries in `pending_background_verifications_`. Lets the class linker skip
+  // the lock when registering dex files while nothing is pending, which is the common case.
+  std::atomic<size_t> num_pending_background_verifications_;
 
   DISALLOW_COPY_AND_ASSIGN(OatFileManager);
 };
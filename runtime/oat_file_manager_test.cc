@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "oat_file_manager.h"
+
+#include <sys/stat.h>
+
+#include <utility>
+
+#include "arch/instruction_set.h"
+#include "base/os.h"
+#include "base/sdk_version.h"
+#include "class_linker.h"
+#include "class_loader_context.h"
+#include "common_runtime_test.h"
+#include "dex/dex_file-inl.h"
+#include "handle_scope-inl.h"
+#include "mirror/class-inl.h"
+#include "mirror/class_loader.h"
+#include "oat_file_assistant.h"
+#include "runtime.h"
+#include "scoped_thread_state_change-inl.h"
+
+namespace art {
+
+class OatFileManagerTest : public CommonRuntimeTest {
+ protected:
+  void SetUpRuntimeOptions(RuntimeOptions* options) override {
+    // Use more threads than the test dex file has classes.
+    options->push_back(std::make_pair("-Xbackground-verification-threads:8", nullptr));
+  }
+
+  void SetUp() override {
+    CommonRuntimeTest::SetUp();
+    // Anonymous vdex files are written to the oat directory of the process' data folder.
+    data_dir_ = android_data_ + "/background_verification";
+    ASSERT_EQ(0, mkdir(data_dir_.c_str(), 0700));
+    ASSERT_EQ(0, mkdir((data_dir_ + "/oat").c_str(), 0700));
+    std::string oat_dir = data_dir_ + "/oat/" + GetInstructionSetString(kRuntimeISA);
+    ASSERT_EQ(0, mkdir(oat_dir.c_str(), 0700));
+    runtime_->SetProcessDataDirectory(data_dir_.c_str());
+  }
+
+  void TearDown() override {
+    runtime_->GetOatFileManager().WaitForBackgroundVerificationTasks();
+    ClearDirectory(data_dir_.c_str());
+    ASSERT_EQ(0, rmdir(data_dir_.c_str()));
+    CommonRuntimeTest::TearDown();
+  }
+
+  // Loads `dex_name` in a PathClassLoader and hands its dex files over to the background
+  // verification. Returns the class loader.
+  jobject VerifyInBackground(const char* dex_name) {
+    jobject class_loader;
+    std::string encoded_context;
+    {
+      ScopedObjectAccess soa(Thread::Current());
+      class_loader = LoadDex(dex_name);
+      std::unique_ptr<ClassLoaderContext> context =
+          ClassLoaderContext::CreateContextForClassLoader(class_loader, nullptr);
+      encoded_context = context->EncodeContextForOatFile(/* base_dir= */ "");
+    }
+    runtime_->GetOatFileManager().RunBackgroundVerification(
+        GetDexFiles(class_loader), class_loader, encoded_context.c_str());
+    return class_loader;
+  }
+
+  bool HasAnonymousVdex(jobject class_loader) {
+    std::vector<const DexFile::Header*> headers;
+    for (const DexFile* dex_file : GetDexFiles(class_loader)) {
+      headers.push_back(&dex_file->GetHeader());
+    }
+    uint32_t location_checksum;
+    std::string dex_location;
+    std::string vdex_filename;
+    return OatFileAssistant::AnonymousDexVdexLocation(headers,
+                                                      kRuntimeISA,
+                                                      &location_checksum,
+                                                      &dex_location,
+                                                      &vdex_filename) &&
+           OS::FileExists(vdex_filename.c_str());
+  }
+
+  // Returns the number of classes defined by the dex files of `class_loader`, and how
+  // many of them are verified.
+  std::pair<size_t, size_t> CountVerifiedClasses(jobject class_loader) {
+    ScopedObjectAccess soa(Thread::Current());
+    StackHandleScope<2> hs(soa.Self());
+    Handle<mirror::ClassLoader> h_loader(
+        hs.NewHandle(soa.Decode<mirror::ClassLoader>(class_loader)));
+    MutableHandle<mirror::Class> h_class(hs.NewHandle<mirror::Class>(nullptr));
+    size_t num_classes = 0u;
+    size_t num_verified = 0u;
+    for (const DexFile* dex_file : GetDexFiles(soa, h_loader)) {
+      for (uint32_t i = 0; i != dex_file->NumClassDefs(); ++i) {
+        const char* descriptor = dex_file->GetClassDescriptor(dex_file->GetClassDef(i));
+        h_class.Assign(class_linker_->FindClass(soa.Self(), descriptor, h_loader));
+        EXPECT_TRUE(h_class != nullptr) << descriptor;
+        ++num_classes;
+        if (h_class != nullptr && h_class->IsVerified()) {
+          ++num_verified;
+        }
+      }
+    }
+    return std::make_pair(num_classes, num_verified);
+  }
+
+  std::string data_dir_;
+};
+
+TEST_F(OatFileManagerTest, BackgroundVerificationOnSeveralThreads) {
+  runtime_->SetTargetSdkVersion(static_cast<uint32_t>(SdkVersion::kQ));
+
+  jobject class_loader = VerifyInBackground("Interfaces");
+  runtime_->GetOatFileManager().WaitForBackgroundVerificationTasks();
+
+  // All classes were verified by the background tasks and the last one wrote the vdex.
+  std::pair<size_t, size_t> counts = CountVerifiedClasses(class_loader);
+  EXPECT_LT(1u, counts.first);
+  EXPECT_EQ(counts.first, counts.second);
+  EXPECT_TRUE(HasAnonymousVdex(class_loader));
+}
+
+TEST_F(OatFileManagerTest, BackgroundVerificationRacesWithApplicationThread) {
+  runtime_->SetTargetSdkVersion(static_cast<uint32_t>(SdkVersion::kQ));
+
+  jobject class_loader = VerifyInBackground("Interfaces");
+
+  // The application thread verifies the classes it needs itself, waiting for a background
+  // thread already verifying the same class. Both see the same result.
+  {
+    ScopedObjectAccess soa(Thread::Current());
+    StackHandleScope<2> hs(soa.Self());
+    Handle<mirror::ClassLoader> h_loader(
+        hs.NewHandle(soa.Decode<mirror::ClassLoader>(class_loader)));
+    Handle<mirror::Class> h_class(
+        hs.NewHandle(class_linker_->FindClass(soa.Self(), "LInterfaces$B;", h_loader)));
+    ASSERT_TRUE(h_class != nullptr);
+    class_linker_->VerifyClass(soa.Self(), h_class);
+    EXPECT_TRUE(h_class->IsVerified());
+  }
+
+  runtime_->GetOatFileManager().WaitForBackgroundVerificationTasks();
+  std::pair<size_t, size_t> counts = CountVerifiedClasses(class_loader);
+  EXPECT_EQ(counts.first, counts.second);
+  EXPECT_TRUE(HasAnonymousVdex(class_loader));
+}
+
+TEST_F(OatFileManagerTest, NoBackgroundVerificationForLegacyApps) {
+  // Apps targeting an SDK before Q keep verifying classes lazily on first use.
+  runtime_->SetTargetSdkVersion(static_cast<uint32_t>(SdkVersion::kP));
+
+  jobject class_loader = VerifyInBackground("Interfaces");
+  runtime_->GetOatFileManager().WaitForBackgroundVerificationTasks();
+
+  std::pair<size_t, size_t> counts = CountVerifiedClasses(class_loader);
+  EXPECT_LT(1u, counts.first);
+  EXPECT_EQ(0u, counts.second);
+  EXPECT_FALSE(HasAnonymousVdex(class_loader));
+}
+
+}  // namespace art
@@ -191,6 +191,10 @@ std::unique_ptr<RuntimeParser> ParsedOptions::MakeParser(bool ignore_unrecognize
           .WithType<bool>()
           .WithValueMap({{"false", false}, {"true", true}})
           .IntoKey(M::MadviseRandomAccess)
+      .Define("-XX:DexChecksumCache:_")
+          .WithType<bool>()
+          .WithValueMap({{"false", false}, {"true", true}})
+          .IntoKey(M::DexChecksumCache)
       .Define("-Xusejit:_")
           .WithType<bool>()
           .WithValueMap({{"false", false}, {"true", true}})
@@ -358,6 +362,12 @@ std::unique_ptr<RuntimeParser> ParsedOptions::MakeParser(bool ignore_unrecognize
       .Define("-Xverifier-logging-threshold=_")
           .WithType<unsigned int>()
           .IntoKey(M::VerifierLoggingThreshold)
+      .Define("-Xbackground-verification-threads:_")
+          .WithType<unsigned int>()
+          .WithRange(1u, 16u)
+          .IntoKey(M::BackgroundVerificationThreads)
+      .Define("-Xcount-bytecode-pairs")
+          .IntoKey(M::CountBytecodePairs)
       .Define("-XX:FastClassNotFoundException=_")
           .WithType<bool>()
           .WithValueMap({{"false", false}, {"true", true}})
@@ -746,6 +756,7 @@ void ParsedOptions::Usage(const char* fmt, ...) {
   UsageMessage(stream, "  -XX:LargeObjectThreshold=N\n");
   UsageMessage(stream, "  -XX:DumpNativeStackOnSigQuit=booleanvalue\n");
   UsageMessage(stream, "  -XX:MadviseRandomAccess:booleanvalue\n");
+  UsageMessage(stream, "  -XX:DexChecksumCache:booleanvalue\n");
   UsageMessage(stream, "  -XX:SlowDebug={false,true}\n");
   UsageMessage(stream, "  -Xmethod-trace\n");
   UsageMessage(stream, "  -Xmethod-trace-file:filename");
@@ -758,6 +769,7 @@ void ParsedOptions::Usage(const char* fmt, ...) {
   UsageMessage(stream, "  -Xps-min-notification-before-wake:integervalue\n");
   UsageMessage(stream, "  -Xps-max-notification-before-wake:integervalue\n");
   UsageMessage(stream, "  -Xps-profile-path:file-path\n");
+  UsageMessage(stream, "  -Xps-prefetch-startup-pages\n");
   UsageMessage(stream, "  -Xcompiler:filename\n");
   UsageMessage(stream, "  -Xcompiler-option dex2oat-option\n");
   UsageMessage(stream, "  -Ximage-compiler-option dex2oat-option\n");
@@ -772,6 +784,10 @@ void ParsedOptions::Usage(const char* fmt, ...) {
   UsageMessage(stream, "  -X[no]image-dex2oat (Whether to create and use a boot image)\n");
   UsageMessage(stream, "  -Xno-dex-file-fallback "
                        "(Don't fall back to dex files without oat files)\n");
+  UsageMessage(stream, "  -Xbackground-verification-threads:integervalue "
+                       "(Threads verifying dex files without oat files, default 1)\n");
+  UsageMessage(stream, "  -Xcount-bytecode-pairs "
+                       "(Count pairs of interpreted bytecodes, printed on SIGQUIT; use with -Xint)\n");
   UsageMessage(stream, "  -Xplugin:<library.so> "
                        "(Load a runtime plugin, requires -Xexperimental:runtime-plugins)\n");
   UsageMessage(stream, "  -Xexperimental:runtime-plugins"
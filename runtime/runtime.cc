@@ -89,6 +89,7 @@
 #include "image-inl.h"
 #include "instrumentation.h"
 #include "intern_table-inl.h"
+#include "interpreter/bytecode_pair_counter.h"
 #include "interpreter/interpreter.h"
 #include "jit/jit.h"
 #include "jit/jit_code_cache.h"
@@ -189,6 +190,9 @@ static constexpr double kNormalMaxLoadFactor = 0.7;
 // barrier config.
 static constexpr double kExtraDefaultHeapGrowthMultiplier = kUseReadBarrier ? 1.0 : 0.0;
 
+// Memory of free JIT arenas kept mapped across compilations, see MemMapArenaPool::TrimMaps.
+static constexpr size_t kJitArenaPoolMaxRetainedBytes = 2 * MB;
+
 static constexpr const char* kApexBootImageLocation = "/system/framework/apex.art";
 
 Runtime* Runtime::instance_ = nullptr;
@@ -271,6 +275,7 @@ Runtime::Runtime()
       implicit_suspend_checks_(false),
       no_sig_chain_(false),
       force_native_bridge_(false),
+      count_bytecode_pairs_(false),
       is_native_bridge_loaded_(false),
       is_native_debuggable_(false),
       async_exceptions_thrown_(false),
@@ -290,7 +295,8 @@ Runtime::Runtime()
       // Initially assume we perceive jank in case the process state is never updated.
       process_state_(kProcessStateJankPerceptible),
       zygote_no_threads_(false),
-      verifier_logging_threshold_ms_(100) {
+      verifier_logging_threshold_ms_(100),
+      background_verification_threads_(1u) {
   static_assert(Runtime::kCalleeSaveSize ==
                     static_cast<uint32_t>(CalleeSaveType::kLastCalleeSaveType), "Unexpected size");
   CheckConstants();
@@ -298,6 +304,7 @@ Runtime::Runtime()
   std::fill(callee_save_methods_, callee_save_methods_ + arraysize(callee_save_methods_), 0u);
   interpreter::CheckInterpreterAsmConstants();
   callbacks_.reset(new RuntimeCallbacks());
+  hidden_api_cache_.reset(new hiddenapi::ApiListCache());
   for (size_t i = 0; i <= static_cast<size_t>(DeoptimizationKind::kLast); ++i) {
     deoptimization_counts_[i] = 0u;
   }
@@ -931,6 +938,12 @@ bool Runtime::Start() {
                  0);
   }
 
+  if (count_bytecode_pairs_) {
+    ScopedThreadSuspension sts(self, kSuspended);
+    ScopedSuspendAll ssa(__FUNCTION__);
+    interpreter::BytecodePairCounter::Start();
+  }
+
   // In case we have a profile path passed as a command line argument,
   // register the current class path for profiling now. Note that we cannot do
   // this before we create the JIT and having it here is the most convenient way.
@@ -1268,6 +1281,7 @@ bool Runtime::Init(RuntimeArgumentMap&& runtime_options_in) {
 
   no_sig_chain_ = runtime_options.Exists(Opt::NoSigChain);
   force_native_bridge_ = runtime_options.Exists(Opt::ForceNativeBridge);
+  count_bytecode_pairs_ = runtime_options.Exists(Opt::CountBytecodePairs);
 
   Split(runtime_options.GetOrDefault(Opt::CpuAbiList), ',', &cpu_abilist_);
 
@@ -1281,6 +1295,7 @@ bool Runtime::Init(RuntimeArgumentMap&& runtime_options_in) {
   experimental_flags_ = runtime_options.GetOrDefault(Opt::Experimental);
   is_low_memory_mode_ = runtime_options.Exists(Opt::LowMemoryMode);
   madvise_random_access_ = runtime_options.GetOrDefault(Opt::MadviseRandomAccess);
+  ArtDexFileLoader::SetUseChecksumCache(runtime_options.GetOrDefault(Opt::DexChecksumCache));
 
   plugins_ = runtime_options.ReleaseOrDefault(Opt::Plugins);
   agent_specs_ = runtime_options.ReleaseOrDefault(Opt::AgentPath);
@@ -1415,7 +1430,12 @@ bool Runtime::Init(RuntimeArgumentMap&& runtime_options_in) {
     jit_arena_pool_.reset(new MallocArenaPool());
   } else {
     arena_pool_.reset(new MemMapArenaPool(/* low_4gb= */ false));
-    jit_arena_pool_.reset(new MemMapArenaPool(/* low_4gb= */ false, "CompilerMetadata"));
+    // The JIT trims its pool after every compilation. Keep what a compilation needs mapped,
+    // unless memory is tight, so that the next one does not have to page fault it in again.
+    jit_arena_pool_.reset(new MemMapArenaPool(
+        /* low_4gb= */ false,
+        "CompilerMetadata",
+        /* max_retained_bytes= */ is_low_memory_mode_ ? 0u : kJitArenaPoolMaxRetainedBytes));
   }
 
   if (IsAotCompiler() && Is64BitInstructionSet(kRuntimeISA)) {
@@ -1474,6 +1494,8 @@ bool Runtime::Init(RuntimeArgumentMap&& runtime_options_in) {
   }
 
   verifier_logging_threshold_ms_ = runtime_options.GetOrDefault(Opt::VerifierLoggingThreshold);
+  background_verification_threads_ =
+      runtime_options.GetOrDefault(Opt::BackgroundVerificationThreads);
 
   std::string error_msg;
   java_vm_ = JavaVMExt::Create(this, runtime_options, &error_msg);
@@ -1939,6 +1961,7 @@ void Runtime::DumpForSigQuit(std::ostream& os) {
   }
   DumpDeoptimizations(os);
   TrackedAllocators::Dump(os);
+  interpreter::BytecodePairCounter::Dump(os);
   os << "\n";
 
   thread_list_->DumpForSigQuit(os);
@@ -2649,6 +2672,12 @@ bool Runtime::IsVerificationSoftFail() const {
   return verify_ == verifier::VerifyMode::kSoftFail;
 }
 
+void Runtime::SetHiddenApiExemptions(const std::vector<std::string>& exemptions) {
+  hidden_api_exemptions_ = exemptions;
+  // Members previously found not to be exempted may match the new exemptions.
+  hidden_api_cache_->ResetExemptionChecks();
+}
+
 bool Runtime::IsAsyncDeoptimizeable(uintptr_t code) const {
   // We only support async deopt (ie the compiled code is not explicitly asking for
   // deopt, but something else like the debugger) in debuggable JIT code.
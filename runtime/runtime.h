@@ -52,6 +52,7 @@ class Heap;
 }  // namespace gc
 
 namespace hiddenapi {
+class ApiListCache;
 enum class EnforcementPolicy;
 }  // namespace hiddenapi
 
@@ -565,14 +566,16 @@ class Runtime {
     return core_platform_api_policy_;
   }
 
-  void SetHiddenApiExemptions(const std::vector<std::string>& exemptions) {
-    hidden_api_exemptions_ = exemptions;
-  }
+  void SetHiddenApiExemptions(const std::vector<std::string>& exemptions);
 
   const std::vector<std::string>& GetHiddenApiExemptions() {
     return hidden_api_exemptions_;
   }
 
+  hiddenapi::ApiListCache* GetHiddenApiCache() const {
+    return hidden_api_cache_.get();
+  }
+
   void SetDedupeHiddenApiWarnings(bool value) {
     dedupe_hidden_api_warnings_ = value;
   }
@@ -835,6 +838,11 @@ class Runtime {
     return verifier_logging_threshold_ms_;
   }
 
+  // Number of threads verifying dex files without verification results in the background.
+  uint32_t GetBackgroundVerificationThreads() const {
+    return background_verification_threads_;
+  }
+
   // Atomically delete the thread pool if the reference count is 0.
   bool DeleteThreadPool() REQUIRES(!Locks::runtime_thread_pool_lock_);
 
@@ -1086,6 +1094,9 @@ class Runtime {
   // Force the use of native bridge even if the app ISA matches the runtime ISA.
   bool force_native_bridge_;
 
+  // Whether to count pairs of interpreted bytecodes, see interpreter::BytecodePairCounter.
+  bool count_bytecode_pairs_;
+
   // Whether or not a native bridge has been loaded.
   //
   // The native bridge allows running native code compiled for a foreign ISA. The way it works is,
@@ -1148,6 +1159,9 @@ class Runtime {
   // as if whitelisted.
   std::vector<std::string> hidden_api_exemptions_;
 
+  // Hidden API flags of boot class path members, decoded on the first access check.
+  std::unique_ptr<hiddenapi::ApiListCache> hidden_api_cache_;
+
   // Do not warn about the same hidden API access violation twice.
   // This is only used for testing.
   bool dedupe_hidden_api_warnings_;
@@ -1206,6 +1220,8 @@ class Runtime {
 
   uint32_t verifier_logging_threshold_ms_;
 
+  uint32_t background_verification_threads_;
+
   bool load_app_image_startup_cache_ = false;
 
   // If startup has completed, must happen at most once.
@@ -1791,7 +1791,20 @@ class Thread {
   // True if the thread is some form of runtime thread (ex, GC or JIT).
   bool is_runtime_thread_;
 
+  // Chunks of LinearAllocs from which this thread makes small allocations without locking,
+  // most recently used first. A thread linking classes of several class loaders keeps one
+  // chunk per allocator rather than abandoning the rest of its chunk on every switch.
+  struct LinearAllocChunk {
+    // The owner is identified by LinearAlloc::id_, 0 meaning no chunk.
+    uint64_t owner_id = 0u;
+    uint8_t* pos = nullptr;
+    uint8_t* end = nullptr;
+  };
+  static constexpr size_t kNumLinearAllocChunks = 4u;
+  LinearAllocChunk linear_alloc_chunks_[kNumLinearAllocChunks];
+
   friend class Dbg;  // For SetStateUnsafe.
+  friend class LinearAlloc;  // For the thread-local LinearAlloc chunks.
   friend class gc::collector::SemiSpace;  // For getting stack traces.
   friend class Runtime;  // For CreatePeer.
   friend class QuickExceptionHandler;  // For dumping the stack.
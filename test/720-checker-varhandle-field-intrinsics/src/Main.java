@@ -0,0 +1,223 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import java.lang.invoke.MethodHandles;
+import java.lang.invoke.VarHandle;
+import java.lang.invoke.WrongMethodTypeException;
+
+public class Main {
+  int intField;
+  long longField;
+  String stringField;
+  static int staticIntField;
+  static Object staticObjectField;
+
+  static final VarHandle INT;
+  static final VarHandle LONG;
+  static final VarHandle STRING;
+  static final VarHandle STATIC_INT;
+  static final VarHandle STATIC_OBJECT;
+  static final VarHandle INT_ARRAY;
+
+  static {
+    try {
+      MethodHandles.Lookup lookup = MethodHandles.lookup();
+      INT = lookup.findVarHandle(Main.class, "intField", int.class);
+      LONG = lookup.findVarHandle(Main.class, "longField", long.class);
+      STRING = lookup.findVarHandle(Main.class, "stringField", String.class);
+      STATIC_INT = lookup.findStaticVarHandle(Main.class, "staticIntField", int.class);
+      STATIC_OBJECT = lookup.findStaticVarHandle(Main.class, "staticObjectField", Object.class);
+      INT_ARRAY = MethodHandles.arrayElementVarHandle(int[].class);
+    } catch (Exception e) {
+      throw new Error(e);
+    }
+  }
+
+  //
+  // Fast paths: static and instance fields accessed with the exact variable type.
+  //
+
+  /// CHECK-START: int Main.$noinline$get(Main) builder (after)
+  /// CHECK: InvokePolymorphic intrinsic:VarHandleGet
+  private static int $noinline$get(Main m) {
+    return (int) INT.get(m);
+  }
+
+  /// CHECK-START: void Main.$noinline$set(Main, int) builder (after)
+  /// CHECK: InvokePolymorphic intrinsic:VarHandleSet
+  private static void $noinline$set(Main m, int value) {
+    INT.set(m, value);
+  }
+
+  /// CHECK-START: long Main.$noinline$getOpaque(Main) builder (after)
+  /// CHECK: InvokePolymorphic intrinsic:VarHandleGetOpaque
+  private static long $noinline$getOpaque(Main m) {
+    return (long) LONG.getOpaque(m);
+  }
+
+  /// CHECK-START: void Main.$noinline$setOpaque(Main, long) builder (after)
+  /// CHECK: InvokePolymorphic intrinsic:VarHandleSetOpaque
+  private static void $noinline$setOpaque(Main m, long value) {
+    LONG.setOpaque(m, value);
+  }
+
+  /// CHECK-START: java.lang.String Main.$noinline$getAcquire(Main) builder (after)
+  /// CHECK: InvokePolymorphic intrinsic:VarHandleGetAcquire
+  /// CHECK: CheckCast
+  private static String $noinline$getAcquire(Main m) {
+    return (String) STRING.getAcquire(m);
+  }
+
+  /// CHECK-START: void Main.$noinline$setRelease(Main, java.lang.String) builder (after)
+  /// CHECK: InvokePolymorphic intrinsic:VarHandleSetRelease
+  private static void $noinline$setRelease(Main m, String value) {
+    STRING.setRelease(m, value);
+  }
+
+  /// CHECK-START: int Main.$noinline$getVolatileStatic() builder (after)
+  /// CHECK: InvokePolymorphic intrinsic:VarHandleGetVolatile
+  private static int $noinline$getVolatileStatic() {
+    return (int) STATIC_INT.getVolatile();
+  }
+
+  /// CHECK-START: void Main.$noinline$setVolatileStatic(int) builder (after)
+  /// CHECK: InvokePolymorphic intrinsic:VarHandleSetVolatile
+  private static void $noinline$setVolatileStatic(int value) {
+    STATIC_INT.setVolatile(value);
+  }
+
+  /// CHECK-START: java.lang.Object Main.$noinline$getStaticObject() builder (after)
+  /// CHECK: InvokePolymorphic intrinsic:VarHandleGet
+  private static Object $noinline$getStaticObject() {
+    return (Object) STATIC_OBJECT.get();
+  }
+
+  /// CHECK-START: void Main.$noinline$setStaticObject(java.lang.Object) builder (after)
+  /// CHECK: InvokePolymorphic intrinsic:VarHandleSet
+  private static void $noinline$setStaticObject(Object value) {
+    STATIC_OBJECT.set(value);
+  }
+
+  //
+  // Slow paths: the checks of the fast path fail and the runtime call handles the access.
+  //
+
+  // The variable is an int, the call site asks for a long: converted by the runtime.
+  private static long $noinline$getIntAsLong(Main m) {
+    return (long) INT.get(m);
+  }
+
+  // The holder is passed as an Object, which is checked at runtime.
+  private static int $noinline$getFromObject(Object o) {
+    return (int) INT.get(o);
+  }
+
+  // The value is passed as an Object, which is checked against String at runtime.
+  private static void $noinline$setStringFromObject(Main m, Object value) {
+    STRING.set(m, value);
+  }
+
+  // Array elements have two coordinates and always use the runtime call.
+  private static int $noinline$getArrayElement(int[] array, int index) {
+    return (int) INT_ARRAY.get(array, index);
+  }
+
+  private static void testFastPaths() {
+    Main m = new Main();
+    $noinline$set(m, 42);
+    assertEquals(42, m.intField);
+    assertEquals(42, $noinline$get(m));
+    $noinline$setOpaque(m, 0x123456789abcdefL);
+    assertEquals(0x123456789abcdefL, m.longField);
+    assertEquals(0x123456789abcdefL, $noinline$getOpaque(m));
+    $noinline$setRelease(m, "hello");
+    assertEquals("hello", m.stringField);
+    assertEquals("hello", $noinline$getAcquire(m));
+    $noinline$setRelease(m, null);
+    assertEquals(null, $noinline$getAcquire(m));
+    $noinline$setVolatileStatic(-7);
+    assertEquals(-7, staticIntField);
+    assertEquals(-7, $noinline$getVolatileStatic());
+    Object o = new Object();
+    $noinline$setStaticObject(o);
+    assertEquals(o, staticObjectField);
+    assertEquals(o, $noinline$getStaticObject());
+  }
+
+  private static void testSlowPaths() {
+    Main m = new Main();
+    m.intField = 17;
+    assertEquals(17L, $noinline$getIntAsLong(m));
+    assertEquals(17, $noinline$getFromObject(m));
+    $noinline$setStringFromObject(m, "world");
+    assertEquals("world", m.stringField);
+    assertEquals(3, $noinline$getArrayElement(new int[] { 1, 2, 3 }, 2));
+
+    try {
+      $noinline$get(null);
+      throw new Error("Expected NullPointerException");
+    } catch (NullPointerException expected) {
+    }
+    try {
+      $noinline$set(null, 1);
+      throw new Error("Expected NullPointerException");
+    } catch (NullPointerException expected) {
+    }
+    try {
+      $noinline$getFromObject(new Object());
+      throw new Error("Expected ClassCastException");
+    } catch (ClassCastException expected) {
+    }
+    try {
+      $noinline$setStringFromObject(m, Integer.valueOf(1));
+      throw new Error("Expected ClassCastException");
+    } catch (ClassCastException expected) {
+    }
+    assertEquals("world", m.stringField);
+    try {
+      $noinline$getArrayElement(new int[1], 1);
+      throw new Error("Expected ArrayIndexOutOfBoundsException");
+    } catch (ArrayIndexOutOfBoundsException expected) {
+    }
+    try {
+      // Wrong value type for the variable, rejected by the runtime.
+      INT.set(m, "string");
+      throw new Error("Expected WrongMethodTypeException");
+    } catch (WrongMethodTypeException expected) {
+    }
+  }
+
+  private static void assertEquals(long expected, long actual) {
+    if (expected != actual) {
+      throw new Error("Expected " + expected + ", got " + actual);
+    }
+  }
+
+  private static void assertEquals(Object expected, Object actual) {
+    if (expected != actual && (expected == null || !expected.equals(actual))) {
+      throw new Error("Expected " + expected + ", got " + actual);
+    }
+  }
+
+  public static void main(String[] args) {
+    // Run enough iterations for the JIT to compile the accessors when it is enabled.
+    for (int i = 0; i < 1000; ++i) {
+      testFastPaths();
+      testSlowPaths();
+    }
+    System.out.println("passed");
+  }
+}
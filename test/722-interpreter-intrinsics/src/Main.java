@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import java.lang.ref.WeakReference;
+import java.lang.reflect.Field;
+import java.util.Arrays;
+import sun.misc.Unsafe;
+
+public class Main {
+  int intVar;
+  long longVar;
+  Object objectVar;
+
+  public static void main(String[] args) throws Exception {
+    testArrayCopy();
+    System.out.println("arraycopy passed");
+    testUnsafeCAS();
+    System.out.println("Unsafe CAS passed");
+    testGetReferent();
+    System.out.println("Reference.getReferent passed");
+  }
+
+  private static void testArrayCopy() {
+    // Copies between arrays of the same class.
+    char[] chars = { 'a', 'b', 'c', 'd', 'e' };
+    char[] charsCopy = new char[5];
+    System.arraycopy(chars, 1, charsCopy, 2, 3);
+    assertEquals(Arrays.toString(new char[] { 0, 0, 'b', 'c', 'd' }), Arrays.toString(charsCopy));
+
+    int[] ints = { 1, 2, 3, 4, 5 };
+    System.arraycopy(ints, 0, ints, 1, 4);  // Overlapping, forward.
+    assertEquals("[1, 1, 2, 3, 4]", Arrays.toString(ints));
+    System.arraycopy(ints, 1, ints, 0, 4);  // Overlapping, backward.
+    assertEquals("[1, 2, 3, 4, 4]", Arrays.toString(ints));
+
+    long[] longs = { 1L << 40, 2L << 40 };
+    long[] longsCopy = new long[2];
+    System.arraycopy(longs, 0, longsCopy, 0, 2);
+    assertEquals(Arrays.toString(longs), Arrays.toString(longsCopy));
+
+    byte[] bytes = { 1, 2, 3 };
+    byte[] bytesCopy = new byte[3];
+    System.arraycopy(bytes, 0, bytesCopy, 0, 0);  // Empty copy.
+    assertEquals("[0, 0, 0]", Arrays.toString(bytesCopy));
+
+    String[] strings = { "x", "y" };
+    String[] stringsCopy = new String[2];
+    System.arraycopy(strings, 0, stringsCopy, 0, 2);
+    assertEquals("[x, y]", Arrays.toString(stringsCopy));
+
+    // Copies between different classes go to the native method.
+    Object[] objects = new Object[2];
+    System.arraycopy(strings, 0, objects, 0, 2);
+    assertEquals("[x, y]", Arrays.toString(objects));
+    Object[] mixed = { "z", Integer.valueOf(1) };
+    try {
+      System.arraycopy(mixed, 0, stringsCopy, 0, 2);
+      throw new Error("Expected ArrayStoreException");
+    } catch (ArrayStoreException expected) {
+      // The first element is copied before the failing one.
+      assertEquals("[z, y]", Arrays.toString(stringsCopy));
+    }
+    try {
+      System.arraycopy(ints, 0, longs, 0, 1);
+      throw new Error("Expected ArrayStoreException");
+    } catch (ArrayStoreException expected) {
+    }
+    try {
+      System.arraycopy(new Object(), 0, objects, 0, 1);
+      throw new Error("Expected ArrayStoreException");
+    } catch (ArrayStoreException expected) {
+    }
+
+    // Null arguments.
+    try {
+      System.arraycopy(null, 0, ints, 0, 1);
+      throw new Error("Expected NullPointerException");
+    } catch (NullPointerException expected) {
+    }
+    try {
+      System.arraycopy(chars, 0, null, 0, 1);
+      throw new Error("Expected NullPointerException");
+    } catch (NullPointerException expected) {
+    }
+
+    // Out of bounds ranges do not copy anything.
+    int[][] outOfBounds = {
+      { -1, 0, 1 },
+      { 0, -1, 1 },
+      { 0, 0, -1 },
+      { 4, 0, 2 },
+      { 0, 4, 2 },
+      { 0, 0, 6 },
+      { Integer.MAX_VALUE, 0, 1 },
+      { 1, 1, Integer.MAX_VALUE },
+    };
+    for (int[] range : outOfBounds) {
+      int[] dst = new int[5];
+      try {
+        System.arraycopy(ints, range[0], dst, range[1], range[2]);
+        throw new Error("Expected ArrayIndexOutOfBoundsException for " + Arrays.toString(range));
+      } catch (ArrayIndexOutOfBoundsException expected) {
+      }
+      assertEquals("[0, 0, 0, 0, 0]", Arrays.toString(dst));
+      char[] charDst = new char[5];
+      try {
+        System.arraycopy(chars, range[0], charDst, range[1], range[2]);
+        throw new Error("Expected ArrayIndexOutOfBoundsException for " + Arrays.toString(range));
+      } catch (ArrayIndexOutOfBoundsException expected) {
+      }
+      assertEquals(Arrays.toString(new char[5]), Arrays.toString(charDst));
+    }
+  }
+
+  private static void testUnsafeCAS() throws Exception {
+    Unsafe unsafe = getUnsafe();
+    Main m = new Main();
+    long intOffset = unsafe.objectFieldOffset(Main.class.getDeclaredField("intVar"));
+    long longOffset = unsafe.objectFieldOffset(Main.class.getDeclaredField("longVar"));
+    long objectOffset = unsafe.objectFieldOffset(Main.class.getDeclaredField("objectVar"));
+
+    assertEquals(true, unsafe.compareAndSwapInt(m, intOffset, 0, 42));
+    assertEquals(42, m.intVar);
+    assertEquals(false, unsafe.compareAndSwapInt(m, intOffset, 0, 43));
+    assertEquals(42, m.intVar);
+
+    long longValue = 0x123456789abcdefL;
+    assertEquals(true, unsafe.compareAndSwapLong(m, longOffset, 0L, longValue));
+    assertEquals(longValue, m.longVar);
+    assertEquals(false, unsafe.compareAndSwapLong(m, longOffset, longValue + 1, 0L));
+    assertEquals(longValue, m.longVar);
+
+    Object o1 = new Object();
+    Object o2 = new Object();
+    assertEquals(true, unsafe.compareAndSwapObject(m, objectOffset, null, o1));
+    assertEquals(o1, m.objectVar);
+    assertEquals(false, unsafe.compareAndSwapObject(m, objectOffset, o2, null));
+    assertEquals(o1, m.objectVar);
+    assertEquals(true, unsafe.compareAndSwapObject(m, objectOffset, o1, null));
+    assertEquals(null, m.objectVar);
+
+    // Array elements.
+    int[] ints = { 1, 2, 3 };
+    long intElement = unsafe.arrayBaseOffset(int[].class) + 2 * unsafe.arrayIndexScale(int[].class);
+    assertEquals(true, unsafe.compareAndSwapInt(ints, intElement, 3, 4));
+    assertEquals("[1, 2, 4]", Arrays.toString(ints));
+  }
+
+  private static void testGetReferent() {
+    Object referent = new Object();
+    WeakReference<Object> ref = new WeakReference<>(referent);
+    assertEquals(referent, ref.get());
+    // The referent is still strongly reachable.
+    Runtime.getRuntime().gc();
+    assertEquals(referent, ref.get());
+    ref.clear();
+    assertEquals(null, ref.get());
+    WeakReference<Object> nullRef = new WeakReference<>(null);
+    assertEquals(null, nullRef.get());
+  }
+
+  private static Unsafe getUnsafe() throws Exception {
+    Field f = Unsafe.class.getDeclaredField("theUnsafe");
+    f.setAccessible(true);
+    return (Unsafe) f.get(null);
+  }
+
+  private static void assertEquals(Object expected, Object actual) {
+    if (expected == null ? actual != null : !expected.equals(actual)) {
+      throw new Error("Expected " + expected + ", got " + actual);
+    }
+  }
+
+  private static void assertEquals(long expected, long actual) {
+    if (expected != actual) {
+      throw new Error("Expected " + expected + ", got " + actual);
+    }
+  }
+
+  private static void assertEquals(boolean expected, boolean actual) {
+    if (expected != actual) {
+      throw new Error("Expected " + expected + ", got " + actual);
+    }
+  }
+}
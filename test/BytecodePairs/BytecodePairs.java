@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+class BytecodePairs {
+    static int callee(int x) {
+        return x + 1;
+    }
+
+    // The invoke is followed by a move-result.
+    static int caller(int x) {
+        return callee(x) * 3;
+    }
+
+    // The packed switch is followed by its payload at the end of the code item.
+    static int select(int x) {
+        switch (x) {
+            case 0: return 10;
+            case 1: return 21;
+            case 2: return 32;
+            case 3: return 43;
+            case 4: return 54;
+            case 5: return 65;
+            case 6: return 76;
+            case 7: return 87;
+            default: return 98;
+        }
+    }
+}
@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// CompiledMethodsA and CompiledMethodsB only differ in the code of changed().
+class CompiledMethods {
+    static int unchanged(int value) {
+        return value * 3 + 1;
+    }
+
+    static int changed(int value) {
+        return value + 2;
+    }
+
+    String greeting() {
+        return "Hello";
+    }
+
+    static int readSecond(Fields fields) {
+        return fields.second;
+    }
+}